@@ -3,6 +3,8 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
+#include <functional>
 
 #ifdef _WIN32
     #ifdef PRJ1_EXPORTS
@@ -55,6 +57,11 @@ struct Config {
     std::string endpoint;   // Custom endpoint (optional, empty for default)
     int timeout_ms;         // Timeout for receive operations in milliseconds
     bool enable_logging;    // Enable internal logging
+    bool last_value_cache;  // PUB/SUB server: replay the latest message per topic to new subscribers
+    char topic_delimiter;   // Ends the topic part of a published message (whole message if absent)
+    bool conflate_topics;   // PUB/SUB server: keep only the newest unsent message per topic when subscribers fall behind
+    int send_hwm;           // Outgoing queue limit in messages (0 for the ZeroMQ default)
+    int pipeline_credit;    // PUSH/PULL: credit-based flow control, worker in-flight limit (0 disables)
     
     // Constructor with defaults
     Config() 
@@ -63,9 +70,17 @@ struct Config {
         , endpoint("")
         , timeout_ms(5000)
         , enable_logging(false)
+        , last_value_cache(false)
+        , topic_delimiter(':')
+        , conflate_topics(false)
+        , send_hwm(0)
+        , pipeline_credit(0)
     {}
 };
 
+// Callback invoked by DispatchMessage() with the matched topic and the full message
+using TopicHandler = std::function<void(const std::string& topic, const std::string& message)>;
+
 // Forward declaration of implementation class (PIMPL pattern for ABI stability)
 class ZMQWrapperImpl;
 
@@ -111,8 +126,15 @@ public:
      * 
      * Thread-safe. Behavior depends on the pattern:
      * - REQ/REP: Must alternate with ReceiveMessage() in REQ mode
-     * - PUB/SUB: Publishes to all subscribers
-     * - PUSH/PULL: Pushes to next available worker
+     * - PUB/SUB: Publishes to all subscribers; with last_value_cache the
+     *   message also becomes the value replayed to later subscribers of its topic.
+     *   With conflate_topics, a message that cannot be queued because a
+     *   subscriber is full replaces any older unsent message of its topic
+     *   and is delivered once the subscriber catches up; topics are
+     *   conflated independently and other send errors are returned
+     * - PUSH/PULL: Pushes to next available worker; with pipeline_credit
+     *   only to workers that have credit left, waiting up to timeout_ms
+     *   for a credit grant (ERROR_TIMEOUT if none arrives)
      */
     ErrorCode SendMessage(const std::string& message);
     
@@ -160,6 +182,64 @@ public:
      * Must be called after Init() but before ReceiveMessage().
      */
     ErrorCode Subscribe(const std::string& topic = "");
+    
+    /**
+     * @brief Subscribe to several topics at once
+     * @param topics Topic prefixes to subscribe to
+     * @return ErrorCode indicating success or failure
+     * 
+     * Only valid in CLIENT mode with PUB_SUB pattern. As in ZeroMQ, every
+     * occurrence of a topic counts as one subscription that needs its own
+     * unsubscribe; only a topic's first subscription is sent upstream. The
+     * whole batch is applied under a single lock and either succeeds or is
+     * rolled back completely.
+     */
+    ErrorCode SubscribeBatch(const std::vector<std::string>& topics);
+    
+    /**
+     * @brief Remove a subscription added by Subscribe() or SubscribeBatch()
+     * @param topic Topic prefix to unsubscribe from (empty for the catch-all)
+     * @return ErrorCode indicating success or failure
+     * 
+     * Only valid in CLIENT mode with PUB_SUB pattern. Removes one
+     * subscription of the topic; messages keep arriving until every
+     * subscription is removed. Unsubscribing from a topic that is not
+     * subscribed is a no-op.
+     */
+    ErrorCode Unsubscribe(const std::string& topic = "");
+    
+    /**
+     * @brief Unsubscribe from several topics at once
+     * @param topics Topic prefixes to unsubscribe from
+     * @return ErrorCode indicating success or failure
+     * 
+     * Counterpart of SubscribeBatch(); each occurrence removes one
+     * subscription, only topics losing their last subscription are sent
+     * upstream, and a failed batch is rolled back completely.
+     */
+    ErrorCode UnsubscribeBatch(const std::vector<std::string>& topics);
+    
+    /**
+     * @brief Register a handler for messages starting with a topic prefix
+     * @param topic Topic prefix the handler is responsible for
+     * @param handler Callback to invoke, or an empty function to remove it
+     * @return ErrorCode indicating success or failure
+     * 
+     * Only valid in CLIENT mode with PUB_SUB pattern. Registering a handler
+     * does not subscribe to the topic.
+     */
+    ErrorCode SetTopicHandler(const std::string& topic, TopicHandler handler);
+    
+    /**
+     * @brief Receive one message and pass it to the matching topic handler
+     * @return ErrorCode indicating success or failure
+     * 
+     * Blocks like ReceiveMessage(). The handler registered for the longest
+     * topic prefix of the message is chosen in O(topic length) and invoked
+     * outside the internal lock, so it may call back into the wrapper.
+     * Messages without a matching handler are dropped.
+     */
+    ErrorCode DispatchMessage();
 
 private:
     ZMQWrapperImpl* pImpl;  // PIMPL idiom for implementation hiding
@@ -662,6 +662,18 @@ ZMQ_EXPORT void zmq_threadclose (void *thread_);
 #define ZMQ_NORM_NUM_PARITY 122
 #define ZMQ_NORM_NUM_AUTOPARITY 123
 #define ZMQ_NORM_PUSH 124
+#define ZMQ_LB_STRATEGY 125
+#define ZMQ_LB_WEIGHT 126
+#define ZMQ_WRITEV_THRESHOLD 127
+#define ZMQ_ZEROCOPY_THRESHOLD 128
+#define ZMQ_UDP_GSO 129
+#define ZMQ_UDP_GRO 130
+#define ZMQ_XPUB_MATCHER 131
+#define ZMQ_XPUB_FANOUT_THREADS 132
+#define ZMQ_CORK 133
+#define ZMQ_CORK_MSGS 134
+#define ZMQ_CORK_BYTES 135
+#define ZMQ_CORK_IVL 136
 
 /*  DRAFT ZMQ_NORM_MODE options                                               */
 #define ZMQ_NORM_FIXED 0
@@ -670,6 +682,16 @@ ZMQ_EXPORT void zmq_threadclose (void *thread_);
 #define ZMQ_NORM_CCE 3
 #define ZMQ_NORM_CCE_ECNONLY 4
 
+/*  DRAFT ZMQ_LB_STRATEGY options                                             */
+#define ZMQ_LB_ROUND_ROBIN 0
+#define ZMQ_LB_LEAST_LOADED 1
+#define ZMQ_LB_WEIGHTED 2
+#define ZMQ_LB_POWER_OF_TWO 3
+
+/*  DRAFT ZMQ_XPUB_MATCHER options                                            */
+#define ZMQ_XPUB_MATCHER_MTRIE 0
+#define ZMQ_XPUB_MATCHER_RADIX 1
+
 /*  DRAFT ZMQ_RECONNECT_STOP options                                          */
 #define ZMQ_RECONNECT_STOP_CONN_REFUSED 0x1
 #define ZMQ_RECONNECT_STOP_HANDSHAKE_FAILED 0x2
@@ -677,6 +699,11 @@ ZMQ_EXPORT void zmq_threadclose (void *thread_);
 
 /*  DRAFT Context options                                                     */
 #define ZMQ_ZERO_COPY_RECV 10
+#define ZMQ_MSG_POOL 11
+#define ZMQ_PIPE_CHUNK_POOL 12
+#define ZMQ_IO_THREAD_SPIN 13
+#define ZMQ_IO_THREAD_AFFINITY 14
+#define ZMQ_IO_THREAD_PACKAGE 15
 
 /*  DRAFT Context methods.                                                    */
 ZMQ_EXPORT int zmq_ctx_set_ext (void *context_,
@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "../include/zmq.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifdef ZMQ_BUILD_DRAFT_API
+
+//  Time a PUB socket spends in zmq_send for each message when it has many
+//  subscribers, with and without ZMQ_XPUB_FANOUT_THREADS. The subscribers
+//  are inproc SUB sockets that do not read, so that only the publishing
+//  side is measured; the message count stays below the high-water mark.
+
+typedef std::chrono::steady_clock clock_type;
+
+static int message_count = 200;
+static int message_size = 64;
+
+static void fail (const char *what_)
+{
+    std::printf ("error in %s: %s\n", what_, zmq_strerror (zmq_errno ()));
+    std::exit (1);
+}
+
+static double run (int subscribers_, int threads_)
+{
+    void *ctx = zmq_ctx_new ();
+    if (!ctx)
+        fail ("zmq_ctx_new");
+    if (zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, subscribers_ + 16) != 0)
+        fail ("zmq_ctx_set");
+
+    //  XPUB so that the subscriptions can be waited for.
+    void *pub = zmq_socket (ctx, ZMQ_XPUB);
+    if (!pub)
+        fail ("zmq_socket");
+    const int verbose = 1;
+    if (zmq_setsockopt (pub, ZMQ_XPUB_FANOUT_THREADS, &threads_,
+                        sizeof threads_)
+          != 0
+        || zmq_setsockopt (pub, ZMQ_XPUB_VERBOSE, &verbose, sizeof verbose)
+             != 0)
+        fail ("zmq_setsockopt");
+    if (zmq_bind (pub, "inproc://benchmark_fanout") != 0)
+        fail ("zmq_bind");
+
+    std::vector<void *> subs;
+    for (int i = 0; i != subscribers_; i++) {
+        void *sub = zmq_socket (ctx, ZMQ_SUB);
+        if (!sub)
+            fail ("zmq_socket");
+        if (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0) != 0)
+            fail ("zmq_setsockopt");
+        if (zmq_connect (sub, "inproc://benchmark_fanout") != 0)
+            fail ("zmq_connect");
+        subs.push_back (sub);
+    }
+    for (int i = 0; i != subscribers_; i++) {
+        char subscription[1];
+        if (zmq_recv (pub, subscription, sizeof subscription, 0) != 1)
+            fail ("zmq_recv");
+    }
+
+    std::vector<char> data (message_size, 'x');
+    const clock_type::time_point start = clock_type::now ();
+    for (int i = 0; i != message_count; i++)
+        if (zmq_send (pub, &data[0], data.size (), 0)
+            != static_cast<int> (data.size ()))
+            fail ("zmq_send");
+    const double elapsed_us =
+      std::chrono::duration<double, std::micro> (clock_type::now () - start)
+        .count ();
+
+    const int linger = 0;
+    for (size_t i = 0; i != subs.size (); i++) {
+        zmq_setsockopt (subs[i], ZMQ_LINGER, &linger, sizeof linger);
+        zmq_close (subs[i]);
+    }
+    zmq_setsockopt (pub, ZMQ_LINGER, &linger, sizeof linger);
+    zmq_close (pub);
+    zmq_ctx_term (ctx);
+
+    return elapsed_us / message_count;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1)
+        message_count = std::atoi (argv[1]);
+    if (argc > 2)
+        message_size = std::atoi (argv[2]);
+    if (argc > 3 || message_count <= 0 || message_count >= 1000
+        || message_size <= 0) {
+        std::printf ("usage: benchmark_fanout [message-count < 1000] "
+                     "[message-size]\n");
+        return 1;
+    }
+
+    const int subscribers[] = {100, 1000, 5000};
+    const int threads[] = {0, 1, 3};
+
+    std::printf ("%d messages of %d bytes, us per zmq_send\n", message_count,
+                 message_size);
+    std::printf ("subscribers");
+    for (size_t j = 0; j != sizeof threads / sizeof threads[0]; j++)
+        std::printf ("  %d helpers", threads[j]);
+    std::printf ("\n");
+    for (size_t i = 0; i != sizeof subscribers / sizeof subscribers[0]; i++) {
+        std::printf ("%11d", subscribers[i]);
+        for (size_t j = 0; j != sizeof threads / sizeof threads[0]; j++)
+            std::printf ("  %9.1f", run (subscribers[i], threads[j]));
+        std::printf ("\n");
+    }
+    return 0;
+}
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "../include/zmq.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifdef ZMQ_BUILD_DRAFT_API
+
+//  PUSH socket load balancing over workers of unequal speed. Three fast
+//  workers and one slow worker share the stream; each strategy is run
+//  once flat out to measure throughput and once paced below aggregate
+//  capacity to measure end-to-end latency (queueing plus service).
+
+typedef std::chrono::steady_clock clock_type;
+
+const int nworkers = 4;
+const int service_us[nworkers] = {200, 200, 200, 1000};
+const int weights[nworkers] = {5, 5, 5, 1};
+
+//  Fraction of aggregate worker capacity used by the paced run.
+const double paced_load = 0.7;
+
+static int message_count = 20000;
+static int hwm = 16;
+
+struct worker_t
+{
+    int id;
+    void *ctx;
+    std::atomic<int> *remaining;
+    std::vector<int64_t> latencies;
+};
+
+static void fail (const char *what_)
+{
+    std::printf ("error in %s: %s\n", what_, zmq_strerror (zmq_errno ()));
+    std::exit (1);
+}
+
+static int64_t now_ns ()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+             clock_type::now ().time_since_epoch ())
+      .count ();
+}
+
+static void worker_routine (worker_t *worker_)
+{
+    void *s = zmq_socket (worker_->ctx, ZMQ_PULL);
+    if (!s)
+        fail ("zmq_socket");
+    int timeout = 10;
+    if (zmq_setsockopt (s, ZMQ_RCVTIMEO, &timeout, sizeof timeout) != 0
+        || zmq_setsockopt (s, ZMQ_RCVHWM, &hwm, sizeof hwm) != 0)
+        fail ("zmq_setsockopt");
+    char endpoint[32];
+    std::snprintf (endpoint, sizeof endpoint, "inproc://lb-%d", worker_->id);
+    if (zmq_bind (s, endpoint) != 0)
+        fail ("zmq_bind");
+
+    while (worker_->remaining->load () > 0) {
+        int64_t sent;
+        if (zmq_recv (s, &sent, sizeof sent, 0) != sizeof sent)
+            continue;
+
+        //  Sleep rather than spin so the benchmark stays meaningful when
+        //  workers outnumber cores.
+        std::this_thread::sleep_for (
+          std::chrono::microseconds (service_us[worker_->id]));
+        worker_->latencies.push_back (now_ns () - sent);
+        --*worker_->remaining;
+    }
+
+    zmq_close (s);
+}
+
+static void run (int strategy_, const char *name_, double rate_)
+{
+    void *ctx = zmq_ctx_new ();
+    if (!ctx)
+        fail ("zmq_ctx_new");
+
+    std::atomic<int> remaining (message_count);
+    std::vector<worker_t> workers (nworkers);
+    std::vector<std::thread> threads;
+    for (int i = 0; i != nworkers; i++) {
+        workers[i].id = i;
+        workers[i].ctx = ctx;
+        workers[i].remaining = &remaining;
+        workers[i].latencies.reserve (message_count);
+        threads.push_back (std::thread (worker_routine, &workers[i]));
+    }
+
+    void *s = zmq_socket (ctx, ZMQ_PUSH);
+    if (!s)
+        fail ("zmq_socket");
+    if (zmq_setsockopt (s, ZMQ_LB_STRATEGY, &strategy_, sizeof strategy_)
+          != 0
+        || zmq_setsockopt (s, ZMQ_SNDHWM, &hwm, sizeof hwm) != 0)
+        fail ("zmq_setsockopt");
+
+    //  Workers bind so that the weight is taken from the connecting side.
+    for (int i = 0; i != nworkers; i++) {
+        if (zmq_setsockopt (s, ZMQ_LB_WEIGHT, &weights[i], sizeof weights[i])
+            != 0)
+            fail ("zmq_setsockopt");
+        char endpoint[32];
+        std::snprintf (endpoint, sizeof endpoint, "inproc://lb-%d", i);
+        while (zmq_connect (s, endpoint) != 0)
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+    }
+
+    const int64_t start = now_ns ();
+    const double interval_ns = rate_ > 0 ? 1e9 / rate_ : 0;
+    for (int i = 0; i != message_count; i++) {
+        if (interval_ns > 0) {
+            const int64_t due = start + static_cast<int64_t> (i * interval_ns);
+            while (now_ns () < due)
+                std::this_thread::yield ();
+        }
+        const int64_t sent = now_ns ();
+        if (zmq_send (s, &sent, sizeof sent, 0) != sizeof sent)
+            fail ("zmq_send");
+    }
+
+    for (size_t i = 0; i != threads.size (); i++)
+        threads[i].join ();
+    const int64_t elapsed = now_ns () - start;
+
+    std::vector<int64_t> latencies;
+    std::printf ("%-14s %s", name_, rate_ > 0 ? "paced " : "flat  ");
+    for (int i = 0; i != nworkers; i++) {
+        latencies.insert (latencies.end (), workers[i].latencies.begin (),
+                          workers[i].latencies.end ());
+        std::printf (" %5d", static_cast<int> (workers[i].latencies.size ()));
+    }
+    std::sort (latencies.begin (), latencies.end ());
+    const size_t n = latencies.size ();
+    std::printf ("  %8.0f msg/s  p50 %7.2f ms  p99 %7.2f ms  p99.9 %7.2f ms\n",
+                 n * 1e9 / elapsed, latencies[n / 2] / 1e6,
+                 latencies[n * 99 / 100] / 1e6, latencies[n * 999 / 1000] / 1e6);
+
+    zmq_close (s);
+    zmq_ctx_term (ctx);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1)
+        message_count = std::atoi (argv[1]);
+    if (argc > 2)
+        hwm = std::atoi (argv[2]);
+    if (argc > 3 || message_count <= 0 || hwm <= 0) {
+        std::printf ("usage: benchmark_lb [message-count] [hwm]\n");
+        return 1;
+    }
+
+    double capacity = 0;
+    for (int i = 0; i != nworkers; i++)
+        capacity += 1e6 / service_us[i];
+
+    std::printf ("%d messages, hwm %d, workers", message_count, hwm);
+    for (int i = 0; i != nworkers; i++)
+        std::printf (" %dus", service_us[i]);
+    std::printf (", paced at %.0f msg/s\n", capacity * paced_load);
+    std::printf ("strategy       run    messages per worker\n");
+
+    const struct
+    {
+        int strategy;
+        const char *name;
+    } strategies[] = {{ZMQ_LB_ROUND_ROBIN, "round-robin"},
+                      {ZMQ_LB_LEAST_LOADED, "least-loaded"},
+                      {ZMQ_LB_WEIGHTED, "weighted"},
+                      {ZMQ_LB_POWER_OF_TWO, "power-of-two"}};
+
+    for (size_t i = 0; i != sizeof strategies / sizeof strategies[0]; i++) {
+        run (strategies[i].strategy, strategies[i].name, 0);
+        run (strategies[i].strategy, strategies[i].name,
+             capacity * paced_load);
+    }
+    return 0;
+}
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
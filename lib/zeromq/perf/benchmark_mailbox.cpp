@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "precompiled.hpp"
+#include "mailbox.hpp"
+#include "signaler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+//  N threads posting commands to a single mailbox, as I/O threads and
+//  application threads do when they share an I/O thread or talk to one
+//  socket. Reports the system calls the signaler makes to wake the reader
+//  up when the library is built with ZMQ_SIGNALER_STATS.
+
+static int command_count = 2000000;
+
+static void run (int producers_)
+{
+    zmq::mailbox_t mailbox;
+    const int per_producer = command_count / producers_;
+
+    zmq::command_t cmd;
+    cmd.destination = NULL;
+    cmd.type = zmq::command_t::done;
+
+    const auto start = std::chrono::steady_clock::now ();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i != producers_; i++)
+        threads.push_back (std::thread ([&mailbox, &cmd, per_producer] {
+            for (int j = 0; j != per_producer; j++)
+                mailbox.send (cmd);
+        }));
+
+    zmq::command_t received;
+    for (int i = 0; i != per_producer * producers_; i++) {
+        const int rc = mailbox.recv (&received, -1);
+        zmq_assert (rc == 0);
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now () - start;
+    for (auto &thread : threads)
+        thread.join ();
+
+    const double ns = static_cast<double> (
+      std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count ());
+    const int total = per_producer * producers_;
+    std::printf ("mailbox  %2d producers  %6.1f ns/command  %6.2f M commands/s",
+                 producers_, ns / total, total * 1e3 / ns);
+
+#if defined ZMQ_HAVE_STD_ATOMIC && defined ZMQ_SIGNALER_STATS
+    //  System calls spent on wake-ups, per thousand commands.
+    zmq::signaler_t::stats_t stats;
+    mailbox.get_stats (&stats);
+    std::printf ("  signals %6.1f  write %6.1f  poll %6.1f  read %6.1f  "
+                 "spin hits %6.1f",
+                 stats.signals * 1e3 / total, stats.writes * 1e3 / total,
+                 stats.polls * 1e3 / total, stats.reads * 1e3 / total,
+                 stats.spin_hits * 1e3 / total);
+#endif
+    std::printf ("\n");
+}
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+//  Producers signalling a reader directly, the way thread-safe sockets
+//  wake up a poller. Signals sent while one is pending are coalesced.
+static void run_signaler (int producers_)
+{
+    zmq::signaler_t signaler;
+    const int per_producer = command_count / producers_;
+    std::atomic<int> running (producers_);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i != producers_; i++)
+        threads.push_back (std::thread ([&signaler, &running, per_producer] {
+            for (int j = 0; j != per_producer; j++)
+                signaler.send ();
+            --running;
+        }));
+
+    int wakeups = 0;
+    while (true) {
+        const bool done = running.load () == 0;
+        if (signaler.wait (done ? 0 : 10) == 0) {
+            signaler.recv ();
+            wakeups++;
+        } else if (done)
+            break;
+    }
+    for (auto &thread : threads)
+        thread.join ();
+
+    std::printf ("signaler %2d producers  %8d wake-ups", producers_, wakeups);
+#if defined ZMQ_SIGNALER_STATS
+    zmq::signaler_t::stats_t stats;
+    signaler.get_stats (&stats);
+    std::printf ("  %10llu signals  %8llu writes  %8llu reads",
+                 static_cast<unsigned long long> (stats.signals),
+                 static_cast<unsigned long long> (stats.writes),
+                 static_cast<unsigned long long> (stats.reads));
+#endif
+    std::printf ("\n");
+}
+#endif
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1)
+        command_count = std::atoi (argv[1]);
+    if (argc > 2 || command_count <= 0) {
+        std::printf ("usage: benchmark_mailbox [command-count]\n");
+        return 1;
+    }
+
+    std::printf ("%d commands, %u hardware threads\n", command_count,
+                 std::thread::hardware_concurrency ());
+    for (int producers = 1; producers <= 8; producers *= 2)
+        run (producers);
+#if defined ZMQ_HAVE_STD_ATOMIC
+    for (int producers = 1; producers <= 8; producers *= 2)
+        run_signaler (producers);
+#endif
+    return 0;
+}
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
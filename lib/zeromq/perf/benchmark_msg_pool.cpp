@@ -0,0 +1,153 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "../include/zmq.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#if !defined _WIN32
+#include <sys/resource.h>
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+
+//  Allocation cost of long messages with and without ZMQ_MSG_POOL. In the
+//  local run one thread allocates and closes each message; in the cross
+//  run a producer allocates and a consumer closes them, as sending threads
+//  and I/O threads do. Messages are handed over through a ring, so that
+//  the figures contain no socket overhead.
+
+typedef std::chrono::steady_clock clock_type;
+
+const int ring_size = 1024;
+
+static int message_count = 1000000;
+
+static void fail (const char *what_)
+{
+    std::printf ("error in %s: %s\n", what_, zmq_strerror (zmq_errno ()));
+    std::exit (1);
+}
+
+static long minor_faults ()
+{
+#if !defined _WIN32
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+#else
+    return 0;
+#endif
+}
+
+static void init_msg (zmq_msg_t *msg_, size_t size_)
+{
+    if (zmq_msg_init_size (msg_, size_) != 0)
+        fail ("zmq_msg_init_size");
+    //  Touch the content the way a sender filling it in would.
+    static_cast<char *> (zmq_msg_data (msg_))[0] = 0;
+    static_cast<char *> (zmq_msg_data (msg_))[size_ - 1] = 0;
+}
+
+static void run_local (size_t size_)
+{
+    for (int i = 0; i != message_count; i++) {
+        zmq_msg_t msg;
+        init_msg (&msg, size_);
+        zmq_msg_close (&msg);
+    }
+}
+
+static void run_cross (size_t size_)
+{
+    static zmq_msg_t ring[ring_size];
+    std::atomic<int> head (0);
+    std::atomic<int> tail (0);
+
+    std::thread consumer ([&head, &tail] {
+        for (int i = 0; i != message_count; i++) {
+            while (tail.load (std::memory_order_acquire) == i)
+                std::this_thread::yield ();
+            zmq_msg_close (&ring[i % ring_size]);
+            head.store (i + 1, std::memory_order_release);
+        }
+    });
+
+    for (int i = 0; i != message_count; i++) {
+        while (i - head.load (std::memory_order_acquire) == ring_size)
+            std::this_thread::yield ();
+        init_msg (&ring[i % ring_size], size_);
+        tail.store (i + 1, std::memory_order_release);
+    }
+    consumer.join ();
+}
+
+static void run (const char *name_, void (*fn_) (size_t), size_t size_,
+                 bool pool_)
+{
+    void *ctx = zmq_ctx_new ();
+    if (!ctx)
+        fail ("zmq_ctx_new");
+    if (pool_ && zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1) != 0)
+        fail ("zmq_ctx_set");
+
+    const long faults = minor_faults ();
+    const clock_type::time_point start = clock_type::now ();
+    fn_ (size_);
+    const double ns = static_cast<double> (
+      std::chrono::duration_cast<std::chrono::nanoseconds> (clock_type::now ()
+                                                            - start)
+        .count ());
+
+    std::printf ("%-6s %6u B  %-6s %8.1f ns/msg  %8.3f faults/msg\n", name_,
+                 static_cast<unsigned> (size_), pool_ ? "pool" : "malloc",
+                 ns / message_count,
+                 static_cast<double> (minor_faults () - faults)
+                   / message_count);
+    zmq_ctx_term (ctx);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1)
+        message_count = std::atoi (argv[1]);
+    if (argc > 2 || message_count <= 0) {
+        std::printf ("usage: benchmark_msg_pool [message-count]\n");
+        return 1;
+    }
+
+    std::printf ("%d messages, %u hardware threads\n", message_count,
+                 std::thread::hardware_concurrency ());
+    const size_t sizes[] = {1024, 4096, 16384, 65536};
+    for (size_t i = 0; i != sizeof sizes / sizeof sizes[0]; i++) {
+        run ("local", run_local, sizes[i], false);
+        run ("local", run_local, sizes[i], true);
+        run ("cross", run_cross, sizes[i], false);
+        run ("cross", run_cross, sizes[i], true);
+    }
+    return 0;
+}
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include <cstdio>
 #include <random>
 #include <ratio>
+#include <string>
 #include <vector>
 
 const std::size_t nkeys = 10000;
@@ -21,8 +22,7 @@ const char *chars = "abcdefghijklmnopqrstuvwxyz0123456789";
 const int chars_len = 36;
 
 template <class T>
-void benchmark_lookup (T &subscriptions_,
-                       std::vector<unsigned char *> &queries_)
+void benchmark_lookup (T &subscriptions_, std::vector<std::string> &queries_)
 {
     using namespace std::chrono;
     std::vector<duration<long, std::nano> > samples_vec;
@@ -30,14 +30,18 @@ void benchmark_lookup (T &subscriptions_,
 
     for (std::size_t run = 0; run < warmup_runs; ++run) {
         for (auto &query : queries_)
-            subscriptions_.check (query, key_length);
+            subscriptions_.check (
+              reinterpret_cast<const unsigned char *> (query.data ()),
+              query.size ());
     }
 
     for (std::size_t run = 0; run < samples; ++run) {
         duration<long, std::nano> interval (0);
         for (auto &query : queries_) {
             auto start = steady_clock::now ();
-            subscriptions_.check (query, key_length);
+            subscriptions_.check (
+              reinterpret_cast<const unsigned char *> (query.data ()),
+              query.size ());
             auto end = steady_clock::now ();
             interval += end - start;
         }
@@ -51,48 +55,81 @@ void benchmark_lookup (T &subscriptions_,
                  static_cast<double> (sum) / samples);
 }
 
-int main ()
+void benchmark (const char *name_,
+                std::vector<std::string> &input_set_,
+                std::vector<std::string> &queries_)
 {
-    // Generate input set.
-    std::minstd_rand rng (123456789);
-    std::vector<unsigned char *> input_set;
-    std::vector<unsigned char *> queries;
-    input_set.reserve (nkeys);
-    queries.reserve (nqueries);
-
-    for (std::size_t i = 0; i < nkeys; ++i) {
-        unsigned char *key = new unsigned char[key_length];
-        for (std::size_t j = 0; j < key_length; j++)
-            key[j] = static_cast<unsigned char> (chars[rng () % chars_len]);
-        input_set.emplace_back (key);
-    }
-    for (std::size_t i = 0; i < nqueries; ++i)
-        queries.push_back (input_set[rng () % nkeys]);
-
     // Initialize both data structures.
     //
     // Keeping initialization out of the benchmarking function helps
     // heaptrack detect peak memory consumption of the radix tree.
     zmq::trie_t trie;
     zmq::radix_tree_t radix_tree;
-    for (auto &key : input_set) {
-        trie.add (key, key_length);
-        radix_tree.add (key, key_length);
+    std::size_t key_size = 0;
+    for (auto &key : input_set_) {
+        unsigned char *const data = reinterpret_cast<unsigned char *> (&key[0]);
+        trie.add (data, key.size ());
+        radix_tree.add (data, key.size ());
+        key_size += key.size ();
     }
 
     // Create a benchmark.
-    std::printf ("keys = %llu, queries = %llu, key size = %llu\n",
-                 static_cast<unsigned long long> (nkeys),
-                 static_cast<unsigned long long> (nqueries),
-                 static_cast<unsigned long long> (key_length));
+    std::printf ("%s: keys = %llu, queries = %llu, key size = %llu\n", name_,
+                 static_cast<unsigned long long> (input_set_.size ()),
+                 static_cast<unsigned long long> (queries_.size ()),
+                 static_cast<unsigned long long> (key_size
+                                                  / input_set_.size ()));
     std::puts ("[trie]");
-    benchmark_lookup (trie, queries);
+    benchmark_lookup (trie, queries_);
 
     std::puts ("[radix_tree]");
-    benchmark_lookup (radix_tree, queries);
+    benchmark_lookup (radix_tree, queries_);
+}
 
-    for (auto &op : input_set)
-        delete[] op;
+int main ()
+{
+    std::minstd_rand rng (123456789);
+    std::vector<std::string> input_set;
+    std::vector<std::string> queries;
+
+    // Random keys, looked up as they are.
+    for (std::size_t i = 0; i < nkeys; ++i) {
+        std::string key (key_length, 0);
+        for (std::size_t j = 0; j < key_length; j++)
+            key[j] = chars[rng () % chars_len];
+        input_set.push_back (key);
+    }
+    for (std::size_t i = 0; i < nqueries; ++i)
+        queries.push_back (input_set[rng () % nkeys]);
+    benchmark ("random keys", input_set, queries);
+
+    // Hierarchical topics with long common prefixes, looked up with a
+    // payload following the topic.
+    input_set.clear ();
+    queries.clear ();
+    const char *venues[] = {"xetra", "euronext", "lse", "six"};
+    for (std::size_t i = 0; i < nkeys; ++i) {
+        char key[128];
+        std::snprintf (key, sizeof key,
+                       "com.example.marketdata.equities.europe.%s."
+                       "instruments.%05u.trades",
+                       venues[rng () % 4], static_cast<unsigned> (i));
+        input_set.push_back (key);
+    }
+    for (std::size_t i = 0; i < nqueries; ++i)
+        queries.push_back (input_set[rng () % nkeys] + "|price=101.25");
+    benchmark ("hierarchical keys", input_set, queries);
+
+    // A single subscription to one of these topics, which all messages
+    // match.
+    input_set.resize (1);
+    for (auto &query : queries)
+        query = input_set[0] + "|price=101.25";
+    benchmark ("one subscription", input_set, queries);
+
+    // A subscription to everything.
+    input_set[0].clear ();
+    benchmark ("subscribe all", input_set, queries);
 }
 
 #else
@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "../include/zmq.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined __GLIBC__
+#include <malloc.h>
+#endif
+#if defined __linux__
+#include <unistd.h>
+#endif
+
+//  Memory kept alive by received messages. A PULL socket receives over TCP
+//  and holds on to one message in keep_every, as an application that
+//  queues some of its input does, then reports the growth of the resident
+//  set per message held and per message received. With zero-copy decoding
+//  a message held may keep the whole receive buffer it was decoded from.
+
+typedef std::chrono::steady_clock clock_type;
+
+static int message_count = 200000;
+static int keep_every = 64;
+
+static void fail (const char *what_)
+{
+    std::printf ("error in %s: %s\n", what_, zmq_strerror (zmq_errno ()));
+    std::exit (1);
+}
+
+//  Resident set size in bytes, 0 if unknown.
+static long resident_bytes ()
+{
+#if defined __GLIBC__
+    //  Give the memory freed by the previous run back first.
+    malloc_trim (0);
+#endif
+#if defined __linux__
+    FILE *file = std::fopen ("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+    long pages = 0;
+    long resident = 0;
+    const int n = std::fscanf (file, "%ld %ld", &pages, &resident);
+    std::fclose (file);
+    return n == 2 ? resident * sysconf (_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+static void run (size_t size_, bool zero_copy_)
+{
+    void *ctx = zmq_ctx_new ();
+    if (!ctx)
+        fail ("zmq_ctx_new");
+#ifdef ZMQ_ZERO_COPY_RECV
+    if (zmq_ctx_set (ctx, ZMQ_ZERO_COPY_RECV, zero_copy_ ? 1 : 0) != 0)
+        fail ("zmq_ctx_set");
+#endif
+
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    if (!pull)
+        fail ("zmq_socket");
+    int hwm = 0;
+    if (zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof hwm) != 0
+        || zmq_bind (pull, "tcp://127.0.0.1:*") != 0)
+        fail ("zmq_bind");
+    char endpoint[256];
+    size_t endpoint_len = sizeof endpoint;
+    if (zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len) != 0)
+        fail ("zmq_getsockopt");
+
+    std::thread sender ([ctx, &endpoint, size_] {
+        void *push = zmq_socket (ctx, ZMQ_PUSH);
+        if (!push || zmq_connect (push, endpoint) != 0)
+            fail ("zmq_connect");
+        std::vector<char> data (size_, 'x');
+        for (int i = 0; i != message_count; i++)
+            if (zmq_send (push, &data[0], size_, 0) != static_cast<int> (size_))
+                fail ("zmq_send");
+        zmq_close (push);
+    });
+
+    //  The slot after the last message held is used for receiving.
+    std::vector<zmq_msg_t> kept (message_count / keep_every + 2);
+    size_t kept_count = 0;
+    const long resident = resident_bytes ();
+    const clock_type::time_point start = clock_type::now ();
+
+    for (int i = 0; i != message_count; i++) {
+        zmq_msg_t *msg = &kept[kept_count];
+        if (zmq_msg_init (msg) != 0 || zmq_msg_recv (msg, pull, 0) == -1)
+            fail ("zmq_msg_recv");
+        if (i % keep_every == 0)
+            kept_count++;
+        else
+            zmq_msg_close (msg);
+    }
+
+    const double ns = static_cast<double> (
+      std::chrono::duration_cast<std::chrono::nanoseconds> (clock_type::now ()
+                                                            - start)
+        .count ());
+    const double growth = static_cast<double> (resident_bytes () - resident);
+    std::printf ("%7u B  %-9s %8.1f ns/msg  %10.0f B/held msg  %8.1f B/msg\n",
+                 static_cast<unsigned> (size_),
+                 zero_copy_ ? "zero-copy" : "copy", ns / message_count,
+                 growth / kept_count, growth / message_count);
+
+    for (size_t i = 0; i != kept_count; i++)
+        zmq_msg_close (&kept[i]);
+    sender.join ();
+    zmq_close (pull);
+    zmq_ctx_term (ctx);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1)
+        message_count = std::atoi (argv[1]);
+    if (argc > 2)
+        keep_every = std::atoi (argv[2]);
+    if (argc > 3 || message_count <= 0 || keep_every <= 0) {
+        std::printf ("usage: benchmark_recv_memory [message-count] "
+                     "[keep-every]\n");
+        return 1;
+    }
+
+    std::printf ("%d messages, one in %d held\n", message_count, keep_every);
+    const size_t sizes[] = {64, 200, 1024, 16384, 65536};
+    for (size_t i = 0; i != sizeof sizes / sizeof sizes[0]; i++) {
+        run (sizes[i], true);
+#ifdef ZMQ_ZERO_COPY_RECV
+        run (sizes[i], false);
+#endif
+    }
+    return 0;
+}
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,199 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "precompiled.hpp"
+#include "blob_map.hpp"
+#include "wire.hpp"
+#include "../include/zmq.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+//  The cost of a ROUTER send as the number of peers grows. The first part
+//  looks up routing ids in the table ROUTER keeps its peers in and in the
+//  std::map it replaced. The second part sends through a ROUTER that is
+//  connected to one DEALER over inproc as many times as there are peers,
+//  so each connection is a peer of its own.
+
+typedef std::chrono::steady_clock clock_type;
+
+const int peer_counts[] = {10, 100, 1000, 10000, 100000};
+const int lookup_count = 2000000;
+const int message_count = 1000000;
+const int batch_size = 1000;
+
+struct out_pipe_t
+{
+    void *pipe;
+    bool active;
+};
+
+//  Routing ids as ROUTER generates them, a zero byte and a counter.
+static std::vector<zmq::blob_t> make_routing_ids (int count_)
+{
+    std::vector<zmq::blob_t> res;
+    res.reserve (count_);
+    for (int i = 0; i != count_; i++) {
+        unsigned char buf[5];
+        buf[0] = 0;
+        zmq::put_uint32 (buf + 1, 0x10000000 + i);
+        res.emplace_back (buf, sizeof buf);
+    }
+    return res;
+}
+
+//  Routing ids in the order messages are sent to them.
+static std::vector<int> make_order (int peers_, int count_)
+{
+    std::minstd_rand rng (123456789);
+    std::vector<int> res;
+    res.reserve (count_);
+    for (int i = 0; i != count_; i++)
+        res.push_back (static_cast<int> (rng () % peers_));
+    return res;
+}
+
+static double elapsed_ns (clock_type::time_point start_)
+{
+    return static_cast<double> (
+      std::chrono::duration_cast<std::chrono::nanoseconds> (clock_type::now ()
+                                                            - start_)
+        .count ());
+}
+
+static void run_lookups (int peers_)
+{
+    std::vector<zmq::blob_t> ids = make_routing_ids (peers_);
+    const std::vector<int> order = make_order (peers_, lookup_count);
+
+    std::map<zmq::blob_t, out_pipe_t> tree;
+    zmq::blob_map_t<out_pipe_t> table;
+    for (int i = 0; i != peers_; i++) {
+        const out_pipe_t out_pipe = {&ids[i], true};
+        zmq::blob_t key;
+        key.set_deep_copy (ids[i]);
+        tree.emplace (std::move (key), out_pipe);
+        table.insert (ids[i], out_pipe);
+    }
+
+    //  The routing id to look up arrives in a message, so the keys are
+    //  temporary blobs referring to a copy of it.
+    std::vector<unsigned char> frames (5 * static_cast<size_t> (peers_));
+    for (int i = 0; i != peers_; i++)
+        memcpy (&frames[5 * i], ids[i].data (), 5);
+
+    size_t found = 0;
+    clock_type::time_point start = clock_type::now ();
+    for (int i = 0; i != lookup_count; i++) {
+        const zmq::blob_t key (&frames[5 * order[i]], 5,
+                               zmq::reference_tag_t ());
+        found += tree.find (key) != tree.end ();
+    }
+    const double tree_ns = elapsed_ns (start) / lookup_count;
+
+    start = clock_type::now ();
+    for (int i = 0; i != lookup_count; i++) {
+        const zmq::blob_t key (&frames[5 * order[i]], 5,
+                               zmq::reference_tag_t ());
+        found += table.find (key) != NULL;
+    }
+    const double table_ns = elapsed_ns (start) / lookup_count;
+    zmq_assert (found == 2 * static_cast<size_t> (lookup_count));
+
+    std::printf ("%6d peers  std::map %6.1f ns/lookup  blob_map %6.1f "
+                 "ns/lookup\n",
+                 peers_, tree_ns, table_ns);
+}
+
+static void fail (const char *what_)
+{
+    std::printf ("error in %s: %s\n", what_, zmq_strerror (zmq_errno ()));
+    std::exit (1);
+}
+
+static void run_sends (void *ctx_, int peers_)
+{
+    void *dealer = zmq_socket (ctx_, ZMQ_DEALER);
+    void *router = zmq_socket (ctx_, ZMQ_ROUTER);
+    if (!dealer || !router)
+        fail ("zmq_socket");
+    int mandatory = 1;
+    if (zmq_setsockopt (router, ZMQ_ROUTER_MANDATORY, &mandatory,
+                        sizeof mandatory))
+        fail ("zmq_setsockopt");
+    char endpoint[64];
+    std::snprintf (endpoint, sizeof endpoint, "inproc://benchmark_router_%d",
+                   peers_);
+    if (zmq_bind (dealer, endpoint))
+        fail ("zmq_bind");
+
+    const std::vector<zmq::blob_t> ids = make_routing_ids (peers_);
+    for (int i = 0; i != peers_; i++) {
+        if (zmq_setsockopt (router, ZMQ_CONNECT_ROUTING_ID, ids[i].data (),
+                            ids[i].size ()))
+            fail ("zmq_setsockopt");
+        if (zmq_connect (router, endpoint))
+            fail ("zmq_connect");
+    }
+
+    //  Messages are sent in batches and drained before the next one, so
+    //  that no pipe reaches its high water mark.
+    const std::vector<int> order = make_order (peers_, message_count);
+    char body[8] = {0};
+    const clock_type::time_point start = clock_type::now ();
+    for (int i = 0; i != message_count; i += batch_size) {
+        for (int j = i; j != i + batch_size; j++) {
+            const zmq::blob_t &id = ids[order[j]];
+            if (zmq_send (router, id.data (), id.size (), ZMQ_SNDMORE) < 0
+                || zmq_send (router, body, sizeof body, 0) < 0)
+                fail ("zmq_send");
+        }
+        for (int j = 0; j != batch_size; j++)
+            if (zmq_recv (dealer, body, sizeof body, 0) < 0)
+                fail ("zmq_recv");
+    }
+    const double ns = elapsed_ns (start) / message_count;
+
+    std::printf ("%6d peers  %6.1f ns/message  %6.2f M messages/s\n", peers_,
+                 ns, 1e3 / ns);
+
+    zmq_close (router);
+    zmq_close (dealer);
+}
+
+int main (int argc, char *argv[])
+{
+    //  Every inproc peer holds a pipe of its own, so the sends stop at
+    //  max-peers to bound the memory used.
+    int max_peers = 10000;
+    if (argc > 1)
+        max_peers = atoi (argv[1]);
+
+    std::puts ("[lookup]");
+    for (const int peers : peer_counts)
+        run_lookups (peers);
+
+    void *ctx = zmq_ctx_new ();
+    if (!ctx)
+        fail ("zmq_ctx_new");
+    std::puts ("[send]");
+    for (const int peers : peer_counts)
+        if (peers <= max_peers)
+            run_sends (ctx, peers);
+    zmq_ctx_term (ctx);
+
+    return 0;
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
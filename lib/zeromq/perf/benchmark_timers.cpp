@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "timer_wheel.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+//  Active timers look like heartbeats and reconnect intervals of many
+//  connections, expiring within a minute.
+const std::size_t ntimers = 100000;
+const uint64_t max_delay = 60000;
+const std::size_t ncancels = 1000000;
+const std::size_t nlinear_cancels = 1000;
+const uint64_t end_time = 2 * max_delay;
+
+//  The timers poller_base_t kept before the wheel, cancelled by searching
+//  for the sink and id.
+class multimap_timers_t
+{
+  public:
+    void add (uint64_t now_, uint64_t expiration_, void *owner_, int id_)
+    {
+        (void) now_;
+        const timer_t timer = {owner_, id_};
+        _timers.insert (timers_t::value_type (expiration_, timer));
+    }
+
+    bool cancel (void *owner_, int id_)
+    {
+        for (timers_t::iterator it = _timers.begin (), end = _timers.end ();
+             it != end; ++it)
+            if (it->second.owner == owner_ && it->second.id == id_) {
+                _timers.erase (it);
+                return true;
+            }
+        return false;
+    }
+
+    bool expire (uint64_t now_, void **owner_, int *id_, void **arg_)
+    {
+        const timers_t::iterator it = _timers.begin ();
+        if (it == _timers.end () || it->first > now_)
+            return false;
+        *owner_ = it->second.owner;
+        *id_ = it->second.id;
+        *arg_ = NULL;
+        _timers.erase (it);
+        return true;
+    }
+
+  private:
+    struct timer_t
+    {
+        void *owner;
+        int id;
+    };
+    typedef std::multimap<uint64_t, timer_t> timers_t;
+    timers_t _timers;
+};
+
+static double per_op (std::chrono::steady_clock::time_point start_,
+                      std::chrono::steady_clock::time_point end_,
+                      std::size_t count_)
+{
+    using namespace std::chrono;
+    return static_cast<double> (
+             duration_cast<nanoseconds> (end_ - start_).count ())
+           / count_;
+}
+
+template <class T>
+void benchmark (const std::vector<uint64_t> &delays_,
+                std::vector<int> &owners_,
+                std::size_t ncancels_)
+{
+    using namespace std::chrono;
+    T timers;
+    uint64_t now = 1000;
+    std::size_t next_delay = 0;
+
+    auto start = steady_clock::now ();
+    for (std::size_t i = 0; i < ntimers; ++i) {
+        timers.add (now, now + delays_[next_delay++ % delays_.size ()],
+                    &owners_[i], 1);
+    }
+    auto end = steady_clock::now ();
+    std::printf ("Average add time = %.1lf ns\n",
+                 per_op (start, end, ntimers));
+
+    //  Connections resetting their heartbeat timers as traffic comes in.
+    std::minstd_rand rng (42);
+    start = steady_clock::now ();
+    for (std::size_t i = 0; i < ncancels_; ++i) {
+        const std::size_t timer = rng () % ntimers;
+        timers.cancel (&owners_[timer], 1);
+        timers.add (now, now + delays_[next_delay++ % delays_.size ()],
+                    &owners_[timer], 1);
+    }
+    end = steady_clock::now ();
+    std::printf ("Average cancel and add time = %.1lf ns\n",
+                 per_op (start, end, ncancels_));
+
+    //  Let the clock run, rearming every timer that expires.
+    std::size_t expired = 0;
+    start = steady_clock::now ();
+    for (; now < end_time; ++now) {
+        void *owner;
+        int id;
+        void *arg;
+        while (timers.expire (now, &owner, &id, &arg)) {
+            timers.add (now, now + delays_[next_delay++ % delays_.size ()],
+                        owner, id);
+            ++expired;
+        }
+    }
+    end = steady_clock::now ();
+    std::printf ("Average expire and add time = %.1lf ns (%llu timers, "
+                 "%.1lf ns per tick)\n",
+                 per_op (start, end, expired),
+                 static_cast<unsigned long long> (expired),
+                 per_op (start, end, end_time - 1000));
+}
+
+int main ()
+{
+    std::minstd_rand rng (123456789);
+    std::vector<uint64_t> delays (ntimers * 4);
+    for (std::size_t i = 0; i < delays.size (); ++i)
+        delays[i] = 1 + rng () % max_delay;
+    std::vector<int> owners (ntimers);
+
+    std::printf ("timers = %llu, max delay = %llu ms\n",
+                 static_cast<unsigned long long> (ntimers),
+                 static_cast<unsigned long long> (max_delay));
+    std::puts ("[multimap]");
+    benchmark<multimap_timers_t> (delays, owners, nlinear_cancels);
+
+    std::puts ("[timer_wheel]");
+    benchmark<zmq::timer_wheel_t> (delays, owners, ncancels);
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "simd.hpp"
+#include "../include/zmq.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+const std::size_t sizes[] = {6, 16, 32, 128, 1500, 65536};
+const std::size_t bytes_per_size = 256 * 1024 * 1024;
+const std::size_t ws_message_size = 65536;
+const int ws_message_count = 20000;
+
+//  The loop ws_decoder_t and ws_encoder_t used before the masking
+//  kernels, with a modulo per byte.
+void mask_bytewise (unsigned char *dest_,
+                    const unsigned char *src_,
+                    std::size_t size_,
+                    const unsigned char *mask_,
+                    std::size_t offset_)
+{
+    int mask_index = static_cast<int> (offset_);
+    for (std::size_t i = 0; i < size_; ++i, mask_index++)
+        dest_[i] = src_[i] ^ mask_[mask_index % 4];
+}
+
+template <class F>
+double throughput (F mask_, std::vector<unsigned char> &buf_, std::size_t size_)
+{
+    using namespace std::chrono;
+    const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    const std::size_t runs = bytes_per_size / size_;
+
+    //  Odd offsets, as in binary frames, not known at compile time.
+    volatile std::size_t offset = 1;
+    auto start = steady_clock::now ();
+    for (std::size_t run = 0; run != runs; ++run)
+        mask_ (&buf_[0], &buf_[0], size_, mask, offset);
+    auto end = steady_clock::now ();
+    const double seconds = duration<double> (end - start).count ();
+    return static_cast<double> (runs * size_) / seconds / 1000000;
+}
+
+//  Messages from a ws client to a server, which are masked by the client
+//  and unmasked by the server.
+void benchmark_ws ()
+{
+    using namespace std::chrono;
+    void *ctx = zmq_ctx_new ();
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    int rc = zmq_bind (pull, "ws://127.0.0.1:*");
+    if (rc != 0) {
+        std::printf ("ws transport not available: %s\n", zmq_strerror (errno));
+        zmq_close (pull);
+        zmq_ctx_term (ctx);
+        return;
+    }
+    char endpoint[256];
+    size_t endpoint_len = sizeof endpoint;
+    zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len);
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    zmq_connect (push, endpoint);
+
+    std::vector<unsigned char> data (ws_message_size, 'x');
+    zmq_msg_t msg;
+    zmq_msg_init (&msg);
+
+    //  The first message waits for the connection.
+    zmq_send (push, &data[0], data.size (), 0);
+    zmq_msg_recv (&msg, pull, 0);
+
+    auto start = steady_clock::now ();
+    for (int i = 0; i != ws_message_count; ++i) {
+        zmq_send (push, &data[0], data.size (), 0);
+        zmq_msg_recv (&msg, pull, 0);
+    }
+    auto end = steady_clock::now ();
+    const double seconds = duration<double> (end - start).count ();
+    std::printf ("ws://, %d byte messages: %.0lf MB/s\n",
+                 static_cast<int> (ws_message_size),
+                 static_cast<double> (ws_message_size) * ws_message_count
+                   / seconds / 1000000);
+
+    zmq_msg_close (&msg);
+    zmq_close (push);
+    zmq_close (pull);
+    zmq_ctx_term (ctx);
+}
+
+int main ()
+{
+    std::vector<unsigned char> buf (sizes[sizeof sizes / sizeof *sizes - 1]);
+    for (std::size_t i = 0; i != buf.size (); ++i)
+        buf[i] = static_cast<unsigned char> (std::rand ());
+
+    std::puts ("size      bytewise      kernel (MB/s)");
+    for (std::size_t i = 0; i != sizeof sizes / sizeof *sizes; ++i) {
+        const double before = throughput (mask_bytewise, buf, sizes[i]);
+        const double after = throughput (zmq::mask, buf, sizes[i]);
+        std::printf ("%-8u  %8.0lf  %12.0lf\n",
+                     static_cast<unsigned> (sizes[i]), before, after);
+    }
+
+    benchmark_ws ();
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
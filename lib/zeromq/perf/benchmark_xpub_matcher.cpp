@@ -0,0 +1,157 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "generic_mtrie_impl.hpp"
+#include "generic_radix_mtrie_impl.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+//  Topics look like "eu.stocks.de.instrument00042", so they share long
+//  prefixes, and each one has a few subscribers.
+const std::size_t ntopics = 100000;
+const std::size_t nsubscribers = 1000;
+const std::size_t subscribers_per_topic = 3;
+const std::size_t nqueries = 1000000;
+const char *regions[] = {"eu", "us", "asia", "latam"};
+const char *markets[] = {"stocks", "bonds", "futures", "options", "fx"};
+const char *countries[] = {"de", "fr", "uk", "jp", "br", "ca", "au", "ch"};
+
+struct subscription_t
+{
+    const std::string *topic;
+    int *subscriber;
+};
+
+static void count_match (int *subscriber_, std::size_t *count_)
+{
+    (void) subscriber_;
+    ++*count_;
+}
+
+static void count_rm (const unsigned char *data_,
+                      std::size_t size_,
+                      std::size_t *count_)
+{
+    (void) data_;
+    (void) size_;
+    ++*count_;
+}
+
+static const unsigned char *bytes (const std::string &s_)
+{
+    return reinterpret_cast<const unsigned char *> (s_.data ());
+}
+
+template <class T>
+void benchmark (const std::vector<subscription_t> &subscriptions_,
+                const std::vector<std::string> &queries_,
+                std::vector<int> &subscribers_)
+{
+    using namespace std::chrono;
+    T trie;
+
+    auto start = steady_clock::now ();
+    for (const auto &sub : subscriptions_)
+        trie.add (bytes (*sub.topic), sub.topic->size (), sub.subscriber);
+    auto end = steady_clock::now ();
+    std::printf ("Average add time = %.1lf ns\n",
+                 static_cast<double> (
+                   duration_cast<nanoseconds> (end - start).count ())
+                   / subscriptions_.size ());
+
+    std::size_t matches = 0;
+    start = steady_clock::now ();
+    for (const auto &query : queries_)
+        trie.match (bytes (query), query.size (), count_match, &matches);
+    end = steady_clock::now ();
+    std::printf ("Average match time = %.1lf ns (%.2lf matches)\n",
+                 static_cast<double> (
+                   duration_cast<nanoseconds> (end - start).count ())
+                   / queries_.size (),
+                 static_cast<double> (matches) / queries_.size ());
+
+    //  Remove half of the subscriptions one by one, then drop the
+    //  subscribers as if their pipes were terminated.
+    const std::size_t nrm = subscriptions_.size () / 2;
+    start = steady_clock::now ();
+    for (std::size_t i = 0; i < nrm; ++i)
+        trie.rm (bytes (*subscriptions_[i].topic),
+                 subscriptions_[i].topic->size (),
+                 subscriptions_[i].subscriber);
+    end = steady_clock::now ();
+    std::printf ("Average rm (prefix) time = %.1lf ns\n",
+                 static_cast<double> (
+                   duration_cast<nanoseconds> (end - start).count ())
+                   / nrm);
+
+    std::size_t removed = 0;
+    start = steady_clock::now ();
+    for (auto &subscriber : subscribers_)
+        trie.rm (&subscriber, count_rm, &removed, true);
+    end = steady_clock::now ();
+    std::printf ("Average rm (subscriber) time = %.1lf us (%llu topics)\n",
+                 static_cast<double> (
+                   duration_cast<nanoseconds> (end - start).count ())
+                   / subscribers_.size () / 1000,
+                 static_cast<unsigned long long> (removed));
+}
+
+int main ()
+{
+    std::minstd_rand rng (123456789);
+    std::vector<std::string> topics;
+    topics.reserve (ntopics);
+    for (std::size_t i = 0; i < ntopics; ++i) {
+        char topic[64];
+        std::snprintf (topic, sizeof topic, "%s.%s.%s.instrument%05u",
+                       regions[rng () % 4], markets[rng () % 5],
+                       countries[rng () % 8], static_cast<unsigned> (i));
+        topics.push_back (topic);
+    }
+
+    std::vector<int> subscribers (nsubscribers);
+    std::vector<subscription_t> subscriptions;
+    subscriptions.reserve (ntopics * subscribers_per_topic);
+    for (const auto &topic : topics)
+        for (std::size_t i = 0; i < subscribers_per_topic; ++i) {
+            const subscription_t sub = {
+              &topic, &subscribers[rng () % nsubscribers]};
+            subscriptions.push_back (sub);
+        }
+    std::shuffle (subscriptions.begin (), subscriptions.end (), rng);
+
+    //  Messages carry a payload after the topic.
+    std::vector<std::string> queries;
+    queries.reserve (nqueries);
+    for (std::size_t i = 0; i < nqueries; ++i)
+        queries.push_back (topics[rng () % ntopics] + " 1234.56");
+
+    std::printf ("topics = %llu, subscribers = %llu, subscriptions = %llu, "
+                 "queries = %llu\n",
+                 static_cast<unsigned long long> (ntopics),
+                 static_cast<unsigned long long> (nsubscribers),
+                 static_cast<unsigned long long> (subscriptions.size ()),
+                 static_cast<unsigned long long> (nqueries));
+    std::puts ("[mtrie]");
+    benchmark<zmq::generic_mtrie_t<int> > (subscriptions, queries,
+                                           subscribers);
+
+    std::puts ("[radix_mtrie]");
+    benchmark<zmq::generic_radix_mtrie_t<int> > (subscriptions, queries,
+                                                 subscribers);
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
@@ -17,6 +17,7 @@
 
 static int message_count;
 static size_t message_size;
+static int cork_msgs;
 
 #if defined ZMQ_HAVE_WINDOWS
 static unsigned int __stdcall worker (void *ctx_)
@@ -35,6 +36,16 @@ static void *worker (void *ctx_)
         exit (1);
     }
 
+#ifdef ZMQ_CORK_MSGS
+    if (cork_msgs) {
+        rc = zmq_setsockopt (s, ZMQ_CORK_MSGS, &cork_msgs, sizeof (cork_msgs));
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+#endif
+
     rc = zmq_connect (s, "inproc://thr_test");
     if (rc != 0) {
         printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
@@ -93,10 +104,20 @@ int main (int argc, char *argv[])
     unsigned long throughput;
     double megabits;
 
+#ifdef ZMQ_MSG_POOL
+    if (argc < 3 || argc > 5) {
+        printf ("usage: inproc_thr <message-size> <message-count> "
+                "[msg-pool] [cork-msgs]\n");
+        return 1;
+    }
+    if (argc == 5)
+        cork_msgs = atoi (argv[4]);
+#else
     if (argc != 3) {
         printf ("usage: inproc_thr <message-size> <message-count>\n");
         return 1;
     }
+#endif
 
     message_size = atoi (argv[1]);
     message_count = atoi (argv[2]);
@@ -107,6 +128,16 @@ int main (int argc, char *argv[])
         return -1;
     }
 
+#ifdef ZMQ_MSG_POOL
+    if (argc >= 4 && atoi (argv[3])) {
+        rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, atoi (argv[3]));
+        if (rc != 0) {
+            printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+#endif
+
     s = zmq_socket (ctx, ZMQ_PULL);
     if (!s) {
         printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
@@ -14,15 +14,18 @@ int main (int argc, char *argv[])
     int rc;
     int i;
     zmq_msg_t msg;
+    int io_thread_spin = 0;
 
-    if (argc != 4) {
+    if (argc < 4 || argc > 5) {
         printf ("usage: local_lat <bind-to> <message-size> "
-                "<roundtrip-count>\n");
+                "<roundtrip-count> [<io-thread-spin>]\n");
         return 1;
     }
     bind_to = argv[1];
     message_size = atoi (argv[2]);
     roundtrip_count = atoi (argv[3]);
+    if (argc >= 5)
+        io_thread_spin = atoi (argv[4]);
 
     ctx = zmq_init (1);
     if (!ctx) {
@@ -30,6 +33,19 @@ int main (int argc, char *argv[])
         return -1;
     }
 
+    if (io_thread_spin) {
+#ifdef ZMQ_IO_THREAD_SPIN
+        rc = zmq_ctx_set (ctx, ZMQ_IO_THREAD_SPIN, io_thread_spin);
+#else
+        rc = -1;
+        errno = EINVAL;
+#endif
+        if (rc != 0) {
+            printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
     s = zmq_socket (ctx, ZMQ_REP);
     if (!s) {
         printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
@@ -5,6 +5,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+static int compare_roundtrips (const void *a_, const void *b_)
+{
+    const unsigned long a = *(const unsigned long *) a_;
+    const unsigned long b = *(const unsigned long *) b_;
+    return a < b ? -1 : a > b;
+}
+
 int main (int argc, char *argv[])
 {
     const char *connect_to;
@@ -18,15 +25,20 @@ int main (int argc, char *argv[])
     void *watch;
     unsigned long elapsed;
     double latency;
+    unsigned long *roundtrips;
+    unsigned long last;
+    int io_thread_spin = 0;
 
-    if (argc != 4) {
+    if (argc < 4 || argc > 5) {
         printf ("usage: remote_lat <connect-to> <message-size> "
-                "<roundtrip-count>\n");
+                "<roundtrip-count> [<io-thread-spin>]\n");
         return 1;
     }
     connect_to = argv[1];
     message_size = atoi (argv[2]);
     roundtrip_count = atoi (argv[3]);
+    if (argc >= 5)
+        io_thread_spin = atoi (argv[4]);
 
     ctx = zmq_init (1);
     if (!ctx) {
@@ -34,6 +46,19 @@ int main (int argc, char *argv[])
         return -1;
     }
 
+    if (io_thread_spin) {
+#ifdef ZMQ_IO_THREAD_SPIN
+        rc = zmq_ctx_set (ctx, ZMQ_IO_THREAD_SPIN, io_thread_spin);
+#else
+        rc = -1;
+        errno = EINVAL;
+#endif
+        if (rc != 0) {
+            printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
     s = zmq_socket (ctx, ZMQ_REQ);
     if (!s) {
         printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
@@ -53,7 +78,15 @@ int main (int argc, char *argv[])
     }
     memset (zmq_msg_data (&msg), 0, message_size);
 
+    roundtrips =
+      (unsigned long *) malloc (roundtrip_count * sizeof (unsigned long));
+    if (!roundtrips) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+
     watch = zmq_stopwatch_start ();
+    last = 0;
 
     for (i = 0; i != roundtrip_count; i++) {
         rc = zmq_sendmsg (s, &msg, 0);
@@ -70,6 +103,9 @@ int main (int argc, char *argv[])
             printf ("message of incorrect size received\n");
             return -1;
         }
+        elapsed = zmq_stopwatch_intermediate (watch);
+        roundtrips[i] = elapsed - last;
+        last = elapsed;
     }
 
     elapsed = zmq_stopwatch_stop (watch);
@@ -86,6 +122,16 @@ int main (int argc, char *argv[])
     printf ("roundtrip count: %d\n", (int) roundtrip_count);
     printf ("average latency: %.3f [us]\n", (double) latency);
 
+    //  Percentiles of single roundtrips, halved like the average.
+    qsort (roundtrips, roundtrip_count, sizeof (unsigned long),
+           compare_roundtrips);
+    printf ("p50 latency: %.1f [us]\n",
+            (double) roundtrips[roundtrip_count / 2] / 2);
+    printf ("p99 latency: %.1f [us]\n",
+            (double) roundtrips[roundtrip_count - 1 - roundtrip_count / 100]
+              / 2);
+    free (roundtrips);
+
     rc = zmq_close (s);
     if (rc != 0) {
         printf ("error in zmq_close: %s\n", zmq_strerror (errno));
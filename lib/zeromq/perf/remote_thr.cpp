@@ -21,10 +21,14 @@ int main (int argc, char *argv[])
     int i;
     zmq_msg_t msg;
     int curve = 0;
+    int writev_threshold = 0;
+    int zerocopy_threshold = 0;
+    int cork_msgs = 0;
 
-    if (argc != 4 && argc != 5) {
+    if (argc < 4 || argc > 8) {
         printf ("usage: remote_thr <connect-to> <message-size> "
-                "<message-count> [<enable_curve>]\n");
+                "<message-count> [<enable_curve>] [<writev-threshold>] "
+                "[<zerocopy-threshold>] [<cork-msgs>]\n");
         return 1;
     }
     connect_to = argv[1];
@@ -33,6 +37,12 @@ int main (int argc, char *argv[])
     if (argc >= 5 && atoi (argv[4])) {
         curve = 1;
     }
+    if (argc >= 6)
+        writev_threshold = atoi (argv[5]);
+    if (argc >= 7)
+        zerocopy_threshold = atoi (argv[6]);
+    if (argc >= 8)
+        cork_msgs = atoi (argv[7]);
 
     ctx = zmq_init (1);
     if (!ctx) {
@@ -71,6 +81,47 @@ int main (int argc, char *argv[])
         }
     }
 
+    if (writev_threshold) {
+#ifdef ZMQ_WRITEV_THRESHOLD
+        rc = zmq_setsockopt (s, ZMQ_WRITEV_THRESHOLD, &writev_threshold,
+                             sizeof (writev_threshold));
+#else
+        rc = -1;
+        errno = EINVAL;
+#endif
+        if (rc != 0) {
+            printf ("error in zmq_setsockoopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    if (zerocopy_threshold) {
+#ifdef ZMQ_ZEROCOPY_THRESHOLD
+        rc = zmq_setsockopt (s, ZMQ_ZEROCOPY_THRESHOLD, &zerocopy_threshold,
+                             sizeof (zerocopy_threshold));
+#else
+        rc = -1;
+        errno = EINVAL;
+#endif
+        if (rc != 0) {
+            printf ("error in zmq_setsockoopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    if (cork_msgs) {
+#ifdef ZMQ_CORK_MSGS
+        rc = zmq_setsockopt (s, ZMQ_CORK_MSGS, &cork_msgs, sizeof (cork_msgs));
+#else
+        rc = -1;
+        errno = EINVAL;
+#endif
+        if (rc != 0) {
+            printf ("error in zmq_setsockoopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
     rc = zmq_connect (s, connect_to);
     if (rc != 0) {
         printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
@@ -0,0 +1,207 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../include/zmq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ZMQ_BUILD_DRAFT_API
+
+//  RADIO/DISH throughput over UDP. Both sockets use the same endpoint, the
+//  DISH binds it and the RADIO sends to it from a second thread as fast as
+//  it can. UDP drops what the receiver cannot keep up with, so the number
+//  of messages lost is reported along with the throughput. The optional
+//  last argument turns on UDP segmentation and receive offload.
+
+static const char group[] = "thr";
+
+static const char *endpoint;
+static int message_count;
+static size_t message_size;
+static int offload;
+
+static void sender (void *ctx_)
+{
+    void *s = zmq_socket (ctx_, ZMQ_RADIO);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    //  Queue everything, so that messages are only lost by UDP.
+    int hwm = 0;
+    int rc = zmq_setsockopt (s, ZMQ_SNDHWM, &hwm, sizeof hwm);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_setsockopt (s, ZMQ_UDP_GSO, &offload, sizeof offload);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_connect (s, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    zmq_msg_t msg;
+    for (int i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, message_size);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        memset (zmq_msg_data (&msg), 0, message_size);
+        rc = zmq_msg_set_group (&msg, group);
+        if (rc != 0) {
+            printf ("error in zmq_msg_set_group: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        rc = zmq_msg_send (&msg, s, 0);
+        if (rc < 0) {
+            printf ("error in zmq_msg_send: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 4 && argc != 5) {
+        printf ("usage: udp_thr <endpoint> <message-size> <message-count> "
+                "[<offload>]\n");
+        return 1;
+    }
+    endpoint = argv[1];
+    message_size = atoi (argv[2]);
+    message_count = atoi (argv[3]);
+    if (argc == 5 && atoi (argv[4]))
+        offload = 1;
+
+    void *ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void *s = zmq_socket (ctx, ZMQ_DISH);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    //  Stop waiting for the messages lost once nothing arrives for a second.
+    int timeout = 1000;
+    int rc = zmq_setsockopt (s, ZMQ_RCVTIMEO, &timeout, sizeof timeout);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_setsockopt (s, ZMQ_UDP_GRO, &offload, sizeof offload);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_bind (s, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_join (s, group);
+    if (rc != 0) {
+        printf ("error in zmq_join: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    zmq_msg_t msg;
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void *thread = zmq_threadstart (&sender, ctx);
+
+    //  The clock starts with the first message and stops with the last one
+    //  received, so that the timeout is not counted.
+    void *watch = NULL;
+    unsigned long elapsed = 0;
+    int received = 0;
+    while (received != message_count) {
+        rc = zmq_msg_recv (&msg, s, 0);
+        if (rc < 0) {
+            if (errno == EAGAIN)
+                break;
+            printf ("error in zmq_msg_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        if (zmq_msg_size (&msg) != message_size) {
+            printf ("message of incorrect size received\n");
+            return -1;
+        }
+        if (!watch)
+            watch = zmq_stopwatch_start ();
+        else
+            elapsed = zmq_stopwatch_intermediate (watch);
+        received++;
+    }
+    if (watch)
+        zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    zmq_threadclose (thread);
+
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    const double throughput =
+      received > 1 ? (double) (received - 1) / (double) elapsed * 1000000 : 0;
+    const double megabits = (throughput * message_size * 8) / 1000000;
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+    printf ("messages lost: %d\n", message_count - received);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+    printf ("mean throughput: %.3f [Mb/s]\n", megabits);
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+#else
+
+int main ()
+{
+    printf ("udp_thr requires the draft API\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,294 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_BLOB_MAP_HPP_INCLUDED__
+#define __ZMQ_BLOB_MAP_HPP_INCLUDED__
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "blob.hpp"
+#include "err.hpp"
+#include "macros.hpp"
+#include "random.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Hash table from binary keys, such as routing ids, to values of type T.
+//  T must be copyable with memcpy.
+//
+//  The table uses open addressing with linear probing in a power-of-two
+//  array that is kept at most three quarters full. Each slot caches the
+//  hash of its key, so a probe only compares keys whose hashes match, and
+//  keys of up to inline_size bytes are stored in the slot itself. Longer
+//  keys are copied to the heap. Erasing shifts the following slots of the
+//  probe sequence back, so no tombstones accumulate.
+//
+//  Keys are hashed with SipHash-1-3 under a random key drawn for each
+//  table, so peers choosing their own routing ids cannot make them collide
+//  and turn lookups into linear scans.
+//
+//  Pointers to values are invalidated by insert and erase.
+
+template <typename T> class blob_map_t
+{
+  public:
+    //  Keys of up to this size are stored without an allocation. The
+    //  routing ids ROUTER generates take 5 bytes, UUIDs 16.
+    enum
+    {
+        inline_size = 16
+    };
+
+    blob_map_t () : _slots (NULL), _mask (0), _count (0)
+    {
+        _k0 = static_cast<uint64_t> (generate_random ()) << 32
+              | generate_random ();
+        _k1 = static_cast<uint64_t> (generate_random ()) << 32
+              | generate_random ();
+    }
+
+    ~blob_map_t ()
+    {
+        for (size_t i = 0; _slots && i != _mask + 1; i++)
+            if (_slots[i].hash != 0)
+                free_key (_slots[i]);
+        free (_slots);
+    }
+
+    size_t size () const { return _count; }
+    bool empty () const { return _count == 0; }
+
+    //  Returns the value stored for the key, or NULL.
+    T *find (const unsigned char *data_, size_t size_)
+    {
+        const size_t index = lookup (hash (data_, size_), data_, size_);
+        return index == not_found ? NULL : &_slots[index].value;
+    }
+
+    const T *find (const unsigned char *data_, size_t size_) const
+    {
+        const size_t index = lookup (hash (data_, size_), data_, size_);
+        return index == not_found ? NULL : &_slots[index].value;
+    }
+
+    T *find (const blob_t &key_) { return find (key_.data (), key_.size ()); }
+
+    const T *find (const blob_t &key_) const
+    {
+        return find (key_.data (), key_.size ());
+    }
+
+    //  Stores a copy of the key with the value. Returns false, leaving the
+    //  table unchanged, if the key is already present.
+    bool insert (const unsigned char *data_, size_t size_, const T &value_)
+    {
+        const uint32_t h = hash (data_, size_);
+        if (lookup (h, data_, size_) != not_found)
+            return false;
+        if ((_count + 1) * 4 > (_mask + 1) * 3)
+            grow ();
+
+        size_t index = h & _mask;
+        while (_slots[index].hash != 0)
+            index = (index + 1) & _mask;
+
+        slot_t &slot = _slots[index];
+        slot.hash = h;
+        slot.size = size_;
+        unsigned char *key = slot.key.bytes;
+        if (size_ > inline_size) {
+            key = static_cast<unsigned char *> (malloc (size_));
+            alloc_assert (key);
+            slot.key.heap = key;
+        }
+        if (size_)
+            memcpy (key, data_, size_);
+        slot.value = value_;
+        _count++;
+        return true;
+    }
+
+    bool insert (const blob_t &key_, const T &value_)
+    {
+        return insert (key_.data (), key_.size (), value_);
+    }
+
+    //  Removes the key, storing its value in value_ if that is not NULL.
+    //  Returns false if the key is not present.
+    bool erase (const unsigned char *data_, size_t size_, T *value_ = NULL)
+    {
+        size_t index = lookup (hash (data_, size_), data_, size_);
+        if (index == not_found)
+            return false;
+        if (value_)
+            *value_ = _slots[index].value;
+        free_key (_slots[index]);
+
+        //  Move back the slots that would not be reached from their home
+        //  position across the hole.
+        size_t next = (index + 1) & _mask;
+        while (_slots[next].hash != 0) {
+            const size_t home = _slots[next].hash & _mask;
+            if (((next - home) & _mask) >= ((next - index) & _mask)) {
+                memcpy (&_slots[index], &_slots[next], sizeof (slot_t));
+                index = next;
+            }
+            next = (next + 1) & _mask;
+        }
+        _slots[index].hash = 0;
+        _count--;
+        return true;
+    }
+
+    bool erase (const blob_t &key_, T *value_ = NULL)
+    {
+        return erase (key_.data (), key_.size (), value_);
+    }
+
+    //  Calls func_ on the values until it returns true. Returns whether
+    //  it did.
+    template <typename Func> bool any_of (Func func_)
+    {
+        for (size_t i = 0; _count && i != _mask + 1; i++)
+            if (_slots[i].hash != 0 && func_ (_slots[i].value))
+                return true;
+        return false;
+    }
+
+  private:
+    //  A slot is free if its hash is 0, hashes of keys are never 0.
+    struct slot_t
+    {
+        uint32_t hash;
+        uint32_t size;
+        union
+        {
+            unsigned char bytes[inline_size];
+            unsigned char *heap;
+        } key;
+        T value;
+    };
+
+    static const size_t not_found = static_cast<size_t> (-1);
+
+    //  SipHash-1-3 under the table's key, folded to 32 bits.
+    uint32_t hash (const unsigned char *data_, size_t size_) const
+    {
+        uint64_t v0 = _k0 ^ 0x736f6d6570736575ULL;
+        uint64_t v1 = _k1 ^ 0x646f72616e646f6dULL;
+        uint64_t v2 = _k0 ^ 0x6c7967656e657261ULL;
+        uint64_t v3 = _k1 ^ 0x7465646279746573ULL;
+
+        const unsigned char *const end =
+          data_ + (size_ & ~static_cast<size_t> (7));
+        for (; data_ != end; data_ += 8) {
+            const uint64_t m = load (data_, 8);
+            v3 ^= m;
+            sip_round (v0, v1, v2, v3);
+            v0 ^= m;
+        }
+        const uint64_t m =
+          static_cast<uint64_t> (size_) << 56 | load (data_, size_ & 7);
+        v3 ^= m;
+        sip_round (v0, v1, v2, v3);
+        v0 ^= m;
+
+        v2 ^= 0xff;
+        for (int i = 0; i != 3; i++)
+            sip_round (v0, v1, v2, v3);
+        const uint64_t h = v0 ^ v1 ^ v2 ^ v3;
+        const uint32_t res = static_cast<uint32_t> (h ^ (h >> 32));
+        return res ? res : 1;
+    }
+
+    //  Reads up to 8 bytes as a little-endian integer.
+    static uint64_t load (const unsigned char *data_, size_t size_)
+    {
+        uint64_t res = 0;
+        for (size_t i = 0; i != size_; i++)
+            res |= static_cast<uint64_t> (data_[i]) << (8 * i);
+        return res;
+    }
+
+    static uint64_t rotl (uint64_t x_, int bits_)
+    {
+        return x_ << bits_ | x_ >> (64 - bits_);
+    }
+
+    static void
+    sip_round (uint64_t &v0_, uint64_t &v1_, uint64_t &v2_, uint64_t &v3_)
+    {
+        v0_ += v1_;
+        v1_ = rotl (v1_, 13) ^ v0_;
+        v0_ = rotl (v0_, 32);
+        v2_ += v3_;
+        v3_ = rotl (v3_, 16) ^ v2_;
+        v0_ += v3_;
+        v3_ = rotl (v3_, 21) ^ v0_;
+        v2_ += v1_;
+        v1_ = rotl (v1_, 17) ^ v2_;
+        v2_ = rotl (v2_, 32);
+    }
+
+    static const unsigned char *key_data (const slot_t &slot_)
+    {
+        return slot_.size > inline_size ? slot_.key.heap : slot_.key.bytes;
+    }
+
+    static void free_key (slot_t &slot_)
+    {
+        if (slot_.size > inline_size)
+            free (slot_.key.heap);
+    }
+
+    size_t
+    lookup (uint32_t hash_, const unsigned char *data_, size_t size_) const
+    {
+        if (!_count)
+            return not_found;
+        for (size_t index = hash_ & _mask;; index = (index + 1) & _mask) {
+            const slot_t &slot = _slots[index];
+            if (slot.hash == 0)
+                return not_found;
+            if (slot.hash == hash_ && slot.size == size_
+                && (!size_ || memcmp (key_data (slot), data_, size_) == 0))
+                return index;
+        }
+    }
+
+    void grow ()
+    {
+        const size_t old_capacity = _slots ? _mask + 1 : 0;
+        const size_t capacity = old_capacity ? old_capacity * 2 : 16;
+        slot_t *const old_slots = _slots;
+
+        _slots = static_cast<slot_t *> (calloc (capacity, sizeof (slot_t)));
+        alloc_assert (_slots);
+        _mask = capacity - 1;
+
+        //  The keys move with their slots.
+        for (size_t i = 0; i != old_capacity; i++) {
+            if (old_slots[i].hash == 0)
+                continue;
+            size_t index = old_slots[i].hash & _mask;
+            while (_slots[index].hash != 0)
+                index = (index + 1) & _mask;
+            memcpy (&_slots[index], &old_slots[i], sizeof (slot_t));
+        }
+        free (old_slots);
+    }
+
+    slot_t *_slots;
+    size_t _mask;
+    size_t _count;
+
+    //  Key of the hash function.
+    uint64_t _k0;
+    uint64_t _k1;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (blob_map_t)
+};
+}
+
+#endif
@@ -0,0 +1,247 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "chunk_pool.hpp"
+
+#include <stdlib.h>
+#include <new>
+
+#include "err.hpp"
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+#include <atomic>
+#include <stdio.h>
+#if defined ZMQ_HAVE_LINUX
+#include <sched.h>
+#endif
+#endif
+
+#if defined ZMQ_HAVE_LINUX && defined __GLIBC__                                \
+  && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define ZMQ_HAVE_GETCPU
+#endif
+
+namespace
+{
+//  Nodes beyond this share pools.
+const int max_nodes = 16;
+
+size_t node_offset (size_t chunk_size_)
+{
+    return (chunk_size_ + sizeof (int) - 1) & ~(sizeof (int) - 1);
+}
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+int node_count ()
+{
+#if defined ZMQ_HAVE_LINUX
+    //  The file holds a range such as "0-3", or "0" on a single node.
+    FILE *file = fopen ("/sys/devices/system/node/possible", "r");
+    if (!file)
+        return 1;
+    int first = 0;
+    int last = 0;
+    const int n = fscanf (file, "%d-%d", &first, &last);
+    fclose (file);
+    const int count = (n == 2 ? last : first) + 1;
+    return count < 1 ? 1 : count > max_nodes ? max_nodes : count;
+#else
+    return 1;
+#endif
+}
+
+int current_node ()
+{
+#if defined ZMQ_HAVE_GETCPU
+    unsigned int cpu;
+    unsigned int node;
+    if (getcpu (&cpu, &node) == 0)
+        return static_cast<int> (node);
+#endif
+    return 0;
+}
+#endif
+}
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+
+//  Bounded multi-producer multi-consumer queue of free chunks. Each cell
+//  carries a sequence number telling whether it is ready to be written
+//  or read at the current lap, so positions are claimed with a single
+//  compare-and-swap and there is no ABA problem.
+struct zmq::chunk_pool_t::node_pool_t
+{
+    struct cell_t
+    {
+        std::atomic<size_t> sequence;
+        void *chunk;
+    };
+
+    std::atomic<size_t> enqueue_pos;
+    char enqueue_pad[ZMQ_CACHELINE_SIZE - sizeof (std::atomic<size_t>)];
+    std::atomic<size_t> dequeue_pos;
+    char dequeue_pad[ZMQ_CACHELINE_SIZE - sizeof (std::atomic<size_t>)];
+    cell_t *cells;
+    size_t mask;
+
+    void init (size_t capacity_)
+    {
+        cells = new (std::nothrow) cell_t[capacity_];
+        alloc_assert (cells);
+        mask = capacity_ - 1;
+        for (size_t i = 0; i != capacity_; i++)
+            cells[i].sequence.store (i, std::memory_order_relaxed);
+        enqueue_pos.store (0, std::memory_order_relaxed);
+        dequeue_pos.store (0, std::memory_order_relaxed);
+    }
+
+    bool push (void *chunk_)
+    {
+        size_t pos = enqueue_pos.load (std::memory_order_relaxed);
+        cell_t *cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load (std::memory_order_acquire);
+            const ptrdiff_t diff =
+              static_cast<ptrdiff_t> (seq) - static_cast<ptrdiff_t> (pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak (
+                      pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0)
+                return false;
+            else
+                pos = enqueue_pos.load (std::memory_order_relaxed);
+        }
+        cell->chunk = chunk_;
+        cell->sequence.store (pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    void *pop ()
+    {
+        size_t pos = dequeue_pos.load (std::memory_order_relaxed);
+        cell_t *cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load (std::memory_order_acquire);
+            const ptrdiff_t diff =
+              static_cast<ptrdiff_t> (seq) - static_cast<ptrdiff_t> (pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak (
+                      pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0)
+                return NULL;
+            else
+                pos = dequeue_pos.load (std::memory_order_relaxed);
+        }
+        void *chunk = cell->chunk;
+        cell->sequence.store (pos + mask + 1, std::memory_order_release);
+        return chunk;
+    }
+};
+
+zmq::chunk_pool_t::chunk_pool_t (size_t chunk_size_,
+                                 size_t align_,
+                                 int retention_) :
+    _chunk_size (chunk_size_),
+    _align (align_),
+    _node_offset (node_offset (chunk_size_)),
+    _node_count (node_count ())
+{
+    zmq_assert (retention_ > 0);
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t> (retention_))
+        capacity <<= 1;
+
+    _nodes = new (std::nothrow) node_pool_t[_node_count];
+    alloc_assert (_nodes);
+    for (int i = 0; i != _node_count; i++)
+        _nodes[i].init (capacity);
+}
+
+zmq::chunk_pool_t::~chunk_pool_t ()
+{
+    for (int i = 0; i != _node_count; i++) {
+        while (void *chunk = _nodes[i].pop ())
+            free (chunk);
+        delete[] _nodes[i].cells;
+    }
+    delete[] _nodes;
+}
+
+bool zmq::chunk_pool_t::available ()
+{
+    return true;
+}
+
+void *zmq::chunk_pool_t::allocate ()
+{
+    const int node = current_node () % _node_count;
+    void *chunk = _nodes[node].pop ();
+    return chunk ? chunk : allocate_chunk (node);
+}
+
+void zmq::chunk_pool_t::deallocate (void *chunk_)
+{
+    const int node =
+      *reinterpret_cast<int *> (static_cast<char *> (chunk_) + _node_offset);
+    if (!_nodes[node].push (chunk_))
+        free (chunk_);
+}
+
+#else
+
+//  Without atomics the pool keeps no chunks.
+
+struct zmq::chunk_pool_t::node_pool_t
+{
+};
+
+zmq::chunk_pool_t::chunk_pool_t (size_t chunk_size_, size_t align_, int) :
+    _chunk_size (chunk_size_),
+    _align (align_),
+    _node_offset (node_offset (chunk_size_)),
+    _node_count (1),
+    _nodes (NULL)
+{
+}
+
+zmq::chunk_pool_t::~chunk_pool_t ()
+{
+}
+
+bool zmq::chunk_pool_t::available ()
+{
+    return false;
+}
+
+void *zmq::chunk_pool_t::allocate ()
+{
+    return allocate_chunk (0);
+}
+
+void zmq::chunk_pool_t::deallocate (void *chunk_)
+{
+    free (chunk_);
+}
+
+#endif
+
+void *zmq::chunk_pool_t::allocate_chunk (int node_) const
+{
+    const size_t size = _node_offset + sizeof (int);
+    void *pv;
+#if defined HAVE_POSIX_MEMALIGN
+    if (posix_memalign (&pv, _align, size))
+        return NULL;
+#else
+    pv = malloc (size);
+    if (!pv)
+        return NULL;
+#endif
+    *reinterpret_cast<int *> (static_cast<char *> (pv) + _node_offset) = node_;
+    return pv;
+}
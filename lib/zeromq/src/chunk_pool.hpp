@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_CHUNK_POOL_HPP_INCLUDED__
+#define __ZMQ_CHUNK_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "macros.hpp"
+
+namespace zmq
+{
+//  Pool of the fixed-size chunks yqueues are made of, shared by all the
+//  message pipes of a context. Pipes that go from empty to a burst and
+//  back take chunks from the pool and return them instead of allocating
+//  and freeing them each time.
+//
+//  Free chunks are kept in a bounded lock-free queue per NUMA node. A
+//  chunk is taken from the queue of the node the allocating thread runs
+//  on and goes back to the queue of the node it was first allocated on,
+//  so that a chunk written on one node is not handed to a writer on
+//  another. Chunks beyond the retention of a node are freed.
+
+class chunk_pool_t
+{
+  public:
+    //  Creates a pool of chunks of chunk_size_ bytes aligned to align_,
+    //  keeping up to retention_ free chunks per NUMA node. The retention
+    //  is rounded up to a power of two.
+    chunk_pool_t (size_t chunk_size_, size_t align_, int retention_);
+
+    //  Frees the chunks held by the pool. Chunks still in use must not be
+    //  returned afterwards.
+    ~chunk_pool_t ();
+
+    //  Returns true if pools can be used on this platform.
+    static bool available ();
+
+    size_t chunk_size () const { return _chunk_size; }
+
+    //  Returns a chunk, or NULL if memory is exhausted.
+    void *allocate ();
+
+    //  Returns a chunk obtained from allocate.
+    void deallocate (void *chunk_);
+
+  private:
+    struct node_pool_t;
+
+    void *allocate_chunk (int node_) const;
+
+    const size_t _chunk_size;
+    const size_t _align;
+
+    //  The node a chunk was allocated on is stored after its payload.
+    const size_t _node_offset;
+
+    int _node_count;
+    node_pool_t *_nodes;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (chunk_pool_t)
+};
+}
+
+#endif
@@ -28,6 +28,7 @@ void zmq::client_t::xattach_pipe (pipe_t *pipe_,
     zmq_assert (pipe_);
 
     _fq.attach (pipe_);
+    _lb.set_strategy (options.lb_strategy);
     _lb.attach (pipe_);
 }
 
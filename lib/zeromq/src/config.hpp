@@ -31,6 +31,42 @@ enum
     //  Maximum number of events the I/O thread can process in one go.
     max_io_events = 256,
 
+    //  Maximal number of pause instructions a spinning I/O thread waits
+    //  between two polls that returned no events.
+    max_spin_backoff = 64,
+
+    //  Time between two samples of the traffic of an I/O thread, in
+    //  milliseconds. The traffic is a moving average of the samples.
+    io_thread_traffic_interval = 250,
+
+    //  Traffic each file descriptor of an I/O thread counts as when
+    //  choosing the thread for a new connection, in events plus
+    //  kilobytes per second.
+    io_thread_fd_traffic = 16,
+
+    //  Interval at which the completions of the zero-copy writes of a
+    //  closed TCP connection are polled for, and the time after which
+    //  they are given up on, in milliseconds.
+    zerocopy_drain_interval = 10,
+    zerocopy_drain_timeout = 1000,
+
+    //  Number of consecutive zero-copy writes the kernel had to copy
+    //  after which a TCP connection goes back to plain writes.
+    zerocopy_max_copied = 16,
+
+    //  Maximal number of datagrams a UDP engine sends or receives in one
+    //  system call, where recvmmsg and sendmmsg are available.
+    udp_batch_size = 16,
+
+    //  Maximal time in milliseconds the cork timer waits before it looks
+    //  again at a socket found in use. The wait doubles from 1 ms.
+    cork_timer_max_backoff = 100,
+
+    //  Minimal number of pipes each thread of a parallel fan-out writes
+    //  a message to. Messages matching fewer pipes are written by the
+    //  sending thread alone, as waking up helpers would cost more.
+    fanout_min_pipes = 256,
+
     //  Maximal batch size of packets forwarded by a ZMQ proxy.
     //  Increasing this value improves throughput at the expense of
     //  latency and fairness.
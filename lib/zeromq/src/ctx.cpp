@@ -6,6 +6,7 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <limits>
 #include <climits>
 #include <new>
@@ -19,7 +20,11 @@
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
+#include "msg_pool.hpp"
+#include "chunk_pool.hpp"
+#include "yqueue.hpp"
 #include "random.hpp"
+#include "topology.hpp"
 
 #ifdef ZMQ_HAVE_VMCI
 #include <vmci_sockets.h>
@@ -56,7 +61,11 @@ zmq::ctx_t::ctx_t () :
     _io_thread_count (ZMQ_IO_THREADS_DFLT),
     _blocky (true),
     _ipv6 (false),
-    _zero_copy (true)
+    _zero_copy (true),
+    _msg_pool (false),
+    _pipe_chunk_pool (0),
+    _io_thread_spin (0),
+    _chunk_pool (NULL)
 {
 #ifdef HAVE_FORK
     _pid = getpid ();
@@ -103,9 +112,17 @@ zmq::ctx_t::~ctx_t ()
     //  Deallocate the reaper thread object.
     LIBZMQ_DELETE (_reaper);
 
+    //  All the pipes are gone with the sockets the reaper has destroyed.
+    LIBZMQ_DELETE (_chunk_pool);
+
     //  The mailboxes in _slots themselves were deallocated with their
     //  corresponding io_thread/socket objects.
 
+    //  Messages allocated from the pool may outlive the context, they go
+    //  back to it regardless.
+    if (_msg_pool)
+        msg_pool_t::disable ();
+
     //  De-initialise crypto library, if needed.
     zmq::random_close ();
 
@@ -284,6 +301,38 @@ int zmq::ctx_t::set (int option_, const void *optval_, size_t optvallen_)
             }
             break;
 
+        case ZMQ_MSG_POOL:
+            if (is_int && value >= 0) {
+                scoped_lock_t locker (_opt_sync);
+                if (_msg_pool == (value != 0))
+                    return 0;
+                if (value) {
+                    if (!msg_pool_t::enable ())
+                        break;
+                } else
+                    msg_pool_t::disable ();
+                _msg_pool = (value != 0);
+                return 0;
+            }
+            break;
+
+        case ZMQ_PIPE_CHUNK_POOL:
+            if (is_int && value >= 0
+                && (value == 0 || chunk_pool_t::available ())) {
+                scoped_lock_t locker (_opt_sync);
+                _pipe_chunk_pool = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_IO_THREAD_SPIN:
+            if (is_int && value >= 0) {
+                scoped_lock_t locker (_opt_sync);
+                _io_thread_spin = value;
+                return 0;
+            }
+            break;
+
         default: {
             return thread_ctx_t::set (option_, optval_, optvallen_);
         }
@@ -362,6 +411,30 @@ int zmq::ctx_t::get (int option_, void *optval_, const size_t *optvallen_)
             }
             break;
 
+        case ZMQ_MSG_POOL:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _msg_pool;
+                return 0;
+            }
+            break;
+
+        case ZMQ_PIPE_CHUNK_POOL:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _pipe_chunk_pool;
+                return 0;
+            }
+            break;
+
+        case ZMQ_IO_THREAD_SPIN:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _io_thread_spin;
+                return 0;
+            }
+            break;
+
         default: {
             return thread_ctx_t::get (option_, optval_, optvallen_);
         }
@@ -391,6 +464,7 @@ bool zmq::ctx_t::start ()
     const int term_and_reaper_threads_count = 2;
     const int mazmq = _max_sockets;
     const int ios = _io_thread_count;
+    const int chunk_retention = _pipe_chunk_pool;
     _opt_sync.unlock ();
     const int slot_count = mazmq + ios + term_and_reaper_threads_count;
     try {
@@ -442,6 +516,13 @@ bool zmq::ctx_t::start ()
         _empty_slots.push_back (i);
     }
 
+    if (chunk_retention > 0) {
+        _chunk_pool = new (std::nothrow) chunk_pool_t (
+          yqueue_t<msg_t, message_pipe_granularity>::chunk_size (),
+          ZMQ_CACHELINE_SIZE, chunk_retention);
+        alloc_assert (_chunk_pool);
+    }
+
     _starting = false;
     return true;
 
@@ -519,28 +600,61 @@ zmq::object_t *zmq::ctx_t::get_reaper () const
     return _reaper;
 }
 
+zmq::chunk_pool_t *zmq::ctx_t::get_chunk_pool () const
+{
+    return _chunk_pool;
+}
+
 zmq::thread_ctx_t::thread_ctx_t () :
     _thread_priority (ZMQ_THREAD_PRIORITY_DFLT),
-    _thread_sched_policy (ZMQ_THREAD_SCHED_POLICY_DFLT)
+    _thread_sched_policy (ZMQ_THREAD_SCHED_POLICY_DFLT),
+    _io_thread_package (-1)
 {
 }
 
 void zmq::thread_ctx_t::start_thread (thread_t &thread_,
                                       thread_fn *tfn_,
                                       void *arg_,
-                                      const char *name_) const
+                                      const char *name_,
+                                      int io_thread_) const
 {
-    thread_.setSchedulingParameters (_thread_priority, _thread_sched_policy,
-                                     _thread_affinity_cpus);
+    //  The options may be set by the application meanwhile.
+    _opt_sync.lock ();
+    const int priority = _thread_priority;
+    const int sched_policy = _thread_sched_policy;
+    std::set<int> affinity_cpus = _thread_affinity_cpus;
+    if (io_thread_ >= 0)
+        get_io_thread_affinity (io_thread_, affinity_cpus);
+    const std::string name_prefix = _thread_name_prefix;
+    _opt_sync.unlock ();
+
+    thread_.setSchedulingParameters (priority, sched_policy, affinity_cpus);
 
     char namebuf[16] = "";
     snprintf (namebuf, sizeof (namebuf), "%s%sZMQbg%s%s",
-              _thread_name_prefix.empty () ? "" : _thread_name_prefix.c_str (),
-              _thread_name_prefix.empty () ? "" : "/", name_ ? "/" : "",
+              name_prefix.empty () ? "" : name_prefix.c_str (),
+              name_prefix.empty () ? "" : "/", name_ ? "/" : "",
               name_ ? name_ : "");
     thread_.start (tfn_, arg_, namebuf);
 }
 
+void zmq::thread_ctx_t::get_io_thread_affinity (int io_thread_,
+                                                std::set<int> &cpus_) const
+{
+    //  A list of CPUs of the thread's own takes precedence over placement
+    //  on a package.
+    if (io_thread_ < static_cast<int> (_io_thread_affinity_cpus.size ())
+        && !_io_thread_affinity_cpus[io_thread_].empty ()) {
+        cpus_ = _io_thread_affinity_cpus[io_thread_];
+        return;
+    }
+    if (_io_thread_package >= 0) {
+        std::vector<std::set<int> > cores;
+        if (get_package_cores (_io_thread_package, cores))
+            cpus_ = cores[io_thread_ % cores.size ()];
+    }
+}
+
 int zmq::thread_ctx_t::set (int option_, const void *optval_, size_t optvallen_)
 {
     const bool is_int = (optvallen_ == sizeof (int));
@@ -584,6 +698,39 @@ int zmq::thread_ctx_t::set (int option_, const void *optval_, size_t optvallen_)
             }
             break;
 
+        case ZMQ_IO_THREAD_AFFINITY: {
+            //  Lists of CPUs of successive I/O threads, separated by ';'.
+            const char *const list = static_cast<const char *> (optval_);
+            const std::string affinity (
+              list, std::find (list, list + optvallen_, '\0'));
+            std::vector<std::set<int> > cpus;
+            std::string::size_type begin = 0;
+            while (begin < affinity.size ()) {
+                std::string::size_type end = affinity.find (';', begin);
+                if (end == std::string::npos)
+                    end = affinity.size ();
+                cpus.push_back (std::set<int> ());
+                if (!parse_cpu_list (affinity.substr (begin, end - begin),
+                                     cpus.back ())) {
+                    errno = EINVAL;
+                    return -1;
+                }
+                begin = end + 1;
+            }
+            scoped_lock_t locker (_opt_sync);
+            _io_thread_affinity = affinity;
+            _io_thread_affinity_cpus.swap (cpus);
+            return 0;
+        }
+
+        case ZMQ_IO_THREAD_PACKAGE:
+            if (is_int && value >= -1) {
+                scoped_lock_t locker (_opt_sync);
+                _io_thread_package = value;
+                return 0;
+            }
+            break;
+
         case ZMQ_THREAD_NAME_PREFIX:
             // start_thread() allows max 16 chars for thread name
             if (is_int) {
@@ -633,6 +780,24 @@ int zmq::thread_ctx_t::get (int option_,
                 return 0;
             }
             break;
+
+        case ZMQ_IO_THREAD_AFFINITY: {
+            scoped_lock_t locker (_opt_sync);
+            if (*optvallen_ > _io_thread_affinity.size ()) {
+                memcpy (optval_, _io_thread_affinity.c_str (),
+                        _io_thread_affinity.size () + 1);
+                return 0;
+            }
+            break;
+        }
+
+        case ZMQ_IO_THREAD_PACKAGE:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _io_thread_package;
+                return 0;
+            }
+            break;
     }
 
     errno = EINVAL;
@@ -649,13 +814,18 @@ zmq::io_thread_t *zmq::ctx_t::choose_io_thread (uint64_t affinity_)
     if (_io_threads.empty ())
         return NULL;
 
-    //  Find the I/O thread with minimum load.
-    int min_load = -1;
+    //  Find the I/O thread with minimum load. A hot connection weighs
+    //  more than many idle ones, which are counted as some traffic each
+    //  so that they are spread evenly, too.
+    uint64_t min_load = 0;
     io_thread_t *selected_io_thread = NULL;
     for (io_threads_t::size_type i = 0, size = _io_threads.size (); i != size;
          i++) {
         if (!affinity_ || (affinity_ & (uint64_t (1) << i))) {
-            const int load = _io_threads[i]->get_load ();
+            const uint64_t load =
+              _io_threads[i]->get_traffic ()
+              + static_cast<uint64_t> (_io_threads[i]->get_load ())
+                  * io_thread_fd_traffic;
             if (selected_io_thread == NULL || load < min_load) {
                 min_load = load;
                 selected_io_thread = _io_threads[i];
@@ -24,6 +24,7 @@ class io_thread_t;
 class socket_base_t;
 class reaper_t;
 class pipe_t;
+class chunk_pool_t;
 
 //  Information associated with inproc endpoint. Note that endpoint options
 //  are registered as well so that the peer can access them without a need
@@ -39,25 +40,40 @@ class thread_ctx_t
   public:
     thread_ctx_t ();
 
-    //  Start a new thread with proper scheduling parameters.
+    //  Start a new thread with proper scheduling parameters. I/O threads
+    //  pass their index, which may give them CPUs of their own.
     void start_thread (thread_t &thread_,
                        thread_fn *tfn_,
                        void *arg_,
-                       const char *name_ = NULL) const;
+                       const char *name_ = NULL,
+                       int io_thread_ = -1) const;
 
     int set (int option_, const void *optval_, size_t optvallen_);
     int get (int option_, void *optval_, const size_t *optvallen_);
 
   protected:
     //  Synchronisation of access to context options.
-    mutex_t _opt_sync;
+    mutable mutex_t _opt_sync;
 
   private:
+    //  Replaces cpus_ with the CPUs the given I/O thread is bound to, if
+    //  it has CPUs of its own.
+    void get_io_thread_affinity (int io_thread_, std::set<int> &cpus_) const;
+
     //  Thread parameters.
     int _thread_priority;
     int _thread_sched_policy;
     std::set<int> _thread_affinity_cpus;
     std::string _thread_name_prefix;
+
+    //  CPUs of each I/O thread by index, as set and parsed. An empty set
+    //  leaves the thread to the options below.
+    std::string _io_thread_affinity;
+    std::vector<std::set<int> > _io_thread_affinity_cpus;
+
+    //  Physical package whose cores I/O threads are spread over, one
+    //  thread per core, or -1.
+    int _io_thread_package;
 };
 
 //  Context object encapsulates all the global state associated with
@@ -99,14 +115,21 @@ class ctx_t ZMQ_FINAL : public thread_ctx_t
     //  Send command to the destination thread.
     void send_command (uint32_t tid_, const command_t &command_);
 
-    //  Returns the I/O thread that is the least busy at the moment.
-    //  Affinity specifies which I/O threads are eligible (0 = all).
+    //  Returns the I/O thread that is the least busy at the moment, judged
+    //  by its recent traffic and the number of its file descriptors.
+    //  Only new connections and reconnects are placed this way, objects
+    //  already running stay on their thread. Affinity specifies which
+    //  I/O threads are eligible (0 = all).
     //  Returns NULL if no I/O thread is available.
     zmq::io_thread_t *choose_io_thread (uint64_t affinity_);
 
     //  Returns reaper thread object.
     zmq::object_t *get_reaper () const;
 
+    //  Returns the pool message pipes take their chunks from, NULL if
+    //  pipes allocate chunks themselves.
+    zmq::chunk_pool_t *get_chunk_pool () const;
+
     //  Management of inproc endpoints.
     int register_endpoint (const char *addr_, const endpoint_t &endpoint_);
     int unregister_endpoint (const std::string &addr_,
@@ -215,6 +238,19 @@ class ctx_t ZMQ_FINAL : public thread_ctx_t
     // Should we use zero copy message decoding in this context?
     bool _zero_copy;
 
+    //  Does this context allocate message content from the pool?
+    bool _msg_pool;
+
+    //  Free pipe chunks kept per NUMA node, 0 if chunks are not pooled.
+    int _pipe_chunk_pool;
+
+    //  Microseconds I/O threads keep polling without blocking after
+    //  events, 0 if they always block.
+    int _io_thread_spin;
+
+    //  Pool of message pipe chunks, created when the context starts.
+    chunk_pool_t *_chunk_pool;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (ctx_t)
 
 #ifdef HAVE_FORK
@@ -43,6 +43,7 @@ void zmq::dealer_t::xattach_pipe (pipe_t *pipe_,
     }
 
     _fq.attach (pipe_);
+    _lb.set_strategy (options.lb_strategy);
     _lb.attach (pipe_);
 }
 
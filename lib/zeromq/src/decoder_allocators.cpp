@@ -4,14 +4,37 @@
 #include "decoder_allocators.hpp"
 
 #include "msg.hpp"
+#include "msg_pool.hpp"
+
+namespace
+{
+//  A buffer grows to at most this multiple of the configured size.
+const std::size_t max_growth = 32;
+
+//  Number of average-sized messages a buffer is sized for.
+const std::size_t messages_per_buffer = 4;
+
+//  Messages smaller than this fraction of the buffer are copied. This also
+//  bounds the number of messages built on one buffer.
+const std::size_t max_shared_messages = 32;
+
+std::size_t counters_offset (std::size_t size_)
+{
+    return (size_ + sizeof (void *) - 1) & ~(sizeof (void *) - 1);
+}
+}
 
 zmq::shared_message_memory_allocator::shared_message_memory_allocator (
   std::size_t bufsize_) :
     _buf (NULL),
     _buf_size (0),
     _max_size (bufsize_),
+    _min_size (bufsize_),
+    _adaptive (true),
+    _average_size (0),
+    _copy_below (0),
     _msg_content (NULL),
-    _max_counters ((_max_size + msg_t::max_vsm_size - 1) / msg_t::max_vsm_size)
+    _max_counters (max_shared_messages)
 {
 }
 
@@ -20,6 +43,10 @@ zmq::shared_message_memory_allocator::shared_message_memory_allocator (
     _buf (NULL),
     _buf_size (0),
     _max_size (bufsize_),
+    _min_size (bufsize_),
+    _adaptive (false),
+    _average_size (0),
+    _copy_below (0),
     _msg_content (NULL),
     _max_counters (max_messages_)
 {
@@ -34,50 +61,64 @@ unsigned char *zmq::shared_message_memory_allocator::allocate ()
 {
     if (_buf) {
         // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (_buf);
+        header_t *header = reinterpret_cast<header_t *> (_buf);
 
         // if refcnt drops to 0, there are no message using the buffer
         // because either all messages have been closed or only vsm-messages
         // were created
-        if (c->sub (1)) {
+        if (header->refcnt.sub (1)) {
             // buffer is still in use as message data. "Release" it and create a new one
             // release pointer because we are going to create a new buffer
             release ();
+        } else if (_adaptive && _max_size != target_size ()) {
+            // the buffer is free but no longer fits the traffic
+            free_buffer (_buf);
+            clear ();
         }
     }
 
     // if buf != NULL it is not used by any message so we can re-use it for the next run
     if (!_buf) {
+        if (_adaptive)
+            _max_size = target_size ();
+
         // allocate memory for reference counters together with reception buffer
         std::size_t const allocationsize =
-          _max_size + sizeof (zmq::atomic_counter_t)
+          sizeof (header_t) + counters_offset (_max_size)
           + _max_counters * sizeof (zmq::msg_t::content_t);
 
-        _buf = static_cast<unsigned char *> (std::malloc (allocationsize));
+        int pool_class = -1;
+        _buf = static_cast<unsigned char *> (
+          msg_pool_t::allocate (allocationsize, &pool_class));
+        if (!_buf) {
+            pool_class = -1;
+            _buf = static_cast<unsigned char *> (std::malloc (allocationsize));
+        }
         alloc_assert (_buf);
 
-        new (_buf) atomic_counter_t (1);
+        header_t *header = new (_buf) header_t;
+        header->refcnt.set (1);
+        header->pool_class = pool_class;
     } else {
         // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (_buf);
-        c->set (1);
+        header_t *header = reinterpret_cast<header_t *> (_buf);
+        header->refcnt.set (1);
     }
 
     _buf_size = _max_size;
+    if (_adaptive)
+        _copy_below =
+          (_max_size + max_shared_messages - 1) / max_shared_messages;
     _msg_content = reinterpret_cast<zmq::msg_t::content_t *> (
-      _buf + sizeof (atomic_counter_t) + _max_size);
-    return _buf + sizeof (zmq::atomic_counter_t);
+      _buf + sizeof (header_t) + counters_offset (_max_size));
+    return _buf + sizeof (header_t);
 }
 
 void zmq::shared_message_memory_allocator::deallocate ()
 {
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (_buf);
-    if (_buf && !c->sub (1)) {
-        c->~atomic_counter_t ();
-        std::free (_buf);
-    }
+    header_t *header = reinterpret_cast<header_t *> (_buf);
+    if (_buf && !header->refcnt.sub (1))
+        free_buffer (_buf);
     clear ();
 }
 
@@ -95,22 +136,39 @@ void zmq::shared_message_memory_allocator::clear ()
     _msg_content = NULL;
 }
 
+std::size_t zmq::shared_message_memory_allocator::target_size () const
+{
+    const std::size_t wanted = _average_size * messages_per_buffer;
+    std::size_t target = _min_size;
+    while (target < wanted && target / _min_size < max_growth)
+        target *= 2;
+    return target;
+}
+
+void zmq::shared_message_memory_allocator::free_buffer (unsigned char *buf_)
+{
+    header_t *header = reinterpret_cast<header_t *> (buf_);
+    const int pool_class = header->pool_class;
+    header->~header_t ();
+    if (pool_class >= 0)
+        msg_pool_t::deallocate (buf_, pool_class);
+    else
+        std::free (buf_);
+}
+
 void zmq::shared_message_memory_allocator::inc_ref ()
 {
-    (reinterpret_cast<zmq::atomic_counter_t *> (_buf))->add (1);
+    (reinterpret_cast<header_t *> (_buf))->refcnt.add (1);
 }
 
 void zmq::shared_message_memory_allocator::call_dec_ref (void *, void *hint_)
 {
     zmq_assert (hint_);
     unsigned char *buf = static_cast<unsigned char *> (hint_);
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (buf);
+    header_t *header = reinterpret_cast<header_t *> (buf);
 
-    if (!c->sub (1)) {
-        c->~atomic_counter_t ();
-        std::free (buf);
-        buf = NULL;
-    }
+    if (!header->refcnt.sub (1))
+        free_buffer (buf);
 }
 
 
@@ -121,5 +179,5 @@ std::size_t zmq::shared_message_memory_allocator::size () const
 
 unsigned char *zmq::shared_message_memory_allocator::data ()
 {
-    return _buf + sizeof (zmq::atomic_counter_t);
+    return _buf + sizeof (header_t);
 }
@@ -50,6 +50,15 @@ class c_single_allocator
 // from zero to one, gets passed to the user application, processed in the user thread and deleted
 // which would then deallocate the buffer. The drawback is that the buffer may be allocated longer
 // than necessary because it is only deleted when allocate is called the next time.
+//
+// Unless created for a maximum number of messages, the allocator adapts the
+// buffer to the traffic. Each new buffer is sized to hold a few messages of
+// the average size seen so far, between the configured size and a multiple
+// of it, so that large messages are received in place instead of being
+// copied into separate allocations. Messages much smaller than the buffer
+// are copied out of it, as a single long-lived message would otherwise keep
+// the whole buffer alive. Buffers come from the message pool when it is
+// enabled, so that the ones released by the application are recycled.
 class shared_message_memory_allocator
 {
   public:
@@ -92,12 +101,43 @@ class shared_message_memory_allocator
 
     void advance_content () { _msg_content++; }
 
+    // Records the size of a message being decoded.
+    void add_message_size (std::size_t size_)
+    {
+        _average_size = _average_size - _average_size / 8 + size_ / 8;
+    }
+
+    // Returns true if a message of size_ bytes is to be built on the buffer
+    // rather than copied out of it.
+    bool zero_copy (std::size_t size_) const { return size_ >= _copy_below; }
+
   private:
+    struct header_t
+    {
+        zmq::atomic_counter_t refcnt;
+
+        //  Size class of the message pool, -1 if malloc'd.
+        int pool_class;
+    };
+
     void clear ();
 
+    //  Size of the next buffer, based on the average message size.
+    std::size_t target_size () const;
+
+    static void free_buffer (unsigned char *buf_);
+
     unsigned char *_buf;
     std::size_t _buf_size;
-    const std::size_t _max_size;
+
+    //  Size of the current buffer and the configured size.
+    std::size_t _max_size;
+    const std::size_t _min_size;
+
+    const bool _adaptive;
+    std::size_t _average_size;
+    std::size_t _copy_below;
+
     zmq::msg_t::content_t *_msg_content;
     std::size_t _max_counters;
 };
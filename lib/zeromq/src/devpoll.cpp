@@ -159,6 +159,7 @@ void zmq::devpoll_t::loop ()
         if (n == -1 && errno == EINTR)
             continue;
         errno_assert (n != -1);
+        add_events (n);
 
         for (int i = 0; i < n; i++) {
             fd_entry_t *fd_ptr = &fd_table[ev_buf[i].fd];
@@ -1,20 +1,41 @@
 /* SPDX-License-Identifier: MPL-2.0 */
 
 #include "precompiled.hpp"
+#include <algorithm>
+#include <new>
+
 #include "dist.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
 #include "likely.hpp"
+#include "config.hpp"
+#include "fanout.hpp"
 
 zmq::dist_t::dist_t () :
-    _matching (0), _active (0), _eligible (0), _more (false)
+    _matching (0),
+    _active (0),
+    _eligible (0),
+    _more (false),
+    _fanout (NULL),
+    _fanout_msg (NULL),
+    _fanout_tasks (0)
 {
 }
 
 zmq::dist_t::~dist_t ()
 {
     zmq_assert (_pipes.empty ());
+    LIBZMQ_DELETE (_fanout);
+}
+
+void zmq::dist_t::set_fanout (thread_ctx_t *ctx_, int threads_)
+{
+    LIBZMQ_DELETE (_fanout);
+    if (threads_ > 0) {
+        _fanout = new (std::nothrow) fanout_t (ctx_, threads_);
+        alloc_assert (_fanout);
+    }
 }
 
 void zmq::dist_t::attach (pipe_t *pipe_)
@@ -152,7 +173,20 @@ void zmq::dist_t::distribute (msg_t *msg_)
         return;
     }
 
+    //  Split wide fan-outs between the sending thread and the helpers.
+    int tasks = 1;
+    if (_fanout && _matching >= 2 * fanout_min_pipes)
+        tasks = static_cast<int> (
+          std::min (_matching / fanout_min_pipes,
+                    static_cast<pipes_t::size_type> (_fanout->threads () + 1)));
+
     if (msg_->is_vsm ()) {
+        if (tasks > 1) {
+            distribute_parallel (msg_, tasks);
+            const int rc = msg_->init ();
+            errno_assert (rc == 0);
+            return;
+        }
         for (pipes_t::size_type i = 0; i < _matching;) {
             if (!write (_pipes[i], msg_)) {
                 //  Use same index again because entry will have been removed.
@@ -171,12 +205,16 @@ void zmq::dist_t::distribute (msg_t *msg_)
 
     //  Push copy of the message to each matching pipe.
     int failed = 0;
-    for (pipes_t::size_type i = 0; i < _matching;) {
-        if (!write (_pipes[i], msg_)) {
-            ++failed;
-            //  Use same index again because entry will have been removed.
-        } else {
-            ++i;
+    if (tasks > 1)
+        failed = distribute_parallel (msg_, tasks);
+    else {
+        for (pipes_t::size_type i = 0; i < _matching;) {
+            if (!write (_pipes[i], msg_)) {
+                ++failed;
+                //  Use same index again because entry will have been removed.
+            } else {
+                ++i;
+            }
         }
     }
     if (unlikely (failed))
@@ -193,15 +231,47 @@ bool zmq::dist_t::has_out ()
     return true;
 }
 
+int zmq::dist_t::distribute_parallel (msg_t *msg_, int tasks_)
+{
+    //  The helpers only write to the pipes and record the outcome. The
+    //  pipes that turned out to be full are made inactive afterwards, as
+    //  that reorders the array the helpers work on.
+    _fanout_msg = msg_;
+    _fanout_tasks = tasks_;
+    _written.resize (_matching);
+    _fanout->run (write_slice, this, tasks_);
+    _fanout_msg = NULL;
+
+    int failed = 0;
+    for (pipes_t::size_type i = _matching; i-- != 0;)
+        if (!_written[i]) {
+            deactivate (_pipes[i]);
+            ++failed;
+        }
+    return failed;
+}
+
+void zmq::dist_t::write_slice (void *arg_, int index_)
+{
+    dist_t *const self = static_cast<dist_t *> (arg_);
+    const pipes_t::size_type begin =
+      self->_matching * index_ / self->_fanout_tasks;
+    const pipes_t::size_type end =
+      self->_matching * (index_ + 1) / self->_fanout_tasks;
+    const bool flush = !(self->_fanout_msg->flags () & msg_t::more);
+
+    for (pipes_t::size_type i = begin; i != end; ++i) {
+        pipe_t *const pipe = self->_pipes[i];
+        self->_written[i] = pipe->write (self->_fanout_msg);
+        if (self->_written[i] && flush)
+            pipe->flush ();
+    }
+}
+
 bool zmq::dist_t::write (pipe_t *pipe_, msg_t *msg_)
 {
     if (!pipe_->write (msg_)) {
-        _pipes.swap (_pipes.index (pipe_), _matching - 1);
-        _matching--;
-        _pipes.swap (_pipes.index (pipe_), _active - 1);
-        _active--;
-        _pipes.swap (_active, _eligible - 1);
-        _eligible--;
+        deactivate (pipe_);
         return false;
     }
     if (!(msg_->flags () & msg_t::more))
@@ -209,6 +279,16 @@ bool zmq::dist_t::write (pipe_t *pipe_, msg_t *msg_)
     return true;
 }
 
+void zmq::dist_t::deactivate (pipe_t *pipe_)
+{
+    _pipes.swap (_pipes.index (pipe_), _matching - 1);
+    _matching--;
+    _pipes.swap (_pipes.index (pipe_), _active - 1);
+    _active--;
+    _pipes.swap (_active, _eligible - 1);
+    _eligible--;
+}
+
 bool zmq::dist_t::check_hwm ()
 {
     for (pipes_t::size_type i = 0; i < _matching; ++i)
@@ -12,6 +12,8 @@ namespace zmq
 {
 class pipe_t;
 class msg_t;
+class fanout_t;
+class thread_ctx_t;
 
 //  Class manages a set of outbound pipes. It sends each messages to
 //  each of them.
@@ -54,14 +56,30 @@ class dist_t
     // check HWM of all pipes matching
     bool check_hwm ();
 
+    //  Writes messages matching many pipes from threads_ helper threads
+    //  started with the scheduling parameters of ctx_, in addition to
+    //  the sending thread. 0 stops the helpers.
+    void set_fanout (zmq::thread_ctx_t *ctx_, int threads_);
+
   private:
     //  Write the message to the pipe. Make the pipe inactive if writing
     //  fails. In such a case false is returned.
     bool write (zmq::pipe_t *pipe_, zmq::msg_t *msg_);
 
+    //  Make a pipe whose write failed inactive.
+    void deactivate (zmq::pipe_t *pipe_);
+
     //  Put the message to all active pipes.
     void distribute (zmq::msg_t *msg_);
 
+    //  Put the message to the matching pipes from the helper threads and
+    //  return the number of pipes it could not be written to.
+    int distribute_parallel (zmq::msg_t *msg_, int tasks_);
+
+    //  Fan-out task writing the message to one slice of the matching
+    //  pipes.
+    static void write_slice (void *arg_, int index_);
+
     //  List of outbound pipes.
     typedef array_t<zmq::pipe_t, 2> pipes_t;
     pipes_t _pipes;
@@ -84,6 +102,16 @@ class dist_t
     //  True if last we are in the middle of a multipart message.
     bool _more;
 
+    //  Helper threads for parallel fan-out, or NULL.
+    fanout_t *_fanout;
+
+    //  The message being written by the helpers, the number of slices
+    //  the matching pipes are split into, and whether each matching pipe
+    //  was written to.
+    zmq::msg_t *_fanout_msg;
+    int _fanout_tasks;
+    std::vector<unsigned char> _written;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (dist_t)
 };
 }
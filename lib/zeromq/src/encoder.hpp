@@ -37,9 +37,26 @@ template <typename T> class encoder_base_t : public i_encoder
         _in_progress (NULL)
     {
         alloc_assert (_buf);
+#if defined ZMQ_HAVE_WRITEV
+        _buf_used = 0;
+        _pinned_count = 0;
+        for (int i = 0; i != max_pinned; i++) {
+            const int rc = _pinned[i].init ();
+            errno_assert (rc == 0);
+        }
+#endif
     }
 
-    ~encoder_base_t () ZMQ_OVERRIDE { free (_buf); }
+    ~encoder_base_t () ZMQ_OVERRIDE
+    {
+#if defined ZMQ_HAVE_WRITEV
+        for (int i = 0; i != max_pinned; i++) {
+            const int rc = _pinned[i].close ();
+            errno_assert (rc == 0);
+        }
+#endif
+        free (_buf);
+    }
 
     //  The function returns a batch of binary data. The data
     //  are filled to a supplied buffer. If no buffer is supplied (data_
@@ -106,6 +123,106 @@ template <typename T> class encoder_base_t : public i_encoder
         (static_cast<T *> (this)->*_next) ();
     }
 
+#if defined ZMQ_HAVE_WRITEV
+    bool encode_iov (iovec *iov_,
+                     int *iovcnt_,
+                     int max_iovcnt_,
+                     size_t threshold_,
+                     size_t *size_) ZMQ_FINAL
+    {
+        while (_in_progress) {
+            if (!_to_write) {
+                if (_new_msg_flag) {
+                    int rc = _in_progress->close ();
+                    errno_assert (rc == 0);
+                    rc = _in_progress->init ();
+                    errno_assert (rc == 0);
+                    _in_progress = NULL;
+                    break;
+                }
+                (static_cast<T *> (this)->*_next) ();
+                continue;
+            }
+
+            //  A large body that is the last part of the message is
+            //  referenced rather than copied. The message is moved aside
+            //  so that the engine can go on with the next one. Bodies
+            //  that were copied elsewhere (e.g. to be masked) are copied.
+            unsigned char *const data =
+              static_cast<unsigned char *> (_in_progress->data ());
+            if (_new_msg_flag && _to_write >= threshold_
+                && _pinned_count < max_pinned && _write_pos >= data
+                && _write_pos + _to_write <= data + _in_progress->size ()) {
+                if (*iovcnt_ == max_iovcnt_)
+                    return false;
+                const size_t offset = _write_pos - data;
+                msg_t &pinned = _pinned[_pinned_count++];
+                int rc = pinned.move (*_in_progress);
+                errno_assert (rc == 0);
+                iov_[*iovcnt_].iov_base =
+                  static_cast<unsigned char *> (pinned.data ()) + offset;
+                iov_[*iovcnt_].iov_len = _to_write;
+                ++*iovcnt_;
+                *size_ += _to_write;
+                _write_pos = NULL;
+                _to_write = 0;
+                _in_progress = NULL;
+                break;
+            }
+
+            //  Copy to the buffer, extending the last entry if it ends
+            //  where the copy starts.
+            const size_t to_copy = std::min (_to_write, _buf_size - _buf_used);
+            if (!to_copy)
+                return false;
+            unsigned char *const dest = _buf + _buf_used;
+            if (*iovcnt_
+                && static_cast<unsigned char *> (iov_[*iovcnt_ - 1].iov_base)
+                       + iov_[*iovcnt_ - 1].iov_len
+                     == dest)
+                iov_[*iovcnt_ - 1].iov_len += to_copy;
+            else {
+                if (*iovcnt_ == max_iovcnt_)
+                    return false;
+                iov_[*iovcnt_].iov_base = dest;
+                iov_[*iovcnt_].iov_len = to_copy;
+                ++*iovcnt_;
+            }
+            memcpy (dest, _write_pos, to_copy);
+            _buf_used += to_copy;
+            *size_ += to_copy;
+            _write_pos += to_copy;
+            _to_write -= to_copy;
+        }
+        return true;
+    }
+
+    void release_iov () ZMQ_FINAL
+    {
+        for (int i = 0; i != _pinned_count; i++) {
+            int rc = _pinned[i].close ();
+            errno_assert (rc == 0);
+            rc = _pinned[i].init ();
+            errno_assert (rc == 0);
+        }
+        _pinned_count = 0;
+        _buf_used = 0;
+    }
+
+    msg_t *iov_msg (const void *data_) ZMQ_FINAL
+    {
+        const unsigned char *const pos =
+          static_cast<const unsigned char *> (data_);
+        for (int i = 0; i != _pinned_count; i++) {
+            const unsigned char *const data =
+              static_cast<const unsigned char *> (_pinned[i].data ());
+            if (pos >= data && pos < data + _pinned[i].size ())
+                return &_pinned[i];
+        }
+        return NULL;
+    }
+#endif
+
   protected:
     //  Prototype of state machine action.
     typedef void (T::*step_t) ();
@@ -144,6 +261,19 @@ template <typename T> class encoder_base_t : public i_encoder
 
     msg_t *_in_progress;
 
+#if defined ZMQ_HAVE_WRITEV
+    //  Part of the buffer taken by the gather list.
+    size_t _buf_used;
+
+    //  Messages whose bodies are referenced by the gather list.
+    enum
+    {
+        max_pinned = 32
+    };
+    msg_t _pinned[max_pinned];
+    int _pinned_count;
+#endif
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (encoder_base_t)
 };
 }
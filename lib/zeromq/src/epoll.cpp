@@ -145,21 +145,19 @@ void zmq::epoll_t::loop ()
         //  Execute any due timers.
         const int timeout = static_cast<int> (execute_timers ());
 
-        if (get_load () == 0) {
-            if (timeout == 0)
-                break;
+        //  Stop once neither file descriptors nor timers are left.
+        if (get_load () == 0 && timeout == 0)
+            break;
 
-            // TODO sleep for timeout
-            continue;
-        }
-
-        //  Wait for events.
+        //  Wait for events, without blocking while spinning.
         const int n = epoll_wait (_epoll_fd, &ev_buf[0], max_io_events,
-                                  timeout ? timeout : -1);
+                                  spin_timeout (timeout ? timeout : -1));
         if (n == -1) {
             errno_assert (errno == EINTR);
             continue;
         }
+        spun (n);
+        add_events (n);
 
         for (int i = 0; i < n; i++) {
             const poll_entry_t *const pe =
@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "fanout.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+
+#include <new>
+
+zmq::fanout_t::fanout_t (thread_ctx_t *ctx_, int threads_) :
+    _task (NULL),
+    _arg (NULL),
+    _tasks (0),
+    _pending (0),
+    _round (0),
+    _stopping (false)
+{
+    zmq_assert (threads_ > 0);
+    for (int i = 0; i != threads_; i++) {
+        worker_t *const worker = new (std::nothrow) worker_t;
+        alloc_assert (worker);
+        worker->fanout = this;
+        worker->index = i + 1;
+        _workers.push_back (worker);
+        ctx_->start_thread (worker->thread, worker_routine, worker, "Fanout");
+    }
+}
+
+zmq::fanout_t::~fanout_t ()
+{
+    {
+        scoped_lock_t locker (_sync);
+        _stopping = true;
+        _start.broadcast ();
+    }
+    for (std::vector<worker_t *>::iterator it = _workers.begin (),
+                                           end = _workers.end ();
+         it != end; ++it) {
+        (*it)->thread.stop ();
+        LIBZMQ_DELETE (*it);
+    }
+}
+
+void zmq::fanout_t::run (task_fn *task_, void *arg_, int tasks_)
+{
+    zmq_assert (tasks_ > 0 && tasks_ <= threads () + 1);
+
+    if (tasks_ > 1) {
+        scoped_lock_t locker (_sync);
+        _task = task_;
+        _arg = arg_;
+        _tasks = tasks_;
+        _pending = tasks_ - 1;
+        _round++;
+        _start.broadcast ();
+    }
+
+    task_ (arg_, 0);
+
+    if (tasks_ > 1) {
+        scoped_lock_t locker (_sync);
+        while (_pending) {
+            const int rc = _done.wait (&_sync, -1);
+            errno_assert (rc == 0);
+        }
+    }
+}
+
+void zmq::fanout_t::worker_routine (void *arg_)
+{
+    worker_t *const worker = static_cast<worker_t *> (arg_);
+    worker->fanout->loop (worker->index);
+}
+
+void zmq::fanout_t::loop (int index_)
+{
+    uint64_t round = 0;
+    scoped_lock_t locker (_sync);
+    while (true) {
+        while (_round == round && !_stopping) {
+            const int rc = _start.wait (&_sync, -1);
+            errno_assert (rc == 0);
+        }
+        if (_stopping)
+            return;
+        round = _round;
+
+        //  Helpers beyond the tasks of this round sit it out.
+        if (index_ >= _tasks)
+            continue;
+
+        task_fn *const task = _task;
+        void *const arg = _arg;
+        _sync.unlock ();
+        task (arg, index_);
+        _sync.lock ();
+
+        if (--_pending == 0)
+            _done.broadcast ();
+    }
+}
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_FANOUT_HPP_INCLUDED__
+#define __ZMQ_FANOUT_HPP_INCLUDED__
+
+#include <vector>
+
+#include "condition_variable.hpp"
+#include "macros.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+#include "thread.hpp"
+
+namespace zmq
+{
+class thread_ctx_t;
+
+//  Helper threads that run a function in parallel with the calling thread
+//  and return once all of them are done. Used by dist_t to write a message
+//  to many pipes at once.
+//
+//  The caller does not touch the data handed to the helpers until run
+//  returns, so the helpers can use objects that otherwise belong to the
+//  calling thread, such as the pipes of a socket.
+class fanout_t
+{
+  public:
+    typedef void (task_fn) (void *arg_, int index_);
+
+    //  Starts threads_ helper threads with the scheduling parameters
+    //  of ctx_.
+    fanout_t (thread_ctx_t *ctx_, int threads_);
+
+    //  Stops the helper threads.
+    ~fanout_t ();
+
+    int threads () const { return static_cast<int> (_workers.size ()); }
+
+    //  Calls task_ (arg_, i) for each i in [0, tasks_), index 0 on the
+    //  calling thread and the others on the helpers. tasks_ is at most
+    //  threads () + 1.
+    void run (task_fn *task_, void *arg_, int tasks_);
+
+  private:
+    struct worker_t
+    {
+        fanout_t *fanout;
+        int index;
+        thread_t thread;
+    };
+
+    static void worker_routine (void *arg_);
+    void loop (int index_);
+
+    std::vector<worker_t *> _workers;
+
+    //  The task of the current round, and the number of helpers yet to
+    //  complete it.
+    task_fn *_task;
+    void *_arg;
+    int _tasks;
+    int _pending;
+
+    //  Incremented for each round, so helpers can tell a new one from a
+    //  spurious wake-up.
+    uint64_t _round;
+    bool _stopping;
+
+    mutex_t _sync;
+    condition_variable_t _start;
+    condition_variable_t _done;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (fanout_t)
+};
+}
+
+#endif
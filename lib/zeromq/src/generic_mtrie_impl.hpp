@@ -163,6 +163,8 @@ void generic_mtrie_t<T>::rm (value_t *pipe_,
 
                 if (it.node->_pipes->empty ()) {
                     LIBZMQ_DELETE (it.node->_pipes);
+                    zmq_assert (_num_prefixes.get () > 0);
+                    _num_prefixes.sub (1);
                 }
             }
 
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_GENERIC_RADIX_MTRIE_HPP_INCLUDED__
+#define __ZMQ_GENERIC_RADIX_MTRIE_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "macros.hpp"
+#include "stdint.hpp"
+#include "atomic_counter.hpp"
+
+namespace zmq
+{
+//  Multi-trie with the same interface as generic_mtrie_t, laid out for
+//  large numbers of subscriptions.
+//
+//  Chains of nodes with a single child are compressed into one node
+//  holding the whole run of bytes, so matching a topic compares bytes in
+//  bulk instead of following a pointer per byte. Each node keeps the
+//  first byte of each child in a small array that is searched before any
+//  child is touched. The values of a node are kept in a sorted array,
+//  with room for two of them in the node itself, instead of a std::set
+//  allocated per subscribed prefix.
+template <typename T> class generic_radix_mtrie_t
+{
+  public:
+    typedef T value_t;
+    typedef const unsigned char *prefix_t;
+
+    enum rm_result
+    {
+        not_found,
+        last_value_removed,
+        values_remain
+    };
+
+    generic_radix_mtrie_t ();
+    ~generic_radix_mtrie_t ();
+
+    //  Add key to the trie. Returns true iff no entry with the same prefix_
+    //  and size_ existed before.
+    bool add (prefix_t prefix_, size_t size_, value_t *value_);
+
+    //  Remove all entries with a specific value from the trie.
+    //  The call_on_uniq_ flag controls if the callback is invoked
+    //  when there are no entries left on a prefix only (true)
+    //  or on every removal (false). The arg_ argument is passed
+    //  through to the callback function.
+    template <typename Arg>
+    void rm (value_t *value_,
+             void (*func_) (const unsigned char *data_, size_t size_, Arg arg_),
+             Arg arg_,
+             bool call_on_uniq_);
+
+    //  Removes a specific entry from the trie.
+    //  Returns the result of the operation.
+    rm_result rm (prefix_t prefix_, size_t size_, value_t *value_);
+
+    //  Calls a callback function for all matching entries, i.e. any node
+    //  corresponding to data_ or a prefix of it. The arg_ argument
+    //  is passed through to the callback function.
+    template <typename Arg>
+    void match (prefix_t data_,
+                size_t size_,
+                void (*func_) (value_t *value_, Arg arg_),
+                Arg arg_);
+
+    //  Retrieve the number of prefixes stored in this trie (added - removed)
+    //  Note this is a multithread safe function.
+    uint32_t num_prefixes () const { return _num_prefixes.get (); }
+
+  private:
+    //  Values stored in the node itself before an array is allocated.
+    enum
+    {
+        inline_capacity = 2
+    };
+
+    //  A node is allocated together with its prefix, which follows it.
+    //  The prefix of a child starts with the byte its parent files it
+    //  under. The root has an empty prefix and is never removed.
+    struct node_t
+    {
+        uint32_t prefix_size;
+        uint32_t child_count;
+        uint32_t child_capacity;
+        uint32_t value_count;
+        uint32_t value_capacity;
+
+        //  The child pointers, followed by the first byte of each child.
+        node_t **children;
+
+        union
+        {
+            value_t *inline_values[inline_capacity];
+            value_t **heap_values;
+        } values;
+    };
+
+    //  A node being visited by rm, with the size of its key.
+    struct frame_t
+    {
+        node_t *node;
+        size_t size;
+        uint32_t next_child;
+    };
+
+    static node_t *make_node (prefix_t prefix_, size_t size_);
+    static void destroy (node_t *node_);
+
+    static unsigned char *prefix (node_t *node_);
+    static value_t **values (node_t *node_);
+    static unsigned char *first_bytes (node_t *node_);
+
+    //  Returns the index of the child filed under c_, or -1.
+    static int find_child (node_t *node_, unsigned char c_);
+    static void add_child (node_t *node_, node_t *child_);
+    static void remove_child (node_t *node_, uint32_t index_);
+
+    //  Returns false if the value was already there.
+    static bool add_value (node_t *node_, value_t *value_);
+
+    //  Returns false if the value was not there.
+    static bool remove_value (node_t *node_, value_t *value_);
+
+    //  Removes the children of node_ that hold no values and no children,
+    //  and merges those holding no values with their only child.
+    static void tidy (node_t *node_);
+
+    node_t *_root;
+
+    atomic_counter_t _num_prefixes;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (generic_radix_mtrie_t)
+};
+}
+
+#endif
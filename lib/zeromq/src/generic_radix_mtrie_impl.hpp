@@ -0,0 +1,391 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_GENERIC_RADIX_MTRIE_IMPL_HPP_INCLUDED__
+#define __ZMQ_GENERIC_RADIX_MTRIE_IMPL_HPP_INCLUDED__
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "err.hpp"
+#include "macros.hpp"
+#include "generic_radix_mtrie.hpp"
+
+namespace zmq
+{
+template <typename T>
+generic_radix_mtrie_t<T>::generic_radix_mtrie_t () :
+    _root (make_node (NULL, 0)), _num_prefixes (0)
+{
+}
+
+template <typename T> generic_radix_mtrie_t<T>::~generic_radix_mtrie_t ()
+{
+    //  Subscribers control the depth of the trie, so it is not destroyed
+    //  recursively.
+    std::vector<node_t *> stack (1, _root);
+    while (!stack.empty ()) {
+        node_t *const node = stack.back ();
+        stack.pop_back ();
+        for (uint32_t i = 0; i != node->child_count; i++)
+            stack.push_back (node->children[i]);
+        destroy (node);
+    }
+}
+
+template <typename T>
+typename generic_radix_mtrie_t<T>::node_t *
+generic_radix_mtrie_t<T>::make_node (prefix_t prefix_, size_t size_)
+{
+    node_t *const node =
+      static_cast<node_t *> (malloc (sizeof (node_t) + size_));
+    alloc_assert (node);
+    node->prefix_size = static_cast<uint32_t> (size_);
+    node->child_count = 0;
+    node->child_capacity = 0;
+    node->value_count = 0;
+    node->value_capacity = inline_capacity;
+    node->children = NULL;
+    if (size_)
+        memcpy (prefix (node), prefix_, size_);
+    return node;
+}
+
+template <typename T> void generic_radix_mtrie_t<T>::destroy (node_t *node_)
+{
+    if (node_->value_capacity > inline_capacity)
+        free (node_->values.heap_values);
+    free (node_->children);
+    free (node_);
+}
+
+template <typename T>
+unsigned char *generic_radix_mtrie_t<T>::prefix (node_t *node_)
+{
+    return reinterpret_cast<unsigned char *> (node_ + 1);
+}
+
+template <typename T>
+typename generic_radix_mtrie_t<T>::value_t **
+generic_radix_mtrie_t<T>::values (node_t *node_)
+{
+    return node_->value_capacity > inline_capacity
+             ? node_->values.heap_values
+             : node_->values.inline_values;
+}
+
+template <typename T>
+unsigned char *generic_radix_mtrie_t<T>::first_bytes (node_t *node_)
+{
+    return reinterpret_cast<unsigned char *> (node_->children
+                                              + node_->child_capacity);
+}
+
+template <typename T>
+int generic_radix_mtrie_t<T>::find_child (node_t *node_, unsigned char c_)
+{
+    if (!node_->child_count)
+        return -1;
+    const unsigned char *const bytes = first_bytes (node_);
+    const void *const found = memchr (bytes, c_, node_->child_count);
+    return found ? static_cast<int> (static_cast<const unsigned char *> (found)
+                                     - bytes)
+                 : -1;
+}
+
+template <typename T>
+void generic_radix_mtrie_t<T>::add_child (node_t *node_, node_t *child_)
+{
+    if (node_->child_count == node_->child_capacity) {
+        //  There are at most 256 children, one per first byte.
+        const uint32_t capacity =
+          std::min (node_->child_capacity ? node_->child_capacity * 2 : 2,
+                    static_cast<uint32_t> (256));
+        node_t **const children = static_cast<node_t **> (
+          malloc (capacity * (sizeof (node_t *) + 1)));
+        alloc_assert (children);
+        if (node_->child_count) {
+            memcpy (children, node_->children,
+                    node_->child_count * sizeof (node_t *));
+            memcpy (reinterpret_cast<unsigned char *> (children + capacity),
+                    first_bytes (node_), node_->child_count);
+        }
+        free (node_->children);
+        node_->children = children;
+        node_->child_capacity = capacity;
+    }
+    node_->children[node_->child_count] = child_;
+    first_bytes (node_)[node_->child_count] = *prefix (child_);
+    node_->child_count++;
+}
+
+template <typename T>
+void generic_radix_mtrie_t<T>::remove_child (node_t *node_, uint32_t index_)
+{
+    //  The order of the children does not matter, the last one takes the
+    //  place of the removed one.
+    const uint32_t last = --node_->child_count;
+    node_->children[index_] = node_->children[last];
+    first_bytes (node_)[index_] = first_bytes (node_)[last];
+    if (!node_->child_count) {
+        free (node_->children);
+        node_->children = NULL;
+        node_->child_capacity = 0;
+    }
+}
+
+template <typename T>
+bool generic_radix_mtrie_t<T>::add_value (node_t *node_, value_t *value_)
+{
+    value_t **const begin = values (node_);
+    value_t **const end = begin + node_->value_count;
+    value_t **const pos =
+      std::lower_bound (begin, end, value_, std::less<value_t *> ());
+    if (pos != end && *pos == value_)
+        return false;
+
+    const size_t index = pos - begin;
+    if (node_->value_count == node_->value_capacity) {
+        const uint32_t capacity = node_->value_capacity * 2;
+        value_t **const heap_values =
+          static_cast<value_t **> (malloc (capacity * sizeof (value_t *)));
+        alloc_assert (heap_values);
+        memcpy (heap_values, begin, node_->value_count * sizeof (value_t *));
+        if (node_->value_capacity > inline_capacity)
+            free (begin);
+        node_->values.heap_values = heap_values;
+        node_->value_capacity = capacity;
+    }
+
+    value_t **const array = values (node_);
+    memmove (array + index + 1, array + index,
+             (node_->value_count - index) * sizeof (value_t *));
+    array[index] = value_;
+    node_->value_count++;
+    return true;
+}
+
+template <typename T>
+bool generic_radix_mtrie_t<T>::remove_value (node_t *node_, value_t *value_)
+{
+    value_t **const begin = values (node_);
+    value_t **const end = begin + node_->value_count;
+    value_t **const pos =
+      std::lower_bound (begin, end, value_, std::less<value_t *> ());
+    if (pos == end || *pos != value_)
+        return false;
+
+    memmove (pos, pos + 1, (end - pos - 1) * sizeof (value_t *));
+    node_->value_count--;
+    if (!node_->value_count && node_->value_capacity > inline_capacity) {
+        free (node_->values.heap_values);
+        node_->value_capacity = inline_capacity;
+    }
+    return true;
+}
+
+template <typename T> void generic_radix_mtrie_t<T>::tidy (node_t *node_)
+{
+    //  Removing a child moves the last one into its place, so the children
+    //  are visited from the last one down.
+    for (uint32_t i = node_->child_count; i-- != 0;) {
+        node_t *const child = node_->children[i];
+        if (child->value_count)
+            continue;
+
+        if (!child->child_count) {
+            remove_child (node_, i);
+            destroy (child);
+        } else if (child->child_count == 1) {
+            //  The grandchild takes over the prefix of the child.
+            node_t *grandchild = child->children[0];
+            const uint32_t size = child->prefix_size + grandchild->prefix_size;
+            grandchild = static_cast<node_t *> (
+              realloc (grandchild, sizeof (node_t) + size));
+            alloc_assert (grandchild);
+            memmove (prefix (grandchild) + child->prefix_size,
+                     prefix (grandchild), grandchild->prefix_size);
+            memcpy (prefix (grandchild), prefix (child), child->prefix_size);
+            grandchild->prefix_size = size;
+            node_->children[i] = grandchild;
+            destroy (child);
+        }
+    }
+}
+
+template <typename T>
+bool generic_radix_mtrie_t<T>::add (prefix_t prefix_,
+                                    size_t size_,
+                                    value_t *value_)
+{
+    node_t *node = _root;
+    while (size_) {
+        const int index = find_child (node, *prefix_);
+        if (index < 0) {
+            node_t *const leaf = make_node (prefix_, size_);
+            add_child (node, leaf);
+            node = leaf;
+            break;
+        }
+
+        node_t *const child = node->children[index];
+        const unsigned char *const child_prefix = prefix (child);
+        const size_t limit = std::min (size_, size_t (child->prefix_size));
+        size_t common = 1;
+        while (common != limit && child_prefix[common] == prefix_[common])
+            common++;
+        prefix_ += common;
+        size_ -= common;
+
+        if (common == child->prefix_size) {
+            node = child;
+            continue;
+        }
+
+        //  The key diverges within the prefix of the child. A new node takes
+        //  the common part and the child keeps the rest.
+        node_t *const split = make_node (child_prefix, common);
+        child->prefix_size -= static_cast<uint32_t> (common);
+        memmove (prefix (child), prefix (child) + common, child->prefix_size);
+        node->children[index] = split;
+        add_child (split, child);
+
+        node = split;
+        if (size_) {
+            node_t *const leaf = make_node (prefix_, size_);
+            add_child (split, leaf);
+            node = leaf;
+        }
+        break;
+    }
+
+    const bool result = !node->value_count;
+    add_value (node, value_);
+    if (result)
+        _num_prefixes.add (1);
+    return result;
+}
+
+template <typename T>
+template <typename Arg>
+void generic_radix_mtrie_t<T>::rm (value_t *value_,
+                                   void (*func_) (prefix_t data_,
+                                                  size_t size_,
+                                                  Arg arg_),
+                                   Arg arg_,
+                                   bool call_on_uniq_)
+{
+    //  Depth-first traversal with an explicit stack, since subscribers
+    //  control the depth of the trie. The key of each node is assembled in
+    //  buff. Nodes are tidied once all their children have been visited.
+    std::vector<frame_t> stack;
+    std::vector<unsigned char> buff;
+
+    const frame_t root = {_root, 0, 0};
+    stack.push_back (root);
+    node_t *node = _root;
+    size_t size = 0;
+    while (true) {
+        if (node && remove_value (node, value_)) {
+            if (!call_on_uniq_ || !node->value_count)
+                func_ (size ? &buff[0] : NULL, size, arg_);
+            if (!node->value_count) {
+                zmq_assert (_num_prefixes.get () > 0);
+                _num_prefixes.sub (1);
+            }
+        }
+
+        frame_t &top = stack.back ();
+        if (top.next_child == top.node->child_count) {
+            tidy (top.node);
+            stack.pop_back ();
+            if (stack.empty ())
+                break;
+            node = NULL;
+            continue;
+        }
+
+        node = top.node->children[top.next_child++];
+        size = top.size + node->prefix_size;
+        if (buff.size () < size)
+            buff.resize (size + 256);
+        memcpy (&buff[top.size], prefix (node), node->prefix_size);
+        const frame_t frame = {node, size, 0};
+        stack.push_back (frame);
+    }
+}
+
+template <typename T>
+typename generic_radix_mtrie_t<T>::rm_result
+generic_radix_mtrie_t<T>::rm (prefix_t prefix_, size_t size_, value_t *value_)
+{
+    //  The parent and grandparent of the node are tidied afterwards.
+    node_t *grandparent = NULL;
+    node_t *parent = NULL;
+    node_t *node = _root;
+    while (size_) {
+        const int index = find_child (node, *prefix_);
+        if (index < 0)
+            return not_found;
+        node_t *const child = node->children[index];
+        if (child->prefix_size > size_
+            || memcmp (prefix (child), prefix_, child->prefix_size) != 0)
+            return not_found;
+        prefix_ += child->prefix_size;
+        size_ -= child->prefix_size;
+        grandparent = parent;
+        parent = node;
+        node = child;
+    }
+
+    if (!remove_value (node, value_))
+        return not_found;
+    if (node->value_count)
+        return values_remain;
+
+    if (parent)
+        tidy (parent);
+    if (grandparent)
+        tidy (grandparent);
+
+    zmq_assert (_num_prefixes.get () > 0);
+    _num_prefixes.sub (1);
+    return last_value_removed;
+}
+
+template <typename T>
+template <typename Arg>
+void generic_radix_mtrie_t<T>::match (prefix_t data_,
+                                      size_t size_,
+                                      void (*func_) (value_t *value_,
+                                                     Arg arg_),
+                                      Arg arg_)
+{
+    node_t *node = _root;
+    while (true) {
+        //  Signal the values attached to this node.
+        value_t **const array = values (node);
+        for (uint32_t i = 0; i != node->value_count; i++)
+            func_ (array[i], arg_);
+
+        //  If we are at the end of the message, there's nothing more to match.
+        if (!size_)
+            break;
+
+        const int index = find_child (node, *data_);
+        if (index < 0)
+            break;
+        node = node->children[index];
+        if (node->prefix_size > size_
+            || memcmp (prefix (node), data_, node->prefix_size) != 0)
+            break;
+        data_ += node->prefix_size;
+        size_ -= node->prefix_size;
+    }
+}
+}
+
+#endif
@@ -6,6 +6,10 @@
 #include "macros.hpp"
 #include "stdint.hpp"
 
+#if defined ZMQ_HAVE_WRITEV
+#include <sys/uio.h>
+#endif
+
 namespace zmq
 {
 //  Forward declaration
@@ -25,6 +29,28 @@ struct i_encoder
 
     //  Load a new message into encoder.
     virtual void load_msg (msg_t *msg_) = 0;
+
+#if defined ZMQ_HAVE_WRITEV
+    //  Appends the encoded message to a gather list. Headers and bodies
+    //  smaller than threshold_ are copied to the encoder's buffer; larger
+    //  bodies are referenced where they are and the message is kept alive
+    //  until release_iov is called. The number of bytes appended is added
+    //  to size_. Returns false if the buffer, iov_ or the messages that can
+    //  be kept ran out before the message was complete, in which case the
+    //  rest is appended by the next call, after release_iov.
+    virtual bool encode_iov (iovec *iov_,
+                             int *iovcnt_,
+                             int max_iovcnt_,
+                             size_t threshold_,
+                             size_t *size_) = 0;
+
+    //  Releases the data referenced by the gather list once it is written.
+    virtual void release_iov () = 0;
+
+    //  Returns the message kept for the gather list whose data holds
+    //  data_, or NULL if data_ is not in such a message.
+    virtual msg_t *iov_msg (const void *data_) = 0;
+#endif
 };
 }
 
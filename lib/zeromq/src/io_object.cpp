@@ -73,6 +73,11 @@ void zmq::io_object_t::cancel_timer (int id_)
     _poller->cancel_timer (this, id_);
 }
 
+void zmq::io_object_t::add_bytes (size_t bytes_)
+{
+    _poller->add_bytes (bytes_);
+}
+
 void zmq::io_object_t::in_event ()
 {
     zmq_assert (false);
@@ -41,6 +41,9 @@ class io_object_t : public i_poll_events
     void add_timer (int timeout_, int id_);
     void cancel_timer (int id_);
 
+    //  Accounts bytes transferred to the traffic of the I/O thread.
+    void add_bytes (size_t bytes_);
+
     //  i_poll_events interface implementation.
     void in_event () ZMQ_OVERRIDE;
     void out_event () ZMQ_OVERRIDE;
@@ -8,6 +8,7 @@
 #include "io_thread.hpp"
 #include "err.hpp"
 #include "ctx.hpp"
+#include "config.hpp"
 
 zmq::io_thread_t::io_thread_t (ctx_t *ctx_, uint32_t tid_) :
     object_t (ctx_, tid_),
@@ -15,10 +16,15 @@ zmq::io_thread_t::io_thread_t (ctx_t *ctx_, uint32_t tid_) :
 {
     _poller = new (std::nothrow) poller_t (*ctx_);
     alloc_assert (_poller);
+    _poller->set_spin (ctx_->get (ZMQ_IO_THREAD_SPIN));
 
     if (_mailbox.get_fd () != retired_fd) {
         _mailbox_handle = _poller->add_fd (_mailbox.get_fd (), this);
         _poller->set_pollin (_mailbox_handle);
+
+        //  Sample the traffic of the thread for choose_io_thread.
+        _poller->add_timer (io_thread_traffic_interval, this,
+                            traffic_timer_id);
     }
 }
 
@@ -29,11 +35,12 @@ zmq::io_thread_t::~io_thread_t ()
 
 void zmq::io_thread_t::start ()
 {
+    const int index =
+      static_cast<int> (get_tid () - zmq::ctx_t::reaper_tid - 1);
     char name[16] = "";
-    snprintf (name, sizeof (name), "IO/%u",
-              get_tid () - zmq::ctx_t::reaper_tid - 1);
+    snprintf (name, sizeof (name), "IO/%d", index);
     //  Start the underlying I/O thread.
-    _poller->start (name);
+    _poller->start (name, index);
 }
 
 void zmq::io_thread_t::stop ()
@@ -51,6 +58,11 @@ int zmq::io_thread_t::get_load () const
     return _poller->get_load ();
 }
 
+uint32_t zmq::io_thread_t::get_traffic () const
+{
+    return _poller->get_traffic ();
+}
+
 void zmq::io_thread_t::in_event ()
 {
     //  TODO: Do we want to limit number of commands I/O thread can
@@ -74,10 +86,11 @@ void zmq::io_thread_t::out_event ()
     zmq_assert (false);
 }
 
-void zmq::io_thread_t::timer_event (int)
+void zmq::io_thread_t::timer_event (int id_)
 {
-    //  No timers here. This function is never called.
-    zmq_assert (false);
+    zmq_assert (id_ == traffic_timer_id);
+    _poller->sample_traffic ();
+    _poller->add_timer (io_thread_traffic_interval, this, traffic_timer_id);
 }
 
 zmq::poller_t *zmq::io_thread_t::get_poller () const
@@ -89,6 +102,7 @@ zmq::poller_t *zmq::io_thread_t::get_poller () const
 void zmq::io_thread_t::process_stop ()
 {
     zmq_assert (_mailbox_handle);
+    _poller->cancel_timer (this, traffic_timer_id);
     _poller->rm_fd (_mailbox_handle);
     _poller->stop ();
 }
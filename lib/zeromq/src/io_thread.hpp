@@ -48,7 +48,16 @@ class io_thread_t ZMQ_FINAL : public object_t, public i_poll_events
     //  Returns load experienced by the I/O thread.
     int get_load () const;
 
+    //  Returns the recent traffic of the I/O thread, in events plus
+    //  kilobytes per second.
+    uint32_t get_traffic () const;
+
   private:
+    enum
+    {
+        traffic_timer_id = 0x80
+    };
+
     //  I/O thread accesses incoming commands via this mailbox.
     mailbox_t _mailbox;
 
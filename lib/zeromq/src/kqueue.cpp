@@ -173,6 +173,7 @@ void zmq::kqueue_t::loop ()
             errno_assert (errno == EINTR);
             continue;
         }
+        add_events (n);
 
         for (int i = 0; i < n; i++) {
             poll_entry_t *pe = (poll_entry_t *) ev_buf[i].udata;
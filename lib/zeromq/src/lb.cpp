@@ -5,8 +5,16 @@
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
-
-zmq::lb_t::lb_t () : _active (0), _current (0), _more (false), _dropping (false)
+#include "random.hpp"
+
+zmq::lb_t::lb_t () :
+    _active (0),
+    _current (0),
+    _more (false),
+    _dropping (false),
+    _strategy (ZMQ_LB_ROUND_ROBIN),
+    _burst (0),
+    _random (generate_random () | 1)
 {
 }
 
@@ -15,6 +23,14 @@ zmq::lb_t::~lb_t ()
     zmq_assert (_pipes.empty ());
 }
 
+void zmq::lb_t::set_strategy (int strategy_)
+{
+    zmq_assert (strategy_ >= ZMQ_LB_ROUND_ROBIN
+                && strategy_ <= ZMQ_LB_POWER_OF_TWO);
+    _strategy = strategy_;
+    _burst = 0;
+}
+
 void zmq::lb_t::attach (pipe_t *pipe_)
 {
     _pipes.push_back (pipe_);
@@ -30,6 +46,10 @@ void zmq::lb_t::pipe_terminated (pipe_t *pipe_)
     if (index == _current && _more)
         _dropping = true;
 
+    //  The pipe that takes its place starts a fresh weighted burst.
+    if (index == _current)
+        _burst = 0;
+
     //  Remove the pipe from the list; adjust number of active pipes
     //  accordingly.
     if (index < _active) {
@@ -69,6 +89,11 @@ int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
     }
 
     while (_active > 0) {
+        //  The pipe is chosen at message boundaries only; the remaining
+        //  parts of a multipart message follow the first one.
+        if (!_more)
+            _current = select ();
+
         if (_pipes[_current]->write (msg_)) {
             if (pipe_)
                 *pipe_ = _pipes[_current];
@@ -105,6 +130,7 @@ int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
             _pipes.swap (_current, _active);
         else
             _current = 0;
+        _burst = 0;
     }
 
     //  If there are no pipes we cannot send the message.
@@ -114,13 +140,11 @@ int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
     }
 
     //  If it's final part of the message we can flush it downstream and
-    //  continue round-robining (load balance).
+    //  continue load balancing.
     _more = (msg_->flags () & msg_t::more) != 0;
     if (!_more) {
         _pipes[_current]->flush ();
-
-        if (++_current >= _active)
-            _current = 0;
+        advance ();
     }
 
     //  Detach the message from the data buffer.
@@ -147,7 +171,73 @@ bool zmq::lb_t::has_out ()
         _pipes.swap (_current, _active);
         if (_current == _active)
             _current = 0;
+        _burst = 0;
     }
 
     return false;
 }
+
+zmq::lb_t::pipes_t::size_type zmq::lb_t::select ()
+{
+    switch (_strategy) {
+        case ZMQ_LB_LEAST_LOADED:
+            return select_least_loaded ();
+        case ZMQ_LB_POWER_OF_TWO:
+            return select_power_of_two ();
+        default:
+            //  Round-robin and weighted round-robin both keep sending to
+            //  the current pipe; advance () decides when to move on.
+            return _current;
+    }
+}
+
+zmq::lb_t::pipes_t::size_type zmq::lb_t::select_least_loaded ()
+{
+    pipes_t::size_type best = _current;
+    uint64_t best_depth = _pipes[_current]->get_queue_depth ();
+
+    for (pipes_t::size_type i = 1; i < _active && best_depth > 0; i++) {
+        pipes_t::size_type index = _current + i;
+        if (index >= _active)
+            index -= _active;
+
+        const uint64_t depth = _pipes[index]->get_queue_depth ();
+        if (depth < best_depth) {
+            best = index;
+            best_depth = depth;
+        }
+    }
+    return best;
+}
+
+zmq::lb_t::pipes_t::size_type zmq::lb_t::select_power_of_two ()
+{
+    if (_active < 2)
+        return 0;
+
+    //  xorshift32; quality is irrelevant here, cost is not.
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+
+    const pipes_t::size_type first = _random % _active;
+    pipes_t::size_type second = (_random >> 16) % (_active - 1);
+    if (second >= first)
+        second++;
+
+    return _pipes[second]->get_queue_depth ()
+               < _pipes[first]->get_queue_depth ()
+             ? second
+             : first;
+}
+
+void zmq::lb_t::advance ()
+{
+    if (_strategy == ZMQ_LB_WEIGHTED
+        && ++_burst < _pipes[_current]->get_lb_weight ())
+        return;
+
+    _burst = 0;
+    if (++_current >= _active)
+        _current = 0;
+}
@@ -4,6 +4,7 @@
 #define __ZMQ_LB_HPP_INCLUDED__
 
 #include "array.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
@@ -11,7 +12,9 @@ class msg_t;
 class pipe_t;
 
 //  This class manages a set of outbound pipes. On send it load balances
-//  messages fairly among the pipes.
+//  messages among the pipes. By default messages are distributed fairly
+//  in round-robin order; set_strategy selects one of the alternative
+//  ZMQ_LB_* strategies that take queue depth or pipe weight into account.
 
 class lb_t
 {
@@ -19,6 +22,10 @@ class lb_t
     lb_t ();
     ~lb_t ();
 
+    //  Selects the strategy used to pick the pipe for the next message.
+    //  Takes one of the ZMQ_LB_* values.
+    void set_strategy (int strategy_);
+
     void attach (pipe_t *pipe_);
     void activated (pipe_t *pipe_);
     void pipe_terminated (pipe_t *pipe_);
@@ -38,6 +45,22 @@ class lb_t
     typedef array_t<pipe_t, 2> pipes_t;
     pipes_t _pipes;
 
+    //  Returns the index of the active pipe the next message should be
+    //  sent to according to the current strategy.
+    pipes_t::size_type select ();
+
+    //  Returns the index of the active pipe with the fewest messages
+    //  outstanding, scanning from the current pipe so that pipes with
+    //  equal depth are still served in round-robin order.
+    pipes_t::size_type select_least_loaded ();
+
+    //  Picks two distinct active pipes at random and returns the index of
+    //  the less loaded one.
+    pipes_t::size_type select_power_of_two ();
+
+    //  Advances to the next pipe after a complete message was sent.
+    void advance ();
+
     //  Number of active pipes. All the active pipes are located at the
     //  beginning of the pipes array.
     pipes_t::size_type _active;
@@ -51,6 +74,17 @@ class lb_t
     //  True if we are dropping current message.
     bool _dropping;
 
+    //  One of the ZMQ_LB_* strategies.
+    int _strategy;
+
+    //  Number of messages sent to the current pipe in a row. Used by the
+    //  weighted strategy to give each pipe as many consecutive messages
+    //  as its weight.
+    int _burst;
+
+    //  State of the xorshift generator used by the power-of-two strategy.
+    uint32_t _random;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (lb_t)
 };
 }
@@ -61,3 +61,18 @@
     classname &operator= (const classname &);
 #endif
 #endif
+
+/******************************************************************************/
+
+//  Lock-free code paths rely on C++11 atomics and fall back to mutexes
+//  where they are not available.
+#if !defined ZMQ_FORCE_MUTEXES                                                 \
+  && ((defined __cplusplus && __cplusplus >= 201103L)                          \
+      || (defined _MSC_VER && _MSC_VER >= 1900))
+#define ZMQ_HAVE_STD_ATOMIC
+#endif
+
+//  Stream engines can gather their output with writev/sendmsg.
+#if !defined _WIN32
+#define ZMQ_HAVE_WRITEV
+#endif
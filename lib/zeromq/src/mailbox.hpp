@@ -27,6 +27,14 @@ class mailbox_t ZMQ_FINAL : public i_mailbox
 
     bool valid () const;
 
+#if defined ZMQ_HAVE_STD_ATOMIC && defined ZMQ_SIGNALER_STATS
+    //  Wake-up statistics of the underlying signaler.
+    void get_stats (signaler_t::stats_t *stats_) const
+    {
+        _signaler.get_stats (stats_);
+    }
+#endif
+
 #ifdef HAVE_FORK
     // close the file descriptors in the signaller. This is used in a forked
     // child process to close the file descriptors so that they do not interfere
@@ -12,6 +12,7 @@
 #include "stdint.hpp"
 #include "likely.hpp"
 #include "metadata.hpp"
+#include "msg_pool.hpp"
 #include "err.hpp"
 
 //  Check whether the sizes of public representation of the message (zmq_msg_t)
@@ -21,6 +22,14 @@ typedef char
   zmq_msg_size_check[2 * ((sizeof (zmq::msg_t) == sizeof (zmq_msg_t)) != 0)
                      - 1];
 
+static void free_content (zmq::msg_t::content_t *content_)
+{
+    if (content_->pool_class >= 0)
+        zmq::msg_pool_t::deallocate (content_, content_->pool_class);
+    else
+        free (content_);
+}
+
 bool zmq::msg_t::check () const
 {
     return _u.base.type >= type_min && _u.base.type <= type_max;
@@ -77,9 +86,16 @@ int zmq::msg_t::init_size (size_t size_)
         _u.lmsg.group.type = group_type_short;
         _u.lmsg.routing_id = 0;
         _u.lmsg.content = NULL;
-        if (sizeof (content_t) + size_ > size_)
-            _u.lmsg.content =
-              static_cast<content_t *> (malloc (sizeof (content_t) + size_));
+        int pool_class = -1;
+        if (sizeof (content_t) + size_ > size_) {
+            _u.lmsg.content = static_cast<content_t *> (
+              msg_pool_t::allocate (sizeof (content_t) + size_, &pool_class));
+            if (!_u.lmsg.content) {
+                pool_class = -1;
+                _u.lmsg.content = static_cast<content_t *> (
+                  malloc (sizeof (content_t) + size_));
+            }
+        }
         if (unlikely (!_u.lmsg.content)) {
             errno = ENOMEM;
             return -1;
@@ -89,6 +105,7 @@ int zmq::msg_t::init_size (size_t size_)
         _u.lmsg.content->size = size_;
         _u.lmsg.content->ffn = NULL;
         _u.lmsg.content->hint = NULL;
+        _u.lmsg.content->pool_class = pool_class;
         new (&_u.lmsg.content->refcnt) zmq::atomic_counter_t ();
     }
     return 0;
@@ -129,6 +146,7 @@ int zmq::msg_t::init_external_storage (content_t *content_,
     _u.zclmsg.content->size = size_;
     _u.zclmsg.content->ffn = ffn_;
     _u.zclmsg.content->hint = hint_;
+    _u.zclmsg.content->pool_class = -1;
     new (&_u.zclmsg.content->refcnt) zmq::atomic_counter_t ();
 
     return 0;
@@ -171,6 +189,7 @@ int zmq::msg_t::init_data (void *data_,
         _u.lmsg.content->size = size_;
         _u.lmsg.content->ffn = ffn_;
         _u.lmsg.content->hint = hint_;
+        _u.lmsg.content->pool_class = -1;
         new (&_u.lmsg.content->refcnt) zmq::atomic_counter_t ();
     }
     return 0;
@@ -259,7 +278,7 @@ int zmq::msg_t::close ()
             if (_u.lmsg.content->ffn)
                 _u.lmsg.content->ffn (_u.lmsg.content->data,
                                       _u.lmsg.content->hint);
-            free (_u.lmsg.content);
+            free_content (_u.lmsg.content);
         }
     }
 
@@ -607,7 +626,7 @@ bool zmq::msg_t::rm_refs (int refs_)
 
         if (_u.lmsg.content->ffn)
             _u.lmsg.content->ffn (_u.lmsg.content->data, _u.lmsg.content->hint);
-        free (_u.lmsg.content);
+        free_content (_u.lmsg.content);
 
         return false;
     }
@@ -47,6 +47,8 @@ class msg_t
         msg_free_fn *ffn;
         void *hint;
         zmq::atomic_counter_t refcnt;
+        //  Size class the content was taken from, -1 if malloc'd.
+        int pool_class;
     };
 
     //  Message flags.
@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "msg_pool.hpp"
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+#include "err.hpp"
+
+namespace
+{
+//  Smallest class is 2^min_shift bytes, largest 2^max_shift.
+const int min_shift = 7;
+const int max_shift = 17;
+
+//  Bytes of each class a thread keeps for itself before handing blocks
+//  over to other threads, and the least number of blocks it keeps.
+const size_t cache_bytes = 128 * 1024;
+const int min_cached = 4;
+
+struct block_t
+{
+    block_t *next;
+};
+
+struct global_list_t
+{
+    std::atomic<block_t *> head;
+    char pad[ZMQ_CACHELINE_SIZE - sizeof (std::atomic<block_t *>)];
+};
+
+global_list_t global_lists[zmq::msg_pool_t::class_count];
+
+//  Number of contexts using the pool.
+std::atomic<int> users (0);
+
+int log2_floor (size_t value_)
+{
+#if defined __GNUC__
+    return static_cast<int> (sizeof (unsigned long long) * 8 - 1
+                             - __builtin_clzll (value_));
+#else
+    int result = 0;
+    while (value_ >>= 1)
+        result++;
+    return result;
+#endif
+}
+
+//  Classes step by a quarter of the power of two below them.
+int class_of (size_t size_)
+{
+    if (size_ <= (size_t (1) << min_shift))
+        return 0;
+    const int shift = log2_floor (size_ - 1);
+    const size_t base = size_t (1) << shift;
+    const size_t step = base >> 2;
+    return (shift - min_shift) * 4
+           + static_cast<int> ((size_ - base + step - 1) / step);
+}
+
+size_t class_size (int class_)
+{
+    const size_t base = size_t (1) << (min_shift + class_ / 4);
+    return base + (class_ % 4) * (base >> 2);
+}
+
+int class_limit (int class_)
+{
+    return std::max (min_cached,
+                     static_cast<int> (cache_bytes / class_size (class_)));
+}
+
+void push_chain (int class_, block_t *first_, block_t *last_)
+{
+    std::atomic<block_t *> &head = global_lists[class_].head;
+    block_t *old = head.load (std::memory_order_relaxed);
+    do {
+        last_->next = old;
+    } while (!head.compare_exchange_weak (old, first_,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+}
+
+void free_chain (block_t *block_)
+{
+    while (block_) {
+        block_t *next = block_->next;
+        free (block_);
+        block_ = next;
+    }
+}
+
+struct thread_cache_t
+{
+    block_t *heads[zmq::msg_pool_t::class_count];
+    int counts[zmq::msg_pool_t::class_count];
+
+    thread_cache_t ()
+    {
+        memset (heads, 0, sizeof heads);
+        memset (counts, 0, sizeof counts);
+    }
+
+    //  Hands the cached blocks over to the threads that live on, or frees
+    //  them if nobody uses the pool any more.
+    ~thread_cache_t ()
+    {
+        if (users.load (std::memory_order_acquire) == 0) {
+            clear ();
+            return;
+        }
+        for (int i = 0; i != zmq::msg_pool_t::class_count; i++) {
+            if (!heads[i])
+                continue;
+            block_t *last = heads[i];
+            while (last->next)
+                last = last->next;
+            push_chain (i, heads[i], last);
+        }
+    }
+
+    void clear ()
+    {
+        for (int i = 0; i != zmq::msg_pool_t::class_count; i++) {
+            free_chain (heads[i]);
+            heads[i] = NULL;
+            counts[i] = 0;
+        }
+    }
+};
+
+thread_local thread_cache_t cache;
+}
+
+bool zmq::msg_pool_t::enable ()
+{
+    users.fetch_add (1, std::memory_order_relaxed);
+    return true;
+}
+
+void zmq::msg_pool_t::disable ()
+{
+    const int old = users.fetch_sub (1, std::memory_order_relaxed);
+    zmq_assert (old > 0);
+
+    //  Once nobody uses the pool, release what other threads gave back
+    //  and what this thread caches. Other threads free their caches the
+    //  next time they free a message, or when they exit.
+    if (old == 1) {
+        for (int i = 0; i != class_count; i++)
+            free_chain (
+              global_lists[i].head.exchange (NULL, std::memory_order_acquire));
+        cache.clear ();
+    }
+}
+
+void *zmq::msg_pool_t::allocate (size_t size_, int *class_)
+{
+    if (users.load (std::memory_order_relaxed) == 0
+        || size_ > (size_t (1) << max_shift))
+        return NULL;
+
+    const int cls = class_of (size_);
+    *class_ = cls;
+
+    block_t *block = cache.heads[cls];
+    if (!block) {
+        //  Take everything other threads have given back.
+        block =
+          global_lists[cls].head.exchange (NULL, std::memory_order_acquire);
+        if (!block)
+            return malloc (class_size (cls));
+        int count = 0;
+        for (const block_t *b = block; b; b = b->next)
+            count++;
+        cache.counts[cls] = count;
+    }
+    cache.heads[cls] = block->next;
+    cache.counts[cls]--;
+    return block;
+}
+
+void zmq::msg_pool_t::deallocate (void *block_, int class_)
+{
+    if (users.load (std::memory_order_relaxed) == 0) {
+        free (block_);
+        cache.clear ();
+        return;
+    }
+
+    block_t *block = static_cast<block_t *> (block_);
+    block->next = cache.heads[class_];
+    cache.heads[class_] = block;
+
+    //  Keep half of the limit, give the rest to the allocating threads.
+    const int limit = class_limit (class_);
+    if (++cache.counts[class_] <= limit)
+        return;
+    const int keep = limit / 2;
+    block_t *last = block;
+    for (int i = 1; i != keep; i++)
+        last = last->next;
+    block_t *rest = last->next;
+    last->next = NULL;
+    cache.counts[class_] = keep;
+
+    last = rest;
+    while (last->next)
+        last = last->next;
+    push_chain (class_, rest, last);
+}
+
+#else
+
+bool zmq::msg_pool_t::enable ()
+{
+    return false;
+}
+
+void zmq::msg_pool_t::disable ()
+{
+}
+
+void *zmq::msg_pool_t::allocate (size_t, int *)
+{
+    return NULL;
+}
+
+void zmq::msg_pool_t::deallocate (void *, int)
+{
+    zmq_assert (false);
+}
+
+#endif
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_MSG_POOL_HPP_INCLUDED__
+#define __ZMQ_MSG_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "macros.hpp"
+
+namespace zmq
+{
+//  Size-class pool for the content of long messages.
+//
+//  Sizes are rounded up to one of class_count classes, four per power of
+//  two from 128 bytes to 128 kB. Each thread caches freed blocks per class
+//  and allocates from its cache without synchronisation. Messages are
+//  typically allocated on one thread and freed on another, so a thread
+//  whose cache overflows hands half of it to a global per-class list, and
+//  a thread that runs dry takes the whole list. Both are single atomic
+//  operations on the list head.
+//
+//  The pool is process-wide, as messages are not tied to a context. It
+//  hands out blocks while at least one context has ZMQ_MSG_POOL set.
+//  Once the last such context is gone, the global lists and the cache of
+//  the thread that terminated it are freed at once. The caches of other
+//  threads cannot be touched from there; each is freed when its thread
+//  next frees a pooled message, or at the latest when the thread exits.
+
+class msg_pool_t
+{
+  public:
+    enum
+    {
+        class_count = 41
+    };
+
+    //  Starts or stops using the pool on behalf of a context. Returns
+    //  false if the pool is not available on this platform.
+    static bool enable ();
+    static void disable ();
+
+    //  Returns a block of at least size_ bytes and stores its size class
+    //  in class_. Returns NULL if the pool is not in use, the size is
+    //  beyond the largest class or memory is exhausted.
+    static void *allocate (size_t size_, int *class_);
+
+    //  Returns a block obtained from allocate.
+    static void deallocate (void *block_, int class_);
+};
+}
+
+#endif
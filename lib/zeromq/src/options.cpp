@@ -238,7 +238,17 @@ zmq::options_t::options_t () :
     norm_num_parity (4),
     norm_num_autoparity (0),
     norm_push_enable (false),
-    busy_poll (0)
+    busy_poll (0),
+    lb_strategy (ZMQ_LB_ROUND_ROBIN),
+    lb_weight (1),
+    writev_threshold (0),
+    zerocopy_threshold (0),
+    udp_gso (false),
+    udp_gro (false),
+    cork (false),
+    cork_msgs (0),
+    cork_bytes (0),
+    cork_ivl (0)
 {
     memset (curve_public_key, 0, CURVE_KEYSIZE);
     memset (curve_secret_key, 0, CURVE_KEYSIZE);
@@ -905,6 +915,68 @@ int zmq::options_t::setsockopt (int option_,
 
             return 0;
 
+        case ZMQ_LB_STRATEGY:
+            if (is_int && value >= ZMQ_LB_ROUND_ROBIN
+                && value <= ZMQ_LB_POWER_OF_TWO) {
+                lb_strategy = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_WEIGHT:
+            if (is_int && value > 0) {
+                lb_weight = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_WRITEV_THRESHOLD:
+            if (is_int && value >= 0) {
+                writev_threshold = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ZEROCOPY_THRESHOLD:
+            if (is_int && value >= 0) {
+                zerocopy_threshold = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_UDP_GSO:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &udp_gso);
+
+        case ZMQ_UDP_GRO:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &udp_gro);
+
+        case ZMQ_CORK:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &cork);
+
+        case ZMQ_CORK_MSGS:
+            if (is_int && value >= 0) {
+                cork_msgs = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CORK_BYTES:
+            if (is_int && value >= 0) {
+                cork_bytes = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CORK_IVL:
+            if (is_int && value >= 0) {
+                cork_ivl = value;
+                return 0;
+            }
+            break;
+
 
 #endif
 
@@ -1404,6 +1476,76 @@ int zmq::options_t::getsockopt (int option_,
             break;
 #endif //ZMQ_HAVE_NORM
 
+        case ZMQ_LB_STRATEGY:
+            if (is_int) {
+                *value = lb_strategy;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_WEIGHT:
+            if (is_int) {
+                *value = lb_weight;
+                return 0;
+            }
+            break;
+
+        case ZMQ_WRITEV_THRESHOLD:
+            if (is_int) {
+                *value = writev_threshold;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ZEROCOPY_THRESHOLD:
+            if (is_int) {
+                *value = zerocopy_threshold;
+                return 0;
+            }
+            break;
+
+        case ZMQ_UDP_GSO:
+            if (is_int) {
+                *value = udp_gso;
+                return 0;
+            }
+            break;
+
+        case ZMQ_UDP_GRO:
+            if (is_int) {
+                *value = udp_gro;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CORK:
+            if (is_int) {
+                *value = cork;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CORK_MSGS:
+            if (is_int) {
+                *value = cork_msgs;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CORK_BYTES:
+            if (is_int) {
+                *value = cork_bytes;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CORK_IVL:
+            if (is_int) {
+                *value = cork_ivl;
+                return 0;
+            }
+            break;
+
 #endif
 
 
@@ -298,6 +298,35 @@ struct options_t
 
     //  This option removes several delays caused by scheduling, interrupts and context switching.
     int busy_poll;
+
+    //  Load-balancing strategy used by PUSH, DEALER, CLIENT and SCATTER
+    //  sockets, and the weight given to pipes created by subsequent
+    //  connects and binds when the weighted strategy is in use.
+    int lb_strategy;
+    int lb_weight;
+
+    //  Message bodies of at least this many bytes are written from where
+    //  they are with writev instead of being copied to the write buffer.
+    //  Zero disables the gather output path.
+    int writev_threshold;
+
+    //  Message bodies of at least this many bytes are sent over TCP with
+    //  MSG_ZEROCOPY where the kernel supports it. Zero disables it.
+    int zerocopy_threshold;
+
+    //  Whether the UDP engine sends datagrams of the same size with
+    //  segmentation offload, and receives them coalesced.
+    bool udp_gso;
+    bool udp_gro;
+
+    //  Whether flushing the pipes is held back until uncorked, and the
+    //  number of messages, bytes and microseconds after which held
+    //  messages are flushed anyway. Zero disables a limit; any limit
+    //  corks the socket by itself.
+    bool cork;
+    int cork_msgs;
+    int cork_bytes;
+    int cork_ivl;
 };
 
 inline bool get_effective_conflate_option (const options_t &options)
@@ -6,6 +6,7 @@
 
 #include "macros.hpp"
 #include "pipe.hpp"
+#include "ctx.hpp"
 #include "err.hpp"
 
 #include "ypipe.hpp"
@@ -22,18 +23,20 @@ int zmq::pipepair (object_t *parents_[2],
     typedef ypipe_t<msg_t, message_pipe_granularity> upipe_normal_t;
     typedef ypipe_conflate_t<msg_t> upipe_conflate_t;
 
+    chunk_pool_t *const pool = parents_[0]->get_ctx ()->get_chunk_pool ();
+
     pipe_t::upipe_t *upipe1;
     if (conflate_[0])
         upipe1 = new (std::nothrow) upipe_conflate_t ();
     else
-        upipe1 = new (std::nothrow) upipe_normal_t ();
+        upipe1 = new (std::nothrow) upipe_normal_t (pool);
     alloc_assert (upipe1);
 
     pipe_t::upipe_t *upipe2;
     if (conflate_[1])
         upipe2 = new (std::nothrow) upipe_conflate_t ();
     else
-        upipe2 = new (std::nothrow) upipe_normal_t ();
+        upipe2 = new (std::nothrow) upipe_normal_t (pool);
     alloc_assert (upipe2);
 
     pipes_[0] = new (std::nothrow)
@@ -95,6 +98,8 @@ zmq::pipe_t::pipe_t (object_t *parent_,
     _state (active),
     _delay (true),
     _server_socket_routing_id (0),
+    _lb_weight (1),
+    _corked (false),
     _conflate (conflate_)
 {
     _disconnect_msg.init ();
@@ -247,6 +252,17 @@ void zmq::pipe_t::rollback () const
 }
 
 void zmq::pipe_t::flush ()
+{
+    if (!_corked)
+        force_flush ();
+}
+
+void zmq::pipe_t::set_corked (bool corked_)
+{
+    _corked = corked_;
+}
+
+void zmq::pipe_t::force_flush ()
 {
     //  The peer does not exist anymore at this point.
     if (_state == term_ack_sent)
@@ -440,7 +456,7 @@ void zmq::pipe_t::terminate (bool delay_)
         msg_t msg;
         msg.init_delimiter ();
         _out_pipe->write (msg, false);
-        flush ();
+        force_flush ();
     }
 }
 
@@ -499,7 +515,8 @@ void zmq::pipe_t::hiccup ()
     _in_pipe =
       _conflate
         ? static_cast<upipe_t *> (new (std::nothrow) ypipe_conflate_t<msg_t> ())
-        : new (std::nothrow) ypipe_t<msg_t, message_pipe_granularity> ();
+        : new (std::nothrow) ypipe_t<msg_t, message_pipe_granularity> (
+          get_ctx ()->get_chunk_pool ());
 
     alloc_assert (_in_pipe);
     _in_active = true;
@@ -537,6 +554,22 @@ bool zmq::pipe_t::check_hwm () const
     return !full;
 }
 
+uint64_t zmq::pipe_t::get_queue_depth () const
+{
+    return _msgs_written - _peers_msgs_read;
+}
+
+void zmq::pipe_t::set_lb_weight (int weight_)
+{
+    zmq_assert (weight_ > 0);
+    _lb_weight = weight_;
+}
+
+int zmq::pipe_t::get_lb_weight () const
+{
+    return _lb_weight;
+}
+
 void zmq::pipe_t::send_hwms_to_peer (int inhwm_, int outhwm_)
 {
     send_pipe_hwm (_peer, inhwm_, outhwm_);
@@ -575,7 +608,7 @@ void zmq::pipe_t::send_disconnect_msg ()
         rollback ();
 
         _out_pipe->write (_disconnect_msg, false);
-        flush ();
+        force_flush ();
         _disconnect_msg.init ();
     }
 }
@@ -597,6 +630,6 @@ void zmq::pipe_t::send_hiccup_msg (const std::vector<unsigned char> &hiccup_)
         errno_assert (rc == 0);
 
         _out_pipe->write (msg, false);
-        flush ();
+        force_flush ();
     }
 }
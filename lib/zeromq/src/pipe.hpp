@@ -86,9 +86,15 @@ class pipe_t ZMQ_FINAL : public object_t,
     //  Remove unfinished parts of the outbound message from the pipe.
     void rollback () const;
 
-    //  Flush the messages downstream.
+    //  Flush the messages downstream, unless the pipe is corked.
     void flush ();
 
+    //  While corked, flush leaves the messages written so far in the
+    //  pipe, and only force_flush passes them on to the reader. Used by
+    //  sockets batching their flushes, see ZMQ_CORK.
+    void set_corked (bool corked_);
+    void force_flush ();
+
     //  Temporarily disconnects the inbound message stream and drops
     //  all the messages on the fly. Causes 'hiccuped' event to be generated
     //  in the peer.
@@ -115,6 +121,15 @@ class pipe_t ZMQ_FINAL : public object_t,
     //  Returns true if HWM is not reached
     bool check_hwm () const;
 
+    //  Returns the number of messages written to the pipe that the peer
+    //  has not yet reported as read. The peer reports its progress once
+    //  every low water mark messages, so the value is an upper bound.
+    uint64_t get_queue_depth () const;
+
+    //  Relative weight of the pipe, used by weighted load-balancing.
+    void set_lb_weight (int weight_);
+    int get_lb_weight () const;
+
     void set_endpoint_pair (endpoint_uri_pair_t endpoint_pair_);
     const endpoint_uri_pair_t &get_endpoint_pair () const;
 
@@ -224,6 +239,12 @@ class pipe_t ZMQ_FINAL : public object_t,
     //  Routing id of the writer. Used uniquely by the reader side.
     int _server_socket_routing_id;
 
+    //  Load-balancing weight. Used uniquely by the writer side.
+    int _lb_weight;
+
+    //  If true, flush is left to force_flush.
+    bool _corked;
+
     //  Returns true if the message is delimiter; false otherwise.
     static bool is_delimiter (const msg_t &msg_);
 
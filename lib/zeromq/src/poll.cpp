@@ -131,6 +131,7 @@ void zmq::poll_t::loop ()
             errno_assert (errno == EINTR);
             continue;
         }
+        add_events (rc);
 
         //  If there are no events (i.e. it's a timeout) there's no point
         //  in checking the pollset.
@@ -4,6 +4,13 @@
 #include "poller_base.hpp"
 #include "i_poll_events.hpp"
 #include "err.hpp"
+#include "config.hpp"
+#include "spin.hpp"
+
+zmq::poller_base_t::poller_base_t () :
+    _bytes (0), _events (0), _sampled (_clock.now_ms ())
+{
+}
 
 zmq::poller_base_t::~poller_base_t ()
 {
@@ -24,31 +31,54 @@ void zmq::poller_base_t::adjust_load (int amount_)
         _load.sub (-amount_);
 }
 
+void zmq::poller_base_t::add_bytes (size_t bytes_)
+{
+    _bytes += bytes_;
+}
+
+void zmq::poller_base_t::add_events (int events_)
+{
+    _events += events_;
+}
+
+void zmq::poller_base_t::sample_traffic ()
+{
+    const uint64_t now = _clock.now_ms ();
+    const uint64_t elapsed = now > _sampled ? now - _sampled : 1;
+    const uint64_t rate = (_bytes / 1024 + _events) * 1000 / elapsed;
+    _bytes %= 1024;
+    _events = 0;
+    _sampled = now;
+
+    //  Each sample weighs a quarter, so that a thread that went idle
+    //  looks idle again after a few intervals.
+    const uint64_t traffic =
+      (static_cast<uint64_t> (_traffic.get ()) * 3 + rate) / 4;
+    _traffic.set (traffic < 0xffffffff ? static_cast<uint32_t> (traffic)
+                                       : 0xffffffff);
+}
+
+uint32_t zmq::poller_base_t::get_traffic () const
+{
+    return _traffic.get ();
+}
+
 void zmq::poller_base_t::add_timer (int timeout_, i_poll_events *sink_, int id_)
 {
-    uint64_t expiration = _clock.now_ms () + timeout_;
-    timer_info_t info = {sink_, id_};
-    _timers.insert (timers_t::value_type (expiration, info));
+    const uint64_t now = _clock.now_ms ();
+    _timers.add (now, now + timeout_, sink_, id_);
 }
 
 void zmq::poller_base_t::cancel_timer (i_poll_events *sink_, int id_)
 {
-    //  Complexity of this operation is O(n). We assume it is rarely used.
-    for (timers_t::iterator it = _timers.begin (), end = _timers.end ();
-         it != end; ++it)
-        if (it->second.sink == sink_ && it->second.id == id_) {
-            _timers.erase (it);
-            return;
-        }
-
-    //  We should generally never get here. Calling 'cancel_timer ()' on
-    //  an already expired or canceled timer (or even worse - on a timer which
-    //  never existed, supplying bad sink_ and/or id_ values) does not make any
-    //  sense.
+    //  Calling 'cancel_timer ()' on an already expired or canceled timer
+    //  (or even worse - on a timer which never existed, supplying bad sink_
+    //  and/or id_ values) does not make any sense.
     //  But in some edge cases this might happen. As described in issue #3645
     //  `timer_event ()` call from `execute_timers ()` might call `cancel_timer ()`
     //  on already canceled (deleted) timer.
     //  As soon as that is resolved an 'assert (false)' should be put here.
+    _timers.cancel (sink_, id_);
 }
 
 uint64_t zmq::poller_base_t::execute_timers ()
@@ -60,39 +90,25 @@ uint64_t zmq::poller_base_t::execute_timers ()
     //  Get the current time.
     const uint64_t current = _clock.now_ms ();
 
-    //  Execute the timers that are already due.
-    uint64_t res = 0;
-    timer_info_t timer_temp;
-    timers_t::iterator it;
+    //  Execute the timers that are already due. The wheel hands them out
+    //  one by one, so that timer_event () may add and cancel timers.
+    void *sink;
+    int id;
+    void *arg;
+    while (_timers.expire (current, &sink, &id, &arg))
+        static_cast<i_poll_events *> (sink)->timer_event (id);
 
-    do {
-        it = _timers.begin ();
-
-        //  If we have to wait to execute the item, same will be true for
-        //  all the following items because multimap is sorted. Thus we can
-        //  stop checking the subsequent timers.
-        if (it->first > current) {
-            res = it->first - current;
-            break;
-        }
-
-        //  Save and remove the timer because timer_event() call might delete
-        //  exactly this timer and then the iterator will be invalid.
-        timer_temp = it->second;
-        _timers.erase (it);
-
-        //  Trigger the timer.
-        timer_temp.sink->timer_event (timer_temp.id);
-
-    } while (!_timers.empty ());
+    if (_timers.empty ())
+        return 0;
 
     //  Return the time to wait for the next timer (at least 1ms), or 0, if
     //  there are no more timers.
-    return res;
+    const uint64_t next = _timers.next_expiration ();
+    return next > current ? next - current : 1;
 }
 
 zmq::worker_poller_base_t::worker_poller_base_t (const thread_ctx_t &ctx_) :
-    _ctx (ctx_)
+    _ctx (ctx_), _spin (0), _spinning (false), _last_events (0), _backoff (1)
 {
 }
 
@@ -101,10 +117,42 @@ void zmq::worker_poller_base_t::stop_worker ()
     _worker.stop ();
 }
 
-void zmq::worker_poller_base_t::start (const char *name_)
+void zmq::worker_poller_base_t::start (const char *name_, int io_thread_)
 {
     zmq_assert (get_load () > 0);
-    _ctx.start_thread (_worker, worker_routine, this, name_);
+    _ctx.start_thread (_worker, worker_routine, this, name_, io_thread_);
+}
+
+void zmq::worker_poller_base_t::set_spin (int spin_)
+{
+    zmq_assert (spin_ >= 0);
+    if (spin_enabled ())
+        _spin = static_cast<uint64_t> (spin_);
+}
+
+int zmq::worker_poller_base_t::spin_timeout (int timeout_)
+{
+    if (_spin == 0)
+        return timeout_;
+    _spinning = clock_t::now_us () - _last_events < _spin;
+    return _spinning ? 0 : timeout_;
+}
+
+void zmq::worker_poller_base_t::spun (int events_)
+{
+    if (_spin == 0)
+        return;
+    if (events_ > 0) {
+        _last_events = clock_t::now_us ();
+        _backoff = 1;
+    } else if (_spinning) {
+        //  Back off between empty polls, but never for longer than a
+        //  microsecond or so, to pick up the next event fast.
+        for (int i = 0; i != _backoff; i++)
+            spin_pause ();
+        if (_backoff < max_spin_backoff)
+            _backoff *= 2;
+    }
 }
 
 void zmq::worker_poller_base_t::check_thread () const
@@ -3,11 +3,10 @@
 #ifndef __ZMQ_POLLER_BASE_HPP_INCLUDED__
 #define __ZMQ_POLLER_BASE_HPP_INCLUDED__
 
-#include <map>
-
 #include "clock.hpp"
 #include "atomic_counter.hpp"
 #include "ctx.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -95,7 +94,7 @@ struct i_poll_events;
 class poller_base_t
 {
   public:
-    poller_base_t () ZMQ_DEFAULT;
+    poller_base_t ();
     virtual ~poller_base_t ();
 
     // Methods from the poller concept.
@@ -103,10 +102,26 @@ class poller_base_t
     void add_timer (int timeout_, zmq::i_poll_events *sink_, int id_);
     void cancel_timer (zmq::i_poll_events *sink_, int id_);
 
+    //  Counts bytes transferred by the objects of the poller. Must be
+    //  called from the thread of the poller.
+    void add_bytes (size_t bytes_);
+
+    //  Folds the traffic since the last call into the recent traffic.
+    //  Must be called from the thread of the poller, at regular intervals.
+    void sample_traffic ();
+
+    //  Returns the recent traffic of the poller, in events plus kilobytes
+    //  per second. May be called from any thread.
+    uint32_t get_traffic () const;
+
   protected:
     //  Called by individual poller implementations to manage the load.
     void adjust_load (int amount_);
 
+    //  Called by individual poller implementations for the events they
+    //  handled.
+    void add_events (int events_);
+
     //  Executes any timers that are due. Returns number of milliseconds
     //  to wait to match the next timer or 0 meaning "no timers".
     uint64_t execute_timers ();
@@ -115,19 +130,21 @@ class poller_base_t
     //  Clock instance private to this I/O thread.
     clock_t _clock;
 
-    //  List of active timers.
-    struct timer_info_t
-    {
-        zmq::i_poll_events *sink;
-        int id;
-    };
-    typedef std::multimap<uint64_t, timer_info_t> timers_t;
-    timers_t _timers;
+    //  Active timers, owned by their sinks.
+    timer_wheel_t _timers;
 
     //  Load of the poller. Currently the number of file descriptors
     //  registered.
     atomic_counter_t _load;
 
+    //  Bytes and events since the last sample, and when it was taken.
+    uint64_t _bytes;
+    uint64_t _events;
+    uint64_t _sampled;
+
+    //  Moving average of the samples, only written by the poller thread.
+    atomic_counter_t _traffic;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (poller_base_t)
 };
 
@@ -137,8 +154,13 @@ class worker_poller_base_t : public poller_base_t
   public:
     worker_poller_base_t (const thread_ctx_t &ctx_);
 
-    // Methods from the poller concept.
-    void start (const char *name = NULL);
+    // Methods from the poller concept. I/O threads pass their index.
+    void start (const char *name = NULL, int io_thread_ = -1);
+
+    //  Makes the worker poll for events without blocking until spin_
+    //  microseconds have passed since the last ones, 0 to always block.
+    //  Only the epoll poller spins, and not on single core machines.
+    void set_spin (int spin_);
 
   protected:
     //  Checks whether the currently executing thread is the worker thread
@@ -151,6 +173,14 @@ class worker_poller_base_t : public poller_base_t
     //  leaf class.
     void stop_worker ();
 
+    //  Returns the timeout, in milliseconds, of the next wait for events:
+    //  0 while spinning, and timeout_ otherwise.
+    int spin_timeout (int timeout_);
+
+    //  Records the number of events the last wait returned, and backs off
+    //  briefly after an empty one while spinning.
+    void spun (int events_);
+
   private:
     //  Main worker thread routine.
     static void worker_routine (void *arg_);
@@ -162,6 +192,15 @@ class worker_poller_base_t : public poller_base_t
 
     //  Handle of the physical thread doing the I/O work.
     thread_t _worker;
+
+    //  Time to spin after the last events, in microseconds.
+    uint64_t _spin;
+
+    //  Whether the last wait was a non-blocking one, when the last events
+    //  came, and the number of pauses after the next empty wait.
+    bool _spinning;
+    uint64_t _last_events;
+    int _backoff;
 };
 }
 
@@ -190,6 +190,7 @@ void zmq::pollset_t::loop ()
             errno_assert (errno == EINTR);
             continue;
         }
+        add_events (n);
 
         for (int i = 0; i < n; i++) {
             poll_entry_t *pe = fd_table[polldata_array[i].fd];
@@ -29,6 +29,7 @@ void zmq::push_t::xattach_pipe (pipe_t *pipe_,
     pipe_->set_nodelay ();
 
     zmq_assert (pipe_);
+    _lb.set_strategy (options.lb_strategy);
     _lb.attach (pipe_);
 }
 
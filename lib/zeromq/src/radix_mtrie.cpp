@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "radix_mtrie.hpp"
+#include "generic_radix_mtrie_impl.hpp"
+
+namespace zmq
+{
+template class generic_radix_mtrie_t<pipe_t>;
+}
@@ -4,9 +4,11 @@
 #include "macros.hpp"
 #include "err.hpp"
 #include "radix_tree.hpp"
+#include "simd.hpp"
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include <iterator>
 #include <vector>
 
@@ -211,12 +213,10 @@ match_result_t zmq::radix_tree_t::match (const unsigned char *key_,
         const unsigned char *const prefix = current_node.prefix ();
         const size_t prefix_length = current_node.prefix_length ();
 
-        for (prefix_byte_index = 0;
-             prefix_byte_index < prefix_length && key_byte_index < key_size_;
-             ++prefix_byte_index, ++key_byte_index) {
-            if (prefix[prefix_byte_index] != key_[key_byte_index])
-                break;
-        }
+        prefix_byte_index =
+          mismatch (prefix, key_ + key_byte_index,
+                    std::min (prefix_length, key_size_ - key_byte_index));
+        key_byte_index += prefix_byte_index;
 
         // Even if a prefix of the key matches and we're doing a
         // lookup, this means we've found a matching subscription.
@@ -233,19 +233,15 @@ match_result_t zmq::radix_tree_t::match (const unsigned char *key_,
 
         // We need to match the rest of the key. Check if there's an
         // outgoing edge from this node.
-        node_t next_node = current_node;
-        for (size_t i = 0, edgecount = current_node.edgecount (); i < edgecount;
-             ++i) {
-            if (current_node.first_byte_at (i) == key_[key_byte_index]) {
-                parent_edge_index = edge_index;
-                edge_index = i;
-                next_node = current_node.node_at (i);
-                break;
-            }
-        }
-
-        if (next_node == current_node)
+        const unsigned char *const first_bytes = current_node.first_bytes ();
+        const unsigned char *const first_byte =
+          static_cast<const unsigned char *> (memchr (
+            first_bytes, key_[key_byte_index], current_node.edgecount ()));
+        if (!first_byte)
             break; // No outgoing edge.
+        parent_edge_index = edge_index;
+        edge_index = first_byte - first_bytes;
+        const node_t next_node = current_node.node_at (edge_index);
         grandparent_node = parent_node;
         parent_node = current_node;
         current_node = next_node;
@@ -502,9 +498,21 @@ bool zmq::radix_tree_t::rm (const unsigned char *key_, size_t key_size_)
 
 bool zmq::radix_tree_t::check (const unsigned char *key_, size_t key_size_)
 {
+    //  Subscribed to everything.
     if (_root.refcount () > 0)
         return true;
 
+    //  A single subscription is the only child of the root.
+    if (_root.edgecount () == 1) {
+        node_t node = _root.node_at (0);
+        if (node.edgecount () == 0) {
+            const size_t prefix_length = node.prefix_length ();
+            return key_size_ >= prefix_length
+                   && mismatch (node.prefix (), key_, prefix_length)
+                        == prefix_length;
+        }
+    }
+
     match_result_t match_result = match (key_, key_size_, true);
     return match_result._key_bytes_matched == key_size_
            && match_result._prefix_bytes_matched
@@ -484,7 +484,7 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_, bool locally_initiated_)
 
                 erase_out_pipe (old_pipe);
                 old_pipe->set_router_socket_routing_id (new_routing_id);
-                add_out_pipe (ZMQ_MOVE (new_routing_id), old_pipe);
+                add_out_pipe (new_routing_id, old_pipe);
 
                 if (old_pipe == _current_in)
                     _terminate_current_in = true;
@@ -495,7 +495,7 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_, bool locally_initiated_)
     }
 
     pipe_->set_router_socket_routing_id (routing_id);
-    add_out_pipe (ZMQ_MOVE (routing_id), pipe_);
+    add_out_pipe (routing_id, pipe_);
 
     return true;
 }
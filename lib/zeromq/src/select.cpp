@@ -415,6 +415,7 @@ void zmq::select_t::select_family_entry (family_entry_t &family_entry_,
     }
 #endif
 
+    add_events (rc);
     trigger_events (fd_entries, local_fds_set, rc);
 
     cleanup_retired (family_entry_);
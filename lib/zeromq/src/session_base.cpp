@@ -409,6 +409,10 @@ void zmq::session_base_t::engine_ready ()
         //  Plug the local end of the pipe.
         pipes[0]->set_event_sink (this);
 
+        //  The remote end goes to the socket; give it the load-balancing
+        //  weight that was in effect when the connect or bind was issued.
+        pipes[1]->set_lb_weight (options.lb_weight);
+
         //  Remember the local end of the pipe.
         zmq_assert (!_pipe);
         _pipe = pipes[0];
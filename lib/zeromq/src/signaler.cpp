@@ -35,6 +35,7 @@
 #include "fd.hpp"
 #include "ip.hpp"
 #include "tcp.hpp"
+#include "spin.hpp"
 
 #if !defined ZMQ_HAVE_WINDOWS
 #include <unistd.h>
@@ -43,6 +44,14 @@
 #include <sys/socket.h>
 #endif
 
+#include <algorithm>
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+//  Bounds of the adaptive spin in wait, in iterations.
+static const int min_spin = 8;
+static const int max_spin = 1024;
+#endif
+
 #if !defined(ZMQ_HAVE_WINDOWS)
 // Helper to sleep for specific number of milliseconds (or until signal)
 //
@@ -90,6 +99,19 @@ static int close_wait_ms (int fd_, unsigned int max_ms_ = 2000)
 
 zmq::signaler_t::signaler_t ()
 {
+#if defined ZMQ_HAVE_STD_ATOMIC
+    static const bool spin_on = spin_enabled ();
+    _state.store (idle, std::memory_order_relaxed);
+    _spin = spin_on ? max_spin / 8 : 0;
+#if defined ZMQ_SIGNALER_STATS
+    _signals.store (0, std::memory_order_relaxed);
+    _writes.store (0, std::memory_order_relaxed);
+    _polls.store (0, std::memory_order_relaxed);
+    _reads.store (0, std::memory_order_relaxed);
+    _spin_hits.store (0, std::memory_order_relaxed);
+#endif
+#endif
+
     //  Create the socketpair for signaling.
     if (make_fdpair (&_r, &_w) == 0) {
         unblock_socket (_w);
@@ -151,6 +173,30 @@ void zmq::signaler_t::send ()
         return; // do not send anything in forked child context
     }
 #endif
+#if defined ZMQ_HAVE_STD_ATOMIC
+#if defined ZMQ_SIGNALER_STATS
+    _signals.fetch_add (1, std::memory_order_relaxed);
+#endif
+    int state = _state.load (std::memory_order_acquire);
+    while (true) {
+        //  A signal is already pending; this one is coalesced into it.
+        if (state == signalled || state == posted)
+            return;
+
+        //  A spinning reader gets the signal handed over in memory.
+        const int next = state == spinning ? signalled : posted;
+        if (_state.compare_exchange_weak (state, next,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+            if (next == signalled)
+                return;
+            break;
+        }
+    }
+#if defined ZMQ_SIGNALER_STATS
+    _writes.fetch_add (1, std::memory_order_relaxed);
+#endif
+#endif
 #if defined ZMQ_HAVE_EVENTFD
     const uint64_t inc = 1;
     ssize_t sz = write (_w, &inc, sizeof (inc));
@@ -200,7 +246,7 @@ void zmq::signaler_t::send ()
 #endif
 }
 
-int zmq::signaler_t::wait (int timeout_) const
+int zmq::signaler_t::wait (int timeout_)
 {
 #ifdef HAVE_FORK
     if (unlikely (pid != getpid ())) {
@@ -212,6 +258,25 @@ int zmq::signaler_t::wait (int timeout_) const
     }
 #endif
 
+#if defined ZMQ_HAVE_STD_ATOMIC
+    //  Neither a signal handed over in memory nor the lack of any signal
+    //  needs a system call to find out.
+    const int state = _state.load (std::memory_order_acquire);
+    if (state == signalled)
+        return 0;
+    if (state == idle) {
+        if (timeout_ == 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+        if (spin ())
+            return 0;
+    }
+#if defined ZMQ_SIGNALER_STATS
+    _polls.fetch_add (1, std::memory_order_relaxed);
+#endif
+#endif
+
 #ifdef ZMQ_POLL_BASED_ON_POLL
     struct pollfd pfd;
     pfd.fd = _r;
@@ -274,6 +339,16 @@ int zmq::signaler_t::wait (int timeout_) const
 
 void zmq::signaler_t::recv ()
 {
+#if defined ZMQ_HAVE_STD_ATOMIC
+    //  Clear the state before reading, so that a signal sent meanwhile is
+    //  posted anew rather than coalesced into the one being read.
+    if (_state.exchange (idle, std::memory_order_acq_rel) == signalled)
+        return;
+#if defined ZMQ_SIGNALER_STATS
+    _reads.fetch_add (1, std::memory_order_relaxed);
+#endif
+#endif
+
 //  Attempt to read a signal.
 #if defined ZMQ_HAVE_EVENTFD
     uint64_t dummy;
@@ -310,6 +385,16 @@ void zmq::signaler_t::recv ()
 
 int zmq::signaler_t::recv_failable ()
 {
+#if defined ZMQ_HAVE_STD_ATOMIC
+    //  Clear the state before reading, so that a signal sent meanwhile is
+    //  posted anew rather than coalesced into the one being read.
+    if (_state.exchange (idle, std::memory_order_acq_rel) == signalled)
+        return 0;
+#if defined ZMQ_SIGNALER_STATS
+    _reads.fetch_add (1, std::memory_order_relaxed);
+#endif
+#endif
+
 //  Attempt to read a signal.
 #if defined ZMQ_HAVE_EVENTFD
     uint64_t dummy;
@@ -376,6 +461,53 @@ bool zmq::signaler_t::valid () const
     return _w != retired_fd;
 }
 
+#if defined ZMQ_HAVE_STD_ATOMIC
+bool zmq::signaler_t::spin ()
+{
+    if (!_spin)
+        return false;
+
+    int state = idle;
+    if (!_state.compare_exchange_strong (state, spinning,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire))
+        return false;
+
+    bool hit = false;
+    for (int i = 0; i != _spin && !hit; i++) {
+        spin_pause ();
+        hit = _state.load (std::memory_order_acquire) == signalled;
+    }
+
+    //  A signal may arrive just as we give up.
+    state = spinning;
+    if (!hit
+        && _state.compare_exchange_strong (state, idle,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+        _spin = std::max (_spin / 2, min_spin);
+        return false;
+    }
+
+    _spin = std::min (_spin * 2, max_spin);
+#if defined ZMQ_SIGNALER_STATS
+    _spin_hits.fetch_add (1, std::memory_order_relaxed);
+#endif
+    return true;
+}
+
+#if defined ZMQ_SIGNALER_STATS
+void zmq::signaler_t::get_stats (stats_t *stats_) const
+{
+    stats_->signals = _signals.load (std::memory_order_relaxed);
+    stats_->writes = _writes.load (std::memory_order_relaxed);
+    stats_->polls = _polls.load (std::memory_order_relaxed);
+    stats_->reads = _reads.load (std::memory_order_relaxed);
+    stats_->spin_hits = _spin_hits.load (std::memory_order_relaxed);
+}
+#endif
+#endif
+
 #ifdef HAVE_FORK
 void zmq::signaler_t::forked ()
 {
@@ -383,5 +515,8 @@ void zmq::signaler_t::forked ()
     close (_r);
     close (_w);
     make_fdpair (&_r, &_w);
+#if defined ZMQ_HAVE_STD_ATOMIC
+    _state.store (idle, std::memory_order_relaxed);
+#endif
 }
 #endif
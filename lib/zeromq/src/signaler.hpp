@@ -9,13 +9,22 @@
 
 #include "fd.hpp"
 #include "macros.hpp"
+#include "stdint.hpp"
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+#include <atomic>
+#endif
 
 namespace zmq
 {
 //  This is a cross-platform equivalent to signal_fd. However, as opposed
 //  to signal_fd there can be at most one signal in the signaler at any
-//  given moment. Attempt to send a signal before receiving the previous
-//  one will result in undefined behaviour.
+//  given moment. Signals sent before the previous one was received are
+//  coalesced into it, which saves the system call.
+//
+//  A reader blocking in wait spins for a while before it goes to sleep.
+//  A signal sent while it spins is handed over in memory and never
+//  touches the file descriptor. The spin adapts to how often it pays off.
 
 class signaler_t
 {
@@ -27,12 +36,33 @@ class signaler_t
     // May return retired_fd if the signaler could not be initialized.
     fd_t get_fd () const;
     void send ();
-    int wait (int timeout_) const;
+    int wait (int timeout_);
     void recv ();
     int recv_failable ();
 
     bool valid () const;
 
+#if defined ZMQ_HAVE_STD_ATOMIC && defined ZMQ_SIGNALER_STATS
+    //  Only counted when built with ZMQ_SIGNALER_STATS, for benchmarks;
+    //  the counters cost every send an atomic increment otherwise.
+    struct stats_t
+    {
+        //  Number of send calls.
+        uint64_t signals;
+
+        //  Number of system calls made to write, poll and read the file
+        //  descriptor.
+        uint64_t writes;
+        uint64_t polls;
+        uint64_t reads;
+
+        //  Number of waits that received the signal while spinning.
+        uint64_t spin_hits;
+    };
+
+    void get_stats (stats_t *stats_) const;
+#endif
+
 #ifdef HAVE_FORK
     // close the file descriptors in a forked child process so that they
     // do not interfere with the context in the parent process.
@@ -46,6 +76,39 @@ class signaler_t
     fd_t _w;
     fd_t _r;
 
+#if defined ZMQ_HAVE_STD_ATOMIC
+    enum
+    {
+        //  No signal pending.
+        idle,
+
+        //  The reader spins in wait, no signal pending.
+        spinning,
+
+        //  Signal pending, handed over in memory.
+        signalled,
+
+        //  Signal pending in the file descriptor.
+        posted
+    };
+    std::atomic<int> _state;
+
+    //  Number of iterations the reader spins before it goes to sleep.
+    //  Only accessed by the reader.
+    int _spin;
+
+#if defined ZMQ_SIGNALER_STATS
+    std::atomic<uint64_t> _signals;
+    std::atomic<uint64_t> _writes;
+    std::atomic<uint64_t> _polls;
+    std::atomic<uint64_t> _reads;
+    std::atomic<uint64_t> _spin_hits;
+#endif
+
+    //  Spins until a signal is handed over. Returns true on success.
+    bool spin ();
+#endif
+
 #ifdef HAVE_FORK
     // the process that created this context. Used to detect forking.
     pid_t pid;
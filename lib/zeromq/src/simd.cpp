@@ -0,0 +1,241 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "simd.hpp"
+#include "stdint.hpp"
+
+#include <string.h>
+
+#if defined __SSE2__ || defined _M_X64                                         \
+  || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define ZMQ_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+//  AVX2 code is compiled for its own functions only and selected at run
+//  time, so the library still runs on CPUs without it.
+#if defined ZMQ_SIMD_SSE2
+#if (defined __GNUC__                                                          \
+     && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))              \
+  || (defined __clang__ && !defined _MSC_VER)
+#define ZMQ_SIMD_AVX2
+#define ZMQ_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#include <immintrin.h>
+#elif defined _MSC_VER && _MSC_VER >= 1700
+#define ZMQ_SIMD_AVX2
+#define ZMQ_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+typedef size_t (*mismatch_t) (const unsigned char *a_,
+                              const unsigned char *b_,
+                              size_t size_);
+
+size_t
+mismatch_scalar (const unsigned char *a_, const unsigned char *b_, size_t size_)
+{
+    size_t i = 0;
+    while (i != size_ && a_[i] == b_[i])
+        i++;
+    return i;
+}
+
+#if defined ZMQ_SIMD_SSE2
+//  Index of the lowest bit set in a non-zero mask.
+inline size_t first_set_bit (unsigned int mask_)
+{
+#if defined _MSC_VER
+    unsigned long index;
+    _BitScanForward (&index, mask_);
+    return index;
+#else
+    return __builtin_ctz (mask_);
+#endif
+}
+
+size_t
+mismatch_sse2 (const unsigned char *a_, const unsigned char *b_, size_t size_)
+{
+    size_t i = 0;
+    for (; i + 16 <= size_; i += 16) {
+        const __m128i a =
+          _mm_loadu_si128 (reinterpret_cast<const __m128i *> (a_ + i));
+        const __m128i b =
+          _mm_loadu_si128 (reinterpret_cast<const __m128i *> (b_ + i));
+        const unsigned int mask =
+          static_cast<unsigned int> (_mm_movemask_epi8 (_mm_cmpeq_epi8 (a, b)))
+          ^ 0xffffu;
+        if (mask)
+            return i + first_set_bit (mask);
+    }
+    return i + mismatch_scalar (a_ + i, b_ + i, size_ - i);
+}
+#endif
+
+#if defined ZMQ_SIMD_AVX2
+ZMQ_TARGET_AVX2 size_t mismatch_avx2 (const unsigned char *a_,
+                                      const unsigned char *b_,
+                                      size_t size_)
+{
+    size_t i = 0;
+    for (; i + 32 <= size_; i += 32) {
+        const __m256i a =
+          _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (a_ + i));
+        const __m256i b =
+          _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (b_ + i));
+        const unsigned int mask = ~static_cast<unsigned int> (
+          _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (a, b)));
+        if (mask)
+            return i + first_set_bit (mask);
+    }
+    return i + mismatch_sse2 (a_ + i, b_ + i, size_ - i);
+}
+
+bool cpu_has_avx2 ()
+{
+#if defined _MSC_VER && !defined __clang__
+    int info[4];
+    __cpuid (info, 0);
+    if (info[0] < 7)
+        return false;
+    //  The OS must save the AVX registers on context switches.
+    __cpuid (info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))
+        || (_xgetbv (0) & 6) != 6)
+        return false;
+    __cpuidex (info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("avx2") != 0;
+#endif
+}
+#endif
+
+mismatch_t select_mismatch ()
+{
+#if defined ZMQ_SIMD_AVX2
+    if (cpu_has_avx2 ())
+        return mismatch_avx2;
+#endif
+#if defined ZMQ_SIMD_SSE2
+    return mismatch_sse2;
+#else
+    return mismatch_scalar;
+#endif
+}
+
+const mismatch_t mismatch_impl = select_mismatch ();
+
+//  The mask is rotated so that its first byte goes with the first byte.
+typedef void (*mask_t) (unsigned char *dest_,
+                        const unsigned char *src_,
+                        size_t size_,
+                        const unsigned char *mask_);
+
+void mask_scalar (unsigned char *dest_,
+                  const unsigned char *src_,
+                  size_t size_,
+                  const unsigned char *mask_)
+{
+    unsigned char pattern[8];
+    memcpy (pattern, mask_, 4);
+    memcpy (pattern + 4, mask_, 4);
+    uint64_t mask;
+    memcpy (&mask, pattern, sizeof mask);
+
+    size_t i = 0;
+    for (; i + 8 <= size_; i += 8) {
+        uint64_t word;
+        memcpy (&word, src_ + i, sizeof word);
+        word ^= mask;
+        memcpy (dest_ + i, &word, sizeof word);
+    }
+    for (; i != size_; i++)
+        dest_[i] = src_[i] ^ mask_[i & 3];
+}
+
+#if defined ZMQ_SIMD_SSE2
+int mask_word (const unsigned char *mask_)
+{
+    int word;
+    memcpy (&word, mask_, sizeof word);
+    return word;
+}
+
+void mask_sse2 (unsigned char *dest_,
+                const unsigned char *src_,
+                size_t size_,
+                const unsigned char *mask_)
+{
+    const __m128i mask = _mm_set1_epi32 (mask_word (mask_));
+    size_t i = 0;
+    for (; i + 16 <= size_; i += 16) {
+        const __m128i data =
+          _mm_loadu_si128 (reinterpret_cast<const __m128i *> (src_ + i));
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (dest_ + i),
+                          _mm_xor_si128 (data, mask));
+    }
+    mask_scalar (dest_ + i, src_ + i, size_ - i, mask_);
+}
+#endif
+
+#if defined ZMQ_SIMD_AVX2
+ZMQ_TARGET_AVX2 void mask_avx2 (unsigned char *dest_,
+                                const unsigned char *src_,
+                                size_t size_,
+                                const unsigned char *mask_)
+{
+    const __m256i mask = _mm256_set1_epi32 (mask_word (mask_));
+    size_t i = 0;
+    for (; i + 32 <= size_; i += 32) {
+        const __m256i data =
+          _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (src_ + i));
+        _mm256_storeu_si256 (reinterpret_cast<__m256i *> (dest_ + i),
+                             _mm256_xor_si256 (data, mask));
+    }
+    mask_sse2 (dest_ + i, src_ + i, size_ - i, mask_);
+}
+#endif
+
+mask_t select_mask ()
+{
+#if defined ZMQ_SIMD_AVX2
+    if (cpu_has_avx2 ())
+        return mask_avx2;
+#endif
+#if defined ZMQ_SIMD_SSE2
+    return mask_sse2;
+#else
+    return mask_scalar;
+#endif
+}
+
+const mask_t mask_impl = select_mask ();
+}
+
+size_t zmq::mismatch_bulk (const unsigned char *a_,
+                           const unsigned char *b_,
+                           size_t size_)
+{
+    return mismatch_impl (a_, b_, size_);
+}
+
+void zmq::mask_bulk (unsigned char *dest_,
+                     const unsigned char *src_,
+                     size_t size_,
+                     const unsigned char *mask_,
+                     size_t offset_)
+{
+    const unsigned char mask[4] = {
+      mask_[offset_ & 3], mask_[(offset_ + 1) & 3], mask_[(offset_ + 2) & 3],
+      mask_[(offset_ + 3) & 3]};
+    if (size_ < 32)
+        mask_scalar (dest_, src_, size_, mask);
+    else
+        mask_impl (dest_, src_, size_, mask);
+}
@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_SIMD_HPP_INCLUDED__
+#define __ZMQ_SIMD_HPP_INCLUDED__
+
+#include <stddef.h>
+
+namespace zmq
+{
+//  Same as mismatch, for runs of 16 bytes or more. Compares 32 bytes at
+//  a time with AVX2 where the CPU supports it, 16 at a time with SSE2
+//  otherwise, and one at a time on other architectures.
+size_t mismatch_bulk (const unsigned char *a_,
+                      const unsigned char *b_,
+                      size_t size_);
+
+//  Returns the index of the first byte that differs between a_ and b_,
+//  or size_ if their first size_ bytes are equal.
+inline size_t
+mismatch (const unsigned char *a_, const unsigned char *b_, size_t size_)
+{
+    //  Short runs are not worth the call.
+    if (size_ >= 16)
+        return mismatch_bulk (a_, b_, size_);
+    size_t i = 0;
+    while (i != size_ && a_[i] == b_[i])
+        i++;
+    return i;
+}
+
+//  Same as mask, for runs of 8 bytes or more. XORs 32 bytes at a time
+//  with AVX2 where the CPU supports it, 16 at a time with SSE2 otherwise,
+//  and 8 at a time on other architectures and for short runs.
+void mask_bulk (unsigned char *dest_,
+                const unsigned char *src_,
+                size_t size_,
+                const unsigned char *mask_,
+                size_t offset_);
+
+//  Stores size_ bytes of src_ XORed with the repeated four byte mask_
+//  into dest_, the first byte with byte offset_ of the mask, as WebSocket
+//  frames are masked. dest_ may be src_.
+inline void mask (unsigned char *dest_,
+                  const unsigned char *src_,
+                  size_t size_,
+                  const unsigned char *mask_,
+                  size_t offset_)
+{
+    if (size_ >= 8) {
+        mask_bulk (dest_, src_, size_, mask_, offset_);
+        return;
+    }
+    for (size_t i = 0; i != size_; i++)
+        dest_[i] = src_[i] ^ mask_[(offset_ + i) & 3];
+}
+}
+
+#endif
@@ -31,6 +31,7 @@
 #include "ws_address.hpp"
 #endif
 #include "io_thread.hpp"
+#include "io_object.hpp"
 #include "session_base.hpp"
 #include "config.hpp"
 #include "pipe.hpp"
@@ -119,6 +120,82 @@ bool zmq::socket_base_t::check_tag () const
     return _tag == 0xbaddecaf;
 }
 
+namespace zmq
+{
+//  Passes on the messages a socket holds back with ZMQ_CORK_IVL once they
+//  are due, also while the application does not use the socket. It runs
+//  on an I/O thread as a child of the socket, whose API calls take _sync
+//  from then on, and asks to be terminated once the interval is unset.
+class cork_timer_t ZMQ_FINAL : public own_t, public io_object_t
+{
+  public:
+    cork_timer_t (io_thread_t *io_thread_,
+                  socket_base_t *socket_,
+                  const options_t &options_) :
+        own_t (io_thread_, options_),
+        io_object_t (io_thread_),
+        _socket (socket_),
+        _backoff (1),
+        _timer_started (false)
+    {
+    }
+
+  private:
+    void process_plug () ZMQ_FINAL { check (); }
+
+    void process_term (int linger_) ZMQ_FINAL
+    {
+        if (_timer_started) {
+            cancel_timer (cork_timer_id);
+            _timer_started = false;
+        }
+        own_t::process_term (linger_);
+    }
+
+    void timer_event (int id_) ZMQ_FINAL
+    {
+        zmq_assert (id_ == cork_timer_id);
+        _timer_started = false;
+        check ();
+    }
+
+    //  Flushes the due messages and arms the timer for the next ones.
+    //  While the socket is in use, its own thread flushes them and the
+    //  timer looks less and less often.
+    void check ()
+    {
+        int wait = _socket->flush_due_cork ();
+        if (wait == 0) {
+            terminate ();
+            return;
+        }
+        if (wait > 0)
+            _backoff = 1;
+        else {
+            wait = _backoff;
+            _backoff = std::min (_backoff * 2,
+                                 static_cast<int> (cork_timer_max_backoff));
+        }
+        add_timer (wait, cork_timer_id);
+        _timer_started = true;
+    }
+
+    enum
+    {
+        cork_timer_id = 0x70
+    };
+
+    socket_base_t *const _socket;
+
+    //  Milliseconds to wait if the socket is found in use again.
+    int _backoff;
+
+    bool _timer_started;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (cork_timer_t)
+};
+}
+
 bool zmq::socket_base_t::is_thread_safe () const
 {
     return _thread_safe;
@@ -224,6 +301,12 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_,
     _last_tsc (0),
     _ticks (0),
     _rcvmore (false),
+    _corked (false),
+    _corked_msgs (0),
+    _corked_bytes (0),
+    _corked_since (0),
+    _cork_timer (false),
+    _cork_sync (false),
     _monitor_socket (NULL),
     _monitor_events (0),
     _thread_safe (thread_safe_),
@@ -389,6 +472,9 @@ void zmq::socket_base_t::attach_pipe (pipe_t *pipe_,
     //  Let the derived socket type know about new pipe.
     xattach_pipe (pipe_, subscribe_to_all_, locally_initiated_);
 
+    //  Cork the pipe after the socket type sent its initial messages.
+    pipe_->set_corked (_corked);
+
     //  If the socket is already being closed, ask any new pipes to terminate
     //  straight away.
     if (is_terminating ()) {
@@ -401,7 +487,7 @@ int zmq::socket_base_t::setsockopt (int option_,
                                     const void *optval_,
                                     size_t optvallen_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
     if (unlikely (_ctx_terminated)) {
         errno = ETERM;
@@ -411,6 +497,9 @@ int zmq::socket_base_t::setsockopt (int option_,
     //  First, check whether specific socket type overloads the option.
     int rc = xsetsockopt (option_, optval_, optvallen_);
     if (rc == 0 || errno != EINVAL) {
+        //  Subscriptions are not held back by corking.
+        if (unlikely (_corked) && rc == 0)
+            flush_corked ();
         return rc;
     }
 
@@ -426,7 +515,7 @@ int zmq::socket_base_t::getsockopt (int option_,
                                     void *optval_,
                                     size_t *optvallen_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
     if (unlikely (_ctx_terminated)) {
         errno = ETERM;
@@ -480,16 +569,22 @@ int zmq::socket_base_t::getsockopt (int option_,
 
 int zmq::socket_base_t::join (const char *group_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
-    return xjoin (group_);
+    const int rc = xjoin (group_);
+    if (unlikely (_corked) && rc == 0)
+        flush_corked ();
+    return rc;
 }
 
 int zmq::socket_base_t::leave (const char *group_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
-    return xleave (group_);
+    const int rc = xleave (group_);
+    if (unlikely (_corked) && rc == 0)
+        flush_corked ();
+    return rc;
 }
 
 void zmq::socket_base_t::add_signaler (signaler_t *s_)
@@ -510,7 +605,7 @@ void zmq::socket_base_t::remove_signaler (signaler_t *s_)
 
 int zmq::socket_base_t::bind (const char *endpoint_uri_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
     if (unlikely (_ctx_terminated)) {
         errno = ETERM;
@@ -599,6 +694,8 @@ int zmq::socket_base_t::bind (const char *endpoint_uri_)
         rc = pipepair (parents, new_pipes, hwms, conflates);
         errno_assert (rc == 0);
 
+        new_pipes[0]->set_lb_weight (options.lb_weight);
+
         //  Attach local end of the pipe to the socket object.
         attach_pipe (new_pipes[0], true, true);
         pipe_t *const newpipe = new_pipes[0];
@@ -748,7 +845,7 @@ int zmq::socket_base_t::bind (const char *endpoint_uri_)
 
 int zmq::socket_base_t::connect (const char *endpoint_uri_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
     return connect_internal (endpoint_uri_);
 }
 
@@ -859,6 +956,8 @@ int zmq::socket_base_t::connect_internal (const char *endpoint_uri_)
             send_bind (peer.socket, new_pipes[1], false);
         }
 
+        new_pipes[0]->set_lb_weight (options.lb_weight);
+
         //  Attach local end of the pipe to this socket object.
         attach_pipe (new_pipes[0], false, true);
 
@@ -1077,6 +1176,8 @@ int zmq::socket_base_t::connect_internal (const char *endpoint_uri_)
         rc = pipepair (parents, new_pipes, hwms, conflates);
         errno_assert (rc == 0);
 
+        new_pipes[0]->set_lb_weight (options.lb_weight);
+
         //  Attach local end of the pipe to the socket object.
         attach_pipe (new_pipes[0], subscribe_to_all, true);
         newpipe = new_pipes[0];
@@ -1135,7 +1236,7 @@ void zmq::socket_base_t::add_endpoint (
 
 int zmq::socket_base_t::term_endpoint (const char *endpoint_uri_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
     //  Check whether the context hasn't been shut down yet.
     if (unlikely (_ctx_terminated)) {
@@ -1203,7 +1304,7 @@ int zmq::socket_base_t::term_endpoint (const char *endpoint_uri_)
 
 int zmq::socket_base_t::send (msg_t *msg_, int flags_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
     //  Check whether the context hasn't been shut down yet.
     if (unlikely (_ctx_terminated)) {
@@ -1232,9 +1333,15 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
 
     msg_->reset_metadata ();
 
+    //  The message is gone once sent; remember what corking counts.
+    const size_t size = msg_->size ();
+    const bool more = (flags_ & ZMQ_SNDMORE) != 0;
+
     //  Try to send the message using method in each socket class
     rc = xsend (msg_);
     if (rc == 0) {
+        if (unlikely (_corked))
+            count_corked (size, more);
         return 0;
     }
     //  Special case for ZMQ_PUSH: -2 means pipe is dead while a
@@ -1253,6 +1360,11 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
         return -1;
     }
 
+    //  The pipes may be full of messages held back by corking, which the
+    //  peers cannot read until they are flushed.
+    if (unlikely (_corked_msgs))
+        flush_corked ();
+
     //  In case of non-blocking send we'll simply propagate
     //  the error - including EAGAIN - up the stack.
     if ((flags_ & ZMQ_DONTWAIT) || options.sndtimeo == 0) {
@@ -1272,8 +1384,11 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
             return -1;
         }
         rc = xsend (msg_);
-        if (rc == 0)
+        if (rc == 0) {
+            if (unlikely (_corked))
+                count_corked (size, more);
             break;
+        }
         if (unlikely (errno != EAGAIN)) {
             return -1;
         }
@@ -1291,7 +1406,7 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
 
 int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
     //  Check whether the context hasn't been shut down yet.
     if (unlikely (_ctx_terminated)) {
@@ -1356,6 +1471,11 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
     int timeout = options.rcvtimeo;
     const uint64_t end = timeout < 0 ? 0 : (_clock.now_ms () + timeout);
 
+    //  Messages held back by corking may be what the peers wait for before
+    //  replying, so pass them on before waiting.
+    if (unlikely (_corked_msgs))
+        flush_corked ();
+
     //  In blocking scenario, commands are processed over and over again until
     //  we are able to fetch a message.
     bool block = (_ticks != 0);
@@ -1387,7 +1507,7 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
 
 int zmq::socket_base_t::close ()
 {
-    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+    scoped_optional_lock_t sync_lock (api_sync ());
 
     //  Remove all existing signalers for thread safe sockets
     if (_thread_safe)
@@ -1425,7 +1545,7 @@ void zmq::socket_base_t::start_reaping (poller_t *poller_)
     if (!_thread_safe)
         fd = (static_cast<mailbox_t *> (_mailbox))->get_fd ();
     else {
-        scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+        scoped_optional_lock_t sync_lock (api_sync ());
 
         _reaper_signaler = new (std::nothrow) signaler_t ();
         zmq_assert (_reaper_signaler);
@@ -1450,6 +1570,12 @@ void zmq::socket_base_t::start_reaping (poller_t *poller_)
 
 int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
 {
+    //  Flush messages held back by corking for longer than allowed.
+    if (unlikely (_corked_msgs) && options.cork_ivl
+        && clock_t::now_us () - _corked_since
+             >= static_cast<uint64_t> (options.cork_ivl))
+        flush_corked ();
+
     if (timeout_ == 0) {
         //  If we are asked not to wait, check whether we haven't processed
         //  commands recently, so that we can throttle the new commands.
@@ -1587,6 +1713,79 @@ void zmq::socket_base_t::update_pipe_options (int option_)
             _pipes[i]->send_hwms_to_peer (options.sndhwm, options.rcvhwm);
         }
     }
+    if (option_ == ZMQ_CORK || option_ == ZMQ_CORK_MSGS
+        || option_ == ZMQ_CORK_BYTES || option_ == ZMQ_CORK_IVL)
+        update_cork ();
+}
+
+void zmq::socket_base_t::update_cork ()
+{
+    _corked = options.cork || options.cork_msgs > 0 || options.cork_bytes > 0
+              || options.cork_ivl > 0;
+    for (pipes_t::size_type i = 0, size = _pipes.size (); i != size; ++i)
+        _pipes[i]->set_corked (_corked);
+    flush_corked ();
+
+    //  Only an I/O thread can pass on messages due while the application
+    //  does not use the socket. Launch its timer last, as this call may
+    //  not hold _sync yet.
+    if (options.cork_ivl > 0 && !_cork_timer) {
+        io_thread_t *const io_thread = choose_io_thread (options.affinity);
+        if (io_thread) {
+            _cork_timer = true;
+            _cork_sync = true;
+            cork_timer_t *const timer =
+              new (std::nothrow) cork_timer_t (io_thread, this, options);
+            alloc_assert (timer);
+            launch_child (timer);
+        }
+    }
+}
+
+void zmq::socket_base_t::count_corked (size_t size_, bool more_)
+{
+    _corked_bytes += size_;
+    if (!more_ && _corked_msgs++ == 0 && options.cork_ivl)
+        _corked_since = clock_t::now_us ();
+
+    if ((options.cork_msgs && _corked_msgs >= options.cork_msgs)
+        || (options.cork_bytes
+            && _corked_bytes >= static_cast<size_t> (options.cork_bytes)))
+        flush_corked ();
+}
+
+void zmq::socket_base_t::flush_corked ()
+{
+    for (pipes_t::size_type i = 0, size = _pipes.size (); i != size; ++i)
+        _pipes[i]->force_flush ();
+    _corked_msgs = 0;
+    _corked_bytes = 0;
+}
+
+int zmq::socket_base_t::flush_due_cork ()
+{
+    //  While the socket is in use, its own thread checks the interval.
+    if (!_sync.try_lock ())
+        return -1;
+
+    int wait = options.cork_ivl;
+    if (wait <= 0) {
+        //  Setting the interval again launches a new timer.
+        _cork_timer = false;
+        _sync.unlock ();
+        return 0;
+    }
+    if (_corked_msgs) {
+        const uint64_t held = clock_t::now_us () - _corked_since;
+        if (held >= static_cast<uint64_t> (wait))
+            flush_corked ();
+        else
+            wait -= static_cast<int> (held);
+    }
+    _sync.unlock ();
+
+    //  Timers count milliseconds.
+    return (wait + 999) / 1000;
 }
 
 void zmq::socket_base_t::process_destroy ()
@@ -1663,7 +1862,7 @@ void zmq::socket_base_t::in_event ()
     //  that may be available at the moment. Ultimately, the socket will
     //  be destroyed.
     {
-        scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+        scoped_optional_lock_t sync_lock (api_sync ());
 
         //  If the socket is thread safe we need to unsignal the reaper signaler
         if (_thread_safe)
@@ -1716,9 +1915,14 @@ void zmq::socket_base_t::hiccuped (pipe_t *pipe_)
 {
     if (options.immediate == 1)
         pipe_->terminate (false);
-    else
+    else {
         // Notify derived sockets of the hiccup
         xhiccuped (pipe_);
+
+        //  Pass on the subscriptions sent again right away.
+        if (unlikely (_corked))
+            pipe_->force_flush ();
+    }
 }
 
 void zmq::socket_base_t::pipe_terminated (pipe_t *pipe_)
@@ -2079,15 +2283,10 @@ int zmq::routing_socket_base_t::xsetsockopt (int option_,
 
 void zmq::routing_socket_base_t::xwrite_activated (pipe_t *pipe_)
 {
-    const out_pipes_t::iterator end = _out_pipes.end ();
-    out_pipes_t::iterator it;
-    for (it = _out_pipes.begin (); it != end; ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zmq_assert (it != end);
-    zmq_assert (!it->second.active);
-    it->second.active = true;
+    out_pipe_t *const out_pipe = _out_pipes.find (pipe_->get_routing_id ());
+    zmq_assert (out_pipe && out_pipe->pipe == pipe_);
+    zmq_assert (!out_pipe->active);
+    out_pipe->active = true;
 }
 
 std::string zmq::routing_socket_base_t::extract_connect_routing_id ()
@@ -2102,52 +2301,44 @@ bool zmq::routing_socket_base_t::connect_routing_id_is_set () const
     return !_connect_routing_id.empty ();
 }
 
-void zmq::routing_socket_base_t::add_out_pipe (blob_t routing_id_,
+void zmq::routing_socket_base_t::add_out_pipe (const blob_t &routing_id_,
                                                pipe_t *pipe_)
 {
     //  Add the record into output pipes lookup table
     const out_pipe_t outpipe = {pipe_, true};
-    const bool ok =
-      _out_pipes.ZMQ_MAP_INSERT_OR_EMPLACE (ZMQ_MOVE (routing_id_), outpipe)
-        .second;
+    const bool ok = _out_pipes.insert (routing_id_, outpipe);
     zmq_assert (ok);
 }
 
 bool zmq::routing_socket_base_t::has_out_pipe (const blob_t &routing_id_) const
 {
-    return 0 != _out_pipes.count (routing_id_);
+    return _out_pipes.find (routing_id_) != NULL;
 }
 
 zmq::routing_socket_base_t::out_pipe_t *
 zmq::routing_socket_base_t::lookup_out_pipe (const blob_t &routing_id_)
 {
     // TODO we could probably avoid constructor a temporary blob_t to call this function
-    out_pipes_t::iterator it = _out_pipes.find (routing_id_);
-    return it == _out_pipes.end () ? NULL : &it->second;
+    return _out_pipes.find (routing_id_);
 }
 
 const zmq::routing_socket_base_t::out_pipe_t *
 zmq::routing_socket_base_t::lookup_out_pipe (const blob_t &routing_id_) const
 {
     // TODO we could probably avoid constructor a temporary blob_t to call this function
-    const out_pipes_t::const_iterator it = _out_pipes.find (routing_id_);
-    return it == _out_pipes.end () ? NULL : &it->second;
+    return _out_pipes.find (routing_id_);
 }
 
 void zmq::routing_socket_base_t::erase_out_pipe (const pipe_t *pipe_)
 {
-    const size_t erased = _out_pipes.erase (pipe_->get_routing_id ());
+    const bool erased = _out_pipes.erase (pipe_->get_routing_id ());
     zmq_assert (erased);
 }
 
 zmq::routing_socket_base_t::out_pipe_t
 zmq::routing_socket_base_t::try_erase_out_pipe (const blob_t &routing_id_)
 {
-    const out_pipes_t::iterator it = _out_pipes.find (routing_id_);
     out_pipe_t res = {NULL, false};
-    if (it != _out_pipes.end ()) {
-        res = it->second;
-        _out_pipes.erase (it);
-    }
+    _out_pipes.erase (routing_id_, &res);
     return res;
 }
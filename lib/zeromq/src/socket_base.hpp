@@ -10,6 +10,7 @@
 #include "own.hpp"
 #include "array.hpp"
 #include "blob.hpp"
+#include "blob_map.hpp"
 #include "stdint.hpp"
 #include "poller.hpp"
 #include "i_poll_events.hpp"
@@ -280,6 +281,30 @@ class socket_base_t : public own_t,
 
     void update_pipe_options (int option_);
 
+    //  Corks or uncorks the pipes as the cork options say, flushing the
+    //  messages held so far.
+    void update_cork ();
+
+    //  Accounts for a message part written while the pipes are corked,
+    //  and flushes them once the message or byte limit is reached.
+    void count_corked (size_t size_, bool more_);
+
+    //  Passes the messages held by corked pipes on to their readers.
+    void flush_corked ();
+
+    //  Called by the cork timer on its I/O thread. Flushes the messages
+    //  held for longer than ZMQ_CORK_IVL and returns the milliseconds
+    //  until the timer should look again, -1 if the socket is in use, or
+    //  0 if the interval is unset and the timer should stop.
+    int flush_due_cork ();
+    friend class cork_timer_t;
+
+    //  Mutex that API calls take, if any.
+    mutex_t *api_sync ()
+    {
+        return _thread_safe || _cork_sync ? &_sync : NULL;
+    }
+
     std::string resolve_tcp_addr (std::string endpoint_uri_,
                                   const char *tcp_address_);
 
@@ -306,6 +331,22 @@ class socket_base_t : public own_t,
     //  Improves efficiency of time measurement.
     clock_t _clock;
 
+    //  True if the pipes are corked. The number of messages and bytes
+    //  written since they were last flushed, and when the first of these
+    //  messages was written.
+    bool _corked;
+    int _corked_msgs;
+    size_t _corked_bytes;
+    uint64_t _corked_since;
+
+    //  True while the cork timer runs. Accessed under _sync once the
+    //  first timer was launched.
+    bool _cork_timer;
+
+    //  True once a cork timer was launched. API calls take _sync from
+    //  then on, as a timer may still be running.
+    bool _cork_sync;
+
     // Monitor socket;
     void *_monitor_socket;
 
@@ -352,7 +393,7 @@ class routing_socket_base_t : public socket_base_t
         bool active;
     };
 
-    void add_out_pipe (blob_t routing_id_, pipe_t *pipe_);
+    void add_out_pipe (const blob_t &routing_id_, pipe_t *pipe_);
     bool has_out_pipe (const blob_t &routing_id_) const;
     out_pipe_t *lookup_out_pipe (const blob_t &routing_id_);
     const out_pipe_t *lookup_out_pipe (const blob_t &routing_id_) const;
@@ -360,19 +401,24 @@ class routing_socket_base_t : public socket_base_t
     out_pipe_t try_erase_out_pipe (const blob_t &routing_id_);
     template <typename Func> bool any_of_out_pipes (Func func_)
     {
-        bool res = false;
-        for (out_pipes_t::iterator it = _out_pipes.begin (),
-                                   end = _out_pipes.end ();
-             it != end && !res; ++it) {
-            res |= func_ (*it->second.pipe);
-        }
-
-        return res;
+        return _out_pipes.any_of (pipe_func_t<Func> (func_));
     }
 
   private:
-    //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<blob_t, out_pipe_t> out_pipes_t;
+    //  Adapts a function on pipes to the out_pipe_t records.
+    template <typename Func> struct pipe_func_t
+    {
+        explicit pipe_func_t (Func func_) : func (func_) {}
+        bool operator() (const out_pipe_t &out_pipe_)
+        {
+            return func (*out_pipe_.pipe);
+        }
+        Func func;
+    };
+
+    //  Outbound pipes indexed by the peer IDs. Every ROUTER send looks
+    //  its peer up here, so this is a hash table rather than a tree.
+    typedef blob_map_t<out_pipe_t> out_pipes_t;
     out_pipes_t _out_pipes;
 
     // Next assigned name on a zmq_connect() call used by ROUTER and STREAM socket types
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_SPIN_HPP_INCLUDED__
+#define __ZMQ_SPIN_HPP_INCLUDED__
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <unistd.h>
+#endif
+
+namespace zmq
+{
+//  Spinning only pays off if another thread can run while one spins.
+inline bool spin_enabled ()
+{
+#if defined ZMQ_HAVE_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo (&info);
+    return info.dwNumberOfProcessors > 1;
+#elif defined _SC_NPROCESSORS_ONLN
+    return sysconf (_SC_NPROCESSORS_ONLN) > 1;
+#else
+    return false;
+#endif
+}
+
+//  Hints the CPU that the thread is busy waiting.
+inline void spin_pause ()
+{
+#if defined _MSC_VER
+    YieldProcessor ();
+#elif (defined __i386__ || defined __x86_64__) && defined __GNUC__
+    __builtin_ia32_pause ();
+#elif defined __aarch64__ && defined __GNUC__
+    __asm__ __volatile__ ("yield");
+#endif
+}
+}
+
+#endif
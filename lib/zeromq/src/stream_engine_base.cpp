@@ -72,6 +72,100 @@ static std::string get_peer_address (zmq::fd_t s_)
     return peer_address;
 }
 
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+//  Releases the messages of the zero-copy writes the kernel reports done.
+//  Reports come in the order of the writes, first_ being the number the
+//  kernel gave the oldest write in msgs_. Counts the reports saying the
+//  data had to be copied anyway in copied_, and resets it on any other.
+static void release_zerocopy_msgs (zmq::fd_t s_,
+                                   std::deque<zmq::msg_t> &msgs_,
+                                   uint32_t &first_,
+                                   int &copied_)
+{
+    uint32_t first;
+    uint32_t last;
+    bool copied;
+    int rc;
+    while ((rc = zmq::tcp_read_zerocopy_completion (s_, &first, &last,
+                                                    &copied))
+           != -1) {
+        if (rc == 0)
+            continue;
+
+        copied_ = copied ? copied_ + 1 : 0;
+
+        LIBZMQ_UNUSED (first);
+        while (!msgs_.empty () && static_cast<int32_t> (last - first_) >= 0) {
+            rc = msgs_.front ().close ();
+            errno_assert (rc == 0);
+            msgs_.pop_front ();
+            first_++;
+        }
+    }
+}
+
+namespace zmq
+{
+//  Takes over the socket of a closed engine whose zero-copy writes the
+//  kernel has not reported done yet, as it may still send from their
+//  messages. It polls for the reports on a timer of the I/O thread and
+//  closes the socket once they are all in, or after a while.
+class zerocopy_drain_t ZMQ_FINAL : public io_object_t
+{
+  public:
+    zerocopy_drain_t (io_thread_t *io_thread_,
+                      fd_t s_,
+                      std::deque<msg_t> &msgs_,
+                      uint32_t first_) :
+        io_object_t (io_thread_), _s (s_), _first (first_), _waited (0)
+    {
+        _msgs.swap (msgs_);
+        add_timer (zerocopy_drain_interval, drain_timer_id);
+    }
+
+    void timer_event (int id_) ZMQ_FINAL
+    {
+        zmq_assert (id_ == drain_timer_id);
+        int copied = 0;
+        release_zerocopy_msgs (_s, _msgs, _first, copied);
+        _waited += zerocopy_drain_interval;
+        if (!_msgs.empty () && _waited < zerocopy_drain_timeout) {
+            add_timer (zerocopy_drain_interval, drain_timer_id);
+            return;
+        }
+        unplug ();
+        delete this;
+    }
+
+  private:
+    ~zerocopy_drain_t () ZMQ_FINAL
+    {
+        //  Writes still not reported done are given up on.
+        for (std::deque<msg_t>::iterator it = _msgs.begin (),
+                                         end = _msgs.end ();
+             it != end; ++it) {
+            const int rc = it->close ();
+            errno_assert (rc == 0);
+        }
+        const int rc = close (_s);
+        errno_assert (rc == 0);
+    }
+
+    enum
+    {
+        drain_timer_id = 0x60
+    };
+
+    const fd_t _s;
+    std::deque<msg_t> _msgs;
+    uint32_t _first;
+    int _waited;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (zerocopy_drain_t)
+};
+}
+#endif
+
 zmq::stream_engine_base_t::stream_engine_base_t (
   fd_t fd_,
   const options_t &options_,
@@ -108,6 +202,18 @@ zmq::stream_engine_base_t::stream_engine_base_t (
     const int rc = _tx_msg.init ();
     errno_assert (rc == 0);
 
+#if defined ZMQ_HAVE_WRITEV
+    _out_iov_threshold = 0;
+    _out_iovcnt = 0;
+    _out_iov_pos = 0;
+#endif
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    _zerocopy = false;
+    _zerocopy_first = 0;
+    _zerocopy_copied = 0;
+    _io_thread = NULL;
+#endif
+
     //  Put the socket into non-blocking mode.
     unblock_socket (_s);
 }
@@ -166,6 +272,20 @@ void zmq::stream_engine_base_t::plug (io_thread_t *io_thread_,
     _handle = add_fd (_s);
     _io_error = false;
 
+#if defined ZMQ_HAVE_WRITEV
+    _out_iov_threshold = static_cast<size_t> (_options.writev_threshold);
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    const size_t zerocopy_threshold =
+      static_cast<size_t> (_options.zerocopy_threshold);
+    _zerocopy = zerocopy_threshold > 0 && enable_zerocopy ();
+    _zerocopy_copied = 0;
+    _io_thread = io_thread_;
+    if (_zerocopy
+        && (!_out_iov_threshold || zerocopy_threshold < _out_iov_threshold))
+        _out_iov_threshold = zerocopy_threshold;
+#endif
+#endif
+
     plug_internal ();
 }
 
@@ -198,6 +318,20 @@ void zmq::stream_engine_base_t::unplug ()
     if (!_io_error)
         rm_fd (_handle);
 
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    //  Leave the socket and the messages of writes in progress to a drain
+    //  object rather than waiting for the kernel here.
+    if (!_zerocopy_msgs.empty ()) {
+        read_zerocopy_completions ();
+        if (!_zerocopy_msgs.empty ()) {
+            zerocopy_drain_t *drain = new (std::nothrow) zerocopy_drain_t (
+              _io_thread, _s, _zerocopy_msgs, _zerocopy_first);
+            alloc_assert (drain);
+            _s = retired_fd;
+        }
+    }
+#endif
+
     //  Disconnect from I/O threads poller object.
     io_object_t::unplug ();
 
@@ -212,6 +346,16 @@ void zmq::stream_engine_base_t::terminate ()
 
 void zmq::stream_engine_base_t::in_event ()
 {
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    //  Write completions are signalled as errors, which are reported even
+    //  while input is stopped.
+    if (!_zerocopy_msgs.empty ()) {
+        read_zerocopy_completions ();
+        if (_input_stopped)
+            return;
+    }
+#endif
+
     // ignore errors
     const bool res = in_event_internal ();
     LIBZMQ_UNUSED (res);
@@ -271,6 +415,7 @@ bool zmq::stream_engine_base_t::in_event_internal ()
 
         //  Adjust input size
         _insize = static_cast<size_t> (rc);
+        add_bytes (_insize);
         // Adjust buffer size to received bytes
         _decoder->resize_buffer (_insize);
     }
@@ -309,6 +454,14 @@ void zmq::stream_engine_base_t::out_event ()
 {
     zmq_assert (!_io_error);
 
+#if defined ZMQ_HAVE_WRITEV
+    //  Once the handshake data has been written, switch to the gather list.
+    if (_out_iov_threshold && !_handshaking && !_outsize) {
+        out_event_iov ();
+        return;
+    }
+#endif
+
     //  If write buffer is empty, try to read new data from the encoder.
     if (!_outsize) {
         //  Even when we stop polling as soon as there is no
@@ -366,6 +519,7 @@ void zmq::stream_engine_base_t::out_event ()
 
     _outpos += nbytes;
     _outsize -= nbytes;
+    add_bytes (nbytes);
 
     //  If we are still handshaking and there are no data
     //  to send, stop polling for output.
@@ -374,6 +528,134 @@ void zmq::stream_engine_base_t::out_event ()
             reset_pollout ();
 }
 
+#if defined ZMQ_HAVE_WRITEV
+void zmq::stream_engine_base_t::out_event_iov ()
+{
+    //  If the gather list has been written, build the next one.
+    if (_out_iov_pos == _out_iovcnt) {
+        if (unlikely (_encoder == NULL))
+            return;
+
+        _encoder->release_iov ();
+        _out_iovcnt = 0;
+        _out_iov_pos = 0;
+
+        size_t size = 0;
+        bool done = _encoder->encode_iov (_out_iov, &_out_iovcnt, out_iov_max,
+                                          _out_iov_threshold, &size);
+        while (done && size < static_cast<size_t> (_options.out_batch_size)) {
+            if ((this->*_next_msg) (&_tx_msg) == -1) {
+                //  ws_engine can cause an engine error and delete it, so
+                //  bail out immediately to avoid use-after-free
+                if (errno == ECONNRESET)
+                    return;
+                else
+                    break;
+            }
+            _encoder->load_msg (&_tx_msg);
+            done = _encoder->encode_iov (_out_iov, &_out_iovcnt, out_iov_max,
+                                         _out_iov_threshold, &size);
+        }
+
+        //  If there is no data to send, stop polling for output.
+        if (_out_iovcnt == 0) {
+            _output_stopped = true;
+            reset_pollout ();
+            return;
+        }
+    }
+
+    const int nbytes = write_iov ();
+
+    //  IO error has occurred. We stop waiting for output events.
+    if (nbytes == -1) {
+        reset_pollout ();
+        return;
+    }
+
+    //  Skip the entries written and trim the one written in part.
+    size_t written = static_cast<size_t> (nbytes);
+    add_bytes (written);
+    while (written) {
+        iovec &iov = _out_iov[_out_iov_pos];
+        if (written < iov.iov_len) {
+            iov.iov_base =
+              static_cast<unsigned char *> (iov.iov_base) + written;
+            iov.iov_len -= written;
+            break;
+        }
+        written -= iov.iov_len;
+        _out_iov_pos++;
+    }
+}
+
+int zmq::stream_engine_base_t::write_iov ()
+{
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    if (_zerocopy)
+        return write_iov_zerocopy ();
+#endif
+    return writev (_out_iov + _out_iov_pos, _out_iovcnt - _out_iov_pos);
+}
+
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+int zmq::stream_engine_base_t::write_iov_zerocopy ()
+{
+    //  Bodies large enough are written on their own with MSG_ZEROCOPY and
+    //  the entries between them with plain writes. Bodies held inside
+    //  their msg_t are not, the encoder reuses those.
+    const size_t threshold = static_cast<size_t> (_options.zerocopy_threshold);
+    int pos = _out_iov_pos;
+    int total = 0;
+    while (pos != _out_iovcnt) {
+        msg_t *msg = NULL;
+        int end = pos;
+        for (; end != _out_iovcnt; end++) {
+            if (_out_iov[end].iov_len < threshold)
+                continue;
+            msg = _encoder->iov_msg (_out_iov[end].iov_base);
+            if (msg && !msg->is_vsm ())
+                break;
+            msg = NULL;
+        }
+
+        if (end != pos) {
+            size_t size = 0;
+            for (int i = pos; i != end; i++)
+                size += _out_iov[i].iov_len;
+            const int nbytes = writev (_out_iov + pos, end - pos);
+            if (nbytes == -1)
+                return total ? total : -1;
+            total += nbytes;
+            if (static_cast<size_t> (nbytes) != size || end == _out_iovcnt)
+                return total;
+            pos = end;
+        }
+
+        const iovec &iov = _out_iov[pos];
+        int nbytes = tcp_write_zerocopy (_s, iov.iov_base, iov.iov_len);
+        if (nbytes == -1 && errno == ENOBUFS)
+            nbytes = writev (&iov, 1);
+        else if (nbytes > 0) {
+            //  Keep a reference until the kernel reports this write done.
+            _zerocopy_msgs.push_back (msg_t ());
+            int rc = _zerocopy_msgs.back ().init ();
+            errno_assert (rc == 0);
+            rc = _zerocopy_msgs.back ().copy (*msg);
+            errno_assert (rc == 0);
+        }
+        if (nbytes == -1)
+            return total ? total : -1;
+        total += nbytes;
+        if (static_cast<size_t> (nbytes) != iov.iov_len)
+            return total;
+        pos++;
+    }
+    return total;
+}
+#endif
+#endif
+
 void zmq::stream_engine_base_t::restart_output ()
 {
     if (unlikely (_io_error))
@@ -764,3 +1046,28 @@ int zmq::stream_engine_base_t::write (const void *data_, size_t size_)
 {
     return zmq::tcp_write (_s, data_, size_);
 }
+
+#if defined ZMQ_HAVE_WRITEV
+int zmq::stream_engine_base_t::writev (const iovec *iov_, int iovcnt_)
+{
+    return zmq::tcp_writev (_s, iov_, iovcnt_);
+}
+#endif
+
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+bool zmq::stream_engine_base_t::enable_zerocopy ()
+{
+    return zmq::tcp_enable_zerocopy (_s) == 0;
+}
+
+void zmq::stream_engine_base_t::read_zerocopy_completions ()
+{
+    release_zerocopy_msgs (_s, _zerocopy_msgs, _zerocopy_first,
+                           _zerocopy_copied);
+
+    //  If the kernel keeps having to copy the data anyway, as it does on
+    //  loopback, zero-copy writes only add the cost of the reports.
+    if (_zerocopy_copied >= zerocopy_max_copied)
+        _zerocopy = false;
+}
+#endif
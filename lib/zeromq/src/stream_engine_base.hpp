@@ -4,6 +4,7 @@
 #define __ZMQ_STREAM_ENGINE_BASE_HPP_INCLUDED__
 
 #include <stddef.h>
+#include <deque>
 
 #include "fd.hpp"
 #include "i_engine.hpp"
@@ -94,6 +95,14 @@ class stream_engine_base_t : public io_object_t, public i_engine
 
     virtual int read (void *data, size_t size_);
     virtual int write (const void *data_, size_t size_);
+#if defined ZMQ_HAVE_WRITEV
+    virtual int writev (const iovec *iov_, int iovcnt_);
+#endif
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    //  Returns true if message bodies can be written to the socket with
+    //  MSG_ZEROCOPY.
+    virtual bool enable_zerocopy ();
+#endif
 
     void reset_pollout () { io_object_t::reset_pollout (_handle); }
     void set_pollout () { io_object_t::set_pollout (_handle); }
@@ -154,6 +163,48 @@ class stream_engine_base_t : public io_object_t, public i_engine
   private:
     bool in_event_internal ();
 
+#if defined ZMQ_HAVE_WRITEV
+    //  Output path used when the writev threshold is set: the encoder
+    //  fills a gather list that references large message bodies instead
+    //  of copying them to the write buffer.
+    void out_event_iov ();
+    int write_iov ();
+
+    //  Size from which message bodies are referenced by the gather list,
+    //  zero if the output goes through the write buffer.
+    size_t _out_iov_threshold;
+
+    enum
+    {
+        out_iov_max = 64
+    };
+    iovec _out_iov[out_iov_max];
+    int _out_iovcnt;
+
+    //  First entry of the gather list not completely written.
+    int _out_iov_pos;
+#endif
+
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    int write_iov_zerocopy ();
+    void read_zerocopy_completions ();
+
+    //  True iff bodies of at least the zerocopy threshold are written
+    //  with MSG_ZEROCOPY.
+    bool _zerocopy;
+
+    //  Messages written with MSG_ZEROCOPY the kernel may still be using,
+    //  oldest first, and the number the kernel gave the oldest write.
+    std::deque<msg_t> _zerocopy_msgs;
+    uint32_t _zerocopy_first;
+
+    //  Number of consecutive reports that the kernel copied the data.
+    int _zerocopy_copied;
+
+    //  Thread the writes still in progress are drained on at unplug.
+    io_thread_t *_io_thread;
+#endif
+
     //  Unplug the engine from the session.
     void unplug ();
 
@@ -7,6 +7,8 @@
 #include "err.hpp"
 #include "options.hpp"
 
+#include <string.h>
+
 #if !defined ZMQ_HAVE_WINDOWS
 #include <fcntl.h>
 #include <sys/types.h>
@@ -183,6 +185,37 @@ int zmq::tune_tcp_maxrt (fd_t sockfd_, int timeout_)
 #endif
 }
 
+#if !defined ZMQ_HAVE_WINDOWS
+//  Turns the result of send or sendmsg into what tcp_write returns.
+static int send_result (ssize_t nbytes_)
+{
+    //  Several errors are OK. When speculative write is being done we may not
+    //  be able to write a single byte from the socket. Also, SIGSTOP issued
+    //  by a debugging tool can result in EINTR error.
+    if (nbytes_ == -1
+        && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return 0;
+
+    //  Signalise peer failure.
+    if (nbytes_ == -1) {
+#if !defined(TARGET_OS_IPHONE) || !TARGET_OS_IPHONE
+        errno_assert (errno != EACCES && errno != EBADF && errno != EDESTADDRREQ
+                      && errno != EFAULT && errno != EISCONN
+                      && errno != EMSGSIZE && errno != ENOMEM
+                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
+#else
+        errno_assert (errno != EACCES && errno != EDESTADDRREQ
+                      && errno != EFAULT && errno != EISCONN
+                      && errno != EMSGSIZE && errno != ENOMEM
+                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
+#endif
+        return -1;
+    }
+
+    return static_cast<int> (nbytes_);
+}
+#endif
+
 int zmq::tcp_write (fd_t s_, const void *data_, size_t size_)
 {
 #ifdef ZMQ_HAVE_WINDOWS
@@ -212,35 +245,72 @@ int zmq::tcp_write (fd_t s_, const void *data_, size_t size_)
     return nbytes;
 
 #else
-    ssize_t nbytes = send (s_, static_cast<const char *> (data_), size_, 0);
-
-    //  Several errors are OK. When speculative write is being done we may not
-    //  be able to write a single byte from the socket. Also, SIGSTOP issued
-    //  by a debugging tool can result in EINTR error.
-    if (nbytes == -1
-        && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
-        return 0;
+    const ssize_t nbytes =
+      send (s_, static_cast<const char *> (data_), size_, 0);
+    return send_result (nbytes);
+#endif
+}
 
-    //  Signalise peer failure.
-    if (nbytes == -1) {
-#if !defined(TARGET_OS_IPHONE) || !TARGET_OS_IPHONE
-        errno_assert (errno != EACCES && errno != EBADF && errno != EDESTADDRREQ
-                      && errno != EFAULT && errno != EISCONN
-                      && errno != EMSGSIZE && errno != ENOMEM
-                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
-#else
-        errno_assert (errno != EACCES && errno != EDESTADDRREQ
-                      && errno != EFAULT && errno != EISCONN
-                      && errno != EMSGSIZE && errno != ENOMEM
-                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
+#if defined ZMQ_HAVE_WRITEV
+int zmq::tcp_writev (fd_t s_, const iovec *iov_, int iovcnt_)
+{
+    msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_iov = const_cast<iovec *> (iov_);
+    msg.msg_iovlen = iovcnt_;
+    return send_result (sendmsg (s_, &msg, 0));
+}
 #endif
+
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+int zmq::tcp_enable_zerocopy (fd_t s_)
+{
+    int on = 1;
+    return setsockopt (s_, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof on);
+}
+
+int zmq::tcp_write_zerocopy (fd_t s_, const void *data_, size_t size_)
+{
+    const ssize_t nbytes =
+      send (s_, static_cast<const char *> (data_), size_, MSG_ZEROCOPY);
+
+    //  Out of memory to track the pages sent.
+    if (nbytes == -1 && errno == ENOBUFS)
         return -1;
-    }
+    return send_result (nbytes);
+}
 
-    return static_cast<int> (nbytes);
+int zmq::tcp_read_zerocopy_completion (fd_t s_,
+                                       uint32_t *first_,
+                                       uint32_t *last_,
+                                       bool *copied_)
+{
+    char control[CMSG_SPACE (sizeof (sock_extended_err) + 64)];
+    msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    if (recvmsg (s_, &msg, MSG_ERRQUEUE) == -1)
+        return -1;
 
-#endif
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR (&msg); cmsg;
+         cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+        if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+            && !(cmsg->cmsg_level == SOL_IPV6
+                 && cmsg->cmsg_type == IPV6_RECVERR))
+            continue;
+        const sock_extended_err *err =
+          reinterpret_cast<const sock_extended_err *> (CMSG_DATA (cmsg));
+        if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            continue;
+        *first_ = err->ee_info;
+        *last_ = err->ee_data;
+        *copied_ = (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+        return 1;
+    }
+    return 0;
 }
+#endif
 
 int zmq::tcp_read (fd_t s_, void *data_, size_t size_)
 {
@@ -4,6 +4,20 @@
 #define __ZMQ_TCP_HPP_INCLUDED__
 
 #include "fd.hpp"
+#include "macros.hpp"
+#include "stdint.hpp"
+
+#if defined ZMQ_HAVE_WRITEV
+#include <sys/uio.h>
+#endif
+
+#if defined ZMQ_HAVE_LINUX && defined ZMQ_HAVE_WRITEV
+#include <sys/socket.h>
+#include <linux/errqueue.h>
+#if defined SO_ZEROCOPY && defined MSG_ZEROCOPY && defined SO_EE_ORIGIN_ZEROCOPY
+#define ZMQ_HAVE_TCP_ZEROCOPY
+#endif
+#endif
 
 namespace zmq
 {
@@ -34,6 +48,33 @@ int tune_tcp_maxrt (fd_t sockfd_, int timeout_);
 //  of error or orderly shutdown by the other peer -1 is returned.
 int tcp_write (fd_t s_, const void *data_, size_t size_);
 
+#if defined ZMQ_HAVE_WRITEV
+//  Writes the data described by a gather list to the socket. Returns
+//  the same as tcp_write.
+int tcp_writev (fd_t s_, const iovec *iov_, int iovcnt_);
+#endif
+
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+//  Allows MSG_ZEROCOPY writes on the socket. Returns -1 if the kernel or
+//  the socket does not support them.
+int tcp_enable_zerocopy (fd_t s_);
+
+//  Writes data to the socket with MSG_ZEROCOPY. The kernel keeps using the
+//  data until it reports the write as complete. Returns the same as
+//  tcp_write, except that -1 with errno set to ENOBUFS means the write was
+//  not done and can be retried with tcp_write.
+int tcp_write_zerocopy (fd_t s_, const void *data_, size_t size_);
+
+//  Reads a report from the socket's error queue. Returns 1 and the range
+//  of MSG_ZEROCOPY writes completed if it was a completion report, 0 if it
+//  was another report and -1 if the queue is empty. copied_ tells whether
+//  the kernel ended up copying the data anyway.
+int tcp_read_zerocopy_completion (fd_t s_,
+                                  uint32_t *first_,
+                                  uint32_t *last_,
+                                  bool *copied_);
+#endif
+
 //  Reads data from the socket (up to 'size' bytes).
 //  Returns the number of bytes actually read or -1 on error.
 //  Zero indicates the peer has closed the connection.
@@ -0,0 +1,417 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "timer_wheel.hpp"
+#include "err.hpp"
+
+#include <string.h>
+
+static int lowest_bit (uint64_t bits_)
+{
+#if defined __GNUC__
+    return __builtin_ctzll (bits_);
+#else
+    int bit = 0;
+    while (!(bits_ & 1)) {
+        bits_ >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+const uint32_t zmq::timer_wheel_t::nil;
+
+zmq::timer_wheel_t::timer_wheel_t () : _free (nil), _now (0), _count (0)
+{
+    for (int i = 0; i != far_slot + 1; i++)
+        _heads[i] = nil;
+    memset (_occupied, 0, sizeof _occupied);
+    memset (_level_count, 0, sizeof _level_count);
+    _buckets.resize (64, nil);
+}
+
+void zmq::timer_wheel_t::add (
+  uint64_t now_, uint64_t expiration_, void *owner_, int id_, void *arg_)
+{
+    //  Nothing refers to the current time of an empty wheel.
+    if (_count == 0)
+        _now = now_;
+    if (_count >= _buckets.size ())
+        rehash ();
+
+    const uint32_t index = alloc_node ();
+    node_t &node = _nodes[index];
+    node.expiration = expiration_;
+    node.owner = owner_;
+    node.arg = arg_;
+    node.id = id_;
+    place (index);
+    hash_insert (index);
+    _count++;
+}
+
+bool zmq::timer_wheel_t::cancel (void *owner_, int id_, void **arg_)
+{
+    const uint32_t index = lookup (owner_, id_);
+    if (index == nil)
+        return false;
+    if (arg_)
+        *arg_ = _nodes[index].arg;
+    remove (index);
+    return true;
+}
+
+bool zmq::timer_wheel_t::find (void *owner_,
+                               int id_,
+                               uint64_t *expiration_,
+                               void **arg_)
+{
+    const uint32_t index = lookup (owner_, id_);
+    if (index == nil)
+        return false;
+    *expiration_ = _nodes[index].expiration;
+    *arg_ = _nodes[index].arg;
+    return true;
+}
+
+bool zmq::timer_wheel_t::expire (uint64_t now_,
+                                 void **owner_,
+                                 int *id_,
+                                 void **arg_)
+{
+    while (_heads[due_slot] == nil) {
+        if (_count == 0 || _now > now_)
+            return false;
+        step (now_);
+    }
+
+    const uint32_t index = _heads[due_slot];
+    *owner_ = _nodes[index].owner;
+    *id_ = _nodes[index].id;
+    *arg_ = _nodes[index].arg;
+    remove (index);
+    return true;
+}
+
+bool zmq::timer_wheel_t::pop (void **owner_, int *id_, void **arg_)
+{
+    if (_count == 0)
+        return false;
+
+    //  Any node in use will do; free nodes have no slot.
+    for (uint32_t index = 0;; index++)
+        if (_nodes[index].slot != nil) {
+            *owner_ = _nodes[index].owner;
+            *id_ = _nodes[index].id;
+            *arg_ = _nodes[index].arg;
+            remove (index);
+            return true;
+        }
+}
+
+uint64_t zmq::timer_wheel_t::next_expiration () const
+{
+    zmq_assert (_count > 0);
+
+    //  The due list is in the order of expiration.
+    if (_heads[due_slot] != nil)
+        return _nodes[_heads[due_slot]].expiration;
+
+    //  The timers of a level 0 slot all expire at the same tick, and the
+    //  first occupied slot from the current tick on holds the earliest
+    //  of them. On higher levels, the first occupied slot after the
+    //  current one holds the earliest timers of the level.
+    uint64_t res = ~uint64_t (0);
+    const int first = find_slot (0, static_cast<unsigned> (_now & slot_mask));
+    if (first != -1)
+        res = _now + ((first - _now) & slot_mask);
+    for (int level = 1; level != levels; level++) {
+        if (!_level_count[level])
+            continue;
+        const int slot = find_slot (
+          level, static_cast<unsigned> (((_now >> (slot_bits * level)) + 1)
+                                        & slot_mask));
+        zmq_assert (slot != -1);
+        const uint64_t min = _slot_min[level * slots + slot];
+        if (min < res)
+            res = min;
+    }
+    if (_heads[far_slot] != nil && _slot_min[far_slot] < res)
+        res = _slot_min[far_slot];
+    return res;
+}
+
+uint32_t zmq::timer_wheel_t::alloc_node ()
+{
+    if (_free != nil) {
+        const uint32_t index = _free;
+        _free = _nodes[index].next;
+        return index;
+    }
+    _nodes.push_back (node_t ());
+    return static_cast<uint32_t> (_nodes.size () - 1);
+}
+
+void zmq::timer_wheel_t::free_node (uint32_t index_)
+{
+    _nodes[index_].slot = nil;
+    _nodes[index_].next = _free;
+    _free = index_;
+}
+
+void zmq::timer_wheel_t::place (uint32_t index_)
+{
+    node_t &node = _nodes[index_];
+    const uint64_t expiration = node.expiration;
+
+    //  Ticks before the current one have been moved to the due list
+    //  already, so timers expiring at them go straight there.
+    if (expiration < _now) {
+        link_due (index_);
+        return;
+    }
+    const uint64_t delta = expiration - _now;
+
+    if (delta >> (slot_bits * levels) != 0) {
+        if (_heads[far_slot] == nil || expiration < _slot_min[far_slot])
+            _slot_min[far_slot] = expiration;
+        link (far_slot, index_);
+        return;
+    }
+
+    int level = 0;
+    while (level != levels - 1
+           && delta >> (slot_bits * (level + 1)) != 0)
+        level++;
+
+    const unsigned slot =
+      static_cast<unsigned> ((expiration >> (slot_bits * level)) & slot_mask);
+
+    const uint32_t at = level * slots + slot;
+    if (_heads[at] == nil) {
+        _occupied[level][slot / 64] |= uint64_t (1) << (slot % 64);
+        _slot_min[at] = expiration;
+    } else if (expiration < _slot_min[at])
+        _slot_min[at] = expiration;
+    _level_count[level]++;
+    link (at, index_);
+}
+
+void zmq::timer_wheel_t::link (uint32_t slot_, uint32_t index_)
+{
+    node_t &node = _nodes[index_];
+    node.slot = slot_;
+    const uint32_t head = _heads[slot_];
+    if (head == nil) {
+        node.prev = index_;
+        node.next = index_;
+        _heads[slot_] = index_;
+    } else {
+        //  Append, so that the timers of a tick expire in order.
+        const uint32_t tail = _nodes[head].prev;
+        node.prev = tail;
+        node.next = head;
+        _nodes[tail].next = index_;
+        _nodes[head].prev = index_;
+    }
+}
+
+void zmq::timer_wheel_t::link_due (uint32_t index_)
+{
+    //  Insert after the last timer expiring no later, which is usually
+    //  the tail.
+    const uint32_t head = _heads[due_slot];
+    if (head == nil) {
+        link (due_slot, index_);
+        return;
+    }
+    const uint64_t expiration = _nodes[index_].expiration;
+    uint32_t prev = _nodes[head].prev;
+    while (_nodes[prev].expiration > expiration) {
+        if (prev == head) {
+            //  Earlier than all of them, so it becomes the new head.
+            link (due_slot, index_);
+            _heads[due_slot] = index_;
+            return;
+        }
+        prev = _nodes[prev].prev;
+    }
+    node_t &node = _nodes[index_];
+    node.slot = due_slot;
+    node.prev = prev;
+    node.next = _nodes[prev].next;
+    _nodes[node.next].prev = index_;
+    _nodes[prev].next = index_;
+}
+
+void zmq::timer_wheel_t::unlink (uint32_t index_)
+{
+    node_t &node = _nodes[index_];
+    const uint32_t slot = node.slot;
+    if (node.next == index_)
+        _heads[slot] = nil;
+    else {
+        _nodes[node.prev].next = node.next;
+        _nodes[node.next].prev = node.prev;
+        if (_heads[slot] == index_)
+            _heads[slot] = node.next;
+    }
+
+    if (slot < due_slot) {
+        const int level = slot / slots;
+        _level_count[level]--;
+        if (_heads[slot] == nil) {
+            const unsigned i = slot % slots;
+            _occupied[level][i / 64] &= ~(uint64_t (1) << (i % 64));
+        }
+    }
+}
+
+void zmq::timer_wheel_t::remove (uint32_t index_)
+{
+    unlink (index_);
+    hash_erase (index_);
+    free_node (index_);
+    _count--;
+}
+
+uint32_t zmq::timer_wheel_t::bucket (void *owner_, int id_) const
+{
+    uint64_t h =
+      static_cast<uint64_t> (reinterpret_cast<size_t> (owner_)) ^ id_;
+    h *= 0x9e3779b97f4a7c15ULL;
+    return static_cast<uint32_t> (h >> 32)
+           & static_cast<uint32_t> (_buckets.size () - 1);
+}
+
+uint32_t zmq::timer_wheel_t::lookup (void *owner_, int id_) const
+{
+    for (uint32_t index = _buckets[bucket (owner_, id_)]; index != nil;
+         index = _nodes[index].hash_next)
+        if (_nodes[index].owner == owner_ && _nodes[index].id == id_)
+            return index;
+    return nil;
+}
+
+void zmq::timer_wheel_t::hash_insert (uint32_t index_)
+{
+    node_t &node = _nodes[index_];
+    uint32_t &head = _buckets[bucket (node.owner, node.id)];
+    node.hash_next = head;
+    head = index_;
+}
+
+void zmq::timer_wheel_t::hash_erase (uint32_t index_)
+{
+    const node_t &node = _nodes[index_];
+    uint32_t *link = &_buckets[bucket (node.owner, node.id)];
+    while (*link != index_)
+        link = &_nodes[*link].hash_next;
+    *link = node.hash_next;
+}
+
+void zmq::timer_wheel_t::rehash ()
+{
+    _buckets.assign (_buckets.size () * 2, nil);
+    for (uint32_t index = 0; index != _nodes.size (); index++) {
+        node_t &node = _nodes[index];
+        if (node.slot == nil)
+            continue;
+        uint32_t &head = _buckets[bucket (node.owner, node.id)];
+        node.hash_next = head;
+        head = index;
+    }
+}
+
+void zmq::timer_wheel_t::step (uint64_t now_)
+{
+    //  Move the timers of the current tick to the due list.
+    const uint32_t slot = static_cast<uint32_t> (_now & slot_mask);
+    while (_heads[slot] != nil) {
+        const uint32_t index = _heads[slot];
+        unlink (index);
+        link (due_slot, index);
+    }
+
+    //  Skip to the next tick with timers on level 0, or at which timers
+    //  move down a level. Far timers are looked at when the top level
+    //  moves on.
+    int level = 0;
+    while (level != levels && _level_count[level] == 0)
+        level++;
+    if (level == levels && _heads[far_slot] != nil)
+        level = levels - 1;
+    uint64_t next = now_ + 1;
+    if (level == 0) {
+        const unsigned start = static_cast<unsigned> ((_now + 1) & slot_mask);
+        const unsigned first = static_cast<unsigned> (find_slot (0, start));
+        next = _now + 1 + ((first - start) & slot_mask);
+        level = 1;
+    }
+    if (level != levels) {
+        const uint64_t boundary =
+          (_now | ((uint64_t (1) << (slot_bits * level)) - 1)) + 1;
+        if (boundary < next)
+            next = boundary;
+    }
+    if (next > now_ + 1)
+        next = now_ + 1;
+    _now = next;
+    cascade ();
+}
+
+void zmq::timer_wheel_t::cascade ()
+{
+    for (int level = 1; level != levels; level++) {
+        if (_now & ((uint64_t (1) << (slot_bits * level)) - 1))
+            break;
+        const uint32_t slot =
+          level * slots
+          + static_cast<uint32_t> ((_now >> (slot_bits * level)) & slot_mask);
+        while (_heads[slot] != nil) {
+            const uint32_t index = _heads[slot];
+            unlink (index);
+            place (index);
+        }
+        if (level == levels - 1)
+            reach_far ();
+    }
+}
+
+void zmq::timer_wheel_t::reach_far ()
+{
+    //  Detach the list first, as timers still out of reach go back to it.
+    uint32_t index = _heads[far_slot];
+    if (index == nil)
+        return;
+    _heads[far_slot] = nil;
+    _nodes[_nodes[index].prev].next = nil;
+    while (index != nil) {
+        const uint32_t next = _nodes[index].next;
+        place (index);
+        index = next;
+    }
+}
+
+int zmq::timer_wheel_t::find_slot (int level_, unsigned start_) const
+{
+    const uint64_t *const words = _occupied[level_];
+    const unsigned first = start_ / 64;
+    const unsigned shift = start_ % 64;
+
+    //  The first word from start_ on, the other words, and finally the
+    //  first word before start_.
+    uint64_t bits = words[first] & (~uint64_t (0) << shift);
+    if (bits)
+        return static_cast<int> (first * 64 + lowest_bit (bits));
+    for (unsigned i = 1; i != slots / 64; i++) {
+        const unsigned word = (first + i) % (slots / 64);
+        if (words[word])
+            return static_cast<int> (word * 64 + lowest_bit (words[word]));
+    }
+    bits = words[first] & ((uint64_t (1) << shift) - 1);
+    if (bits)
+        return static_cast<int> (first * 64 + lowest_bit (bits));
+    return -1;
+}
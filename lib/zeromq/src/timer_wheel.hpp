@@ -0,0 +1,167 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+#define __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include "macros.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Hierarchical timing wheel holding timers that expire at given times,
+//  in milliseconds. A timer is identified by an owner and an id, and
+//  carries an opaque argument.
+//
+//  The wheel has four levels of 256 slots, each slot of a level spanning
+//  256 times as long as one of the level below. A timer goes to the lowest
+//  level that reaches its expiration, and the timers of a slot move down a
+//  level when the level below wraps around, so each timer moves at most
+//  three times. Timers more than 2^32 ms away wait in a separate list that
+//  is looked at again whenever the top level moves on. A hash table from
+//  owner and id to timers makes cancelling O(1) like adding.
+//
+//  Several timers with the same owner and id may be active at once;
+//  cancel removes one of them.
+class timer_wheel_t
+{
+  public:
+    timer_wheel_t ();
+
+    bool empty () const { return _count == 0; }
+    size_t size () const { return _count; }
+
+    //  Adds a timer expiring at expiration_, now_ being the current time.
+    void add (uint64_t now_,
+              uint64_t expiration_,
+              void *owner_,
+              int id_,
+              void *arg_ = NULL);
+
+    //  Removes a timer with the given owner and id, storing its argument
+    //  in arg_ if that is not NULL. Returns false if there is none.
+    bool cancel (void *owner_, int id_, void **arg_ = NULL);
+
+    //  Looks up a timer with the given owner and id. Returns false if
+    //  there is none.
+    bool find (void *owner_, int id_, uint64_t *expiration_, void **arg_);
+
+    //  Removes a timer that expired at or before now_ and returns its
+    //  owner, id and argument. Returns false once there is none left.
+    //  Timers are returned in the order of their expiration times; timers
+    //  may be added and cancelled in between.
+    bool expire (uint64_t now_, void **owner_, int *id_, void **arg_);
+
+    //  Removes any timer and returns its owner, id and argument. Returns
+    //  false if the wheel is empty.
+    bool pop (void **owner_, int *id_, void **arg_);
+
+    //  Returns a time no later than the earliest expiration, which must
+    //  not be called on an empty wheel. The result is exact for timers
+    //  due within 256 ms or overdue, and otherwise no earlier than the
+    //  start of the slot the earliest timer is in.
+    uint64_t next_expiration () const;
+
+  private:
+    enum
+    {
+        levels = 4,
+        slot_bits = 8,
+        slots = 1 << slot_bits,
+        slot_mask = slots - 1,
+
+        //  List of expired timers not yet returned by expire, in the
+        //  order of their expiration.
+        due_slot = levels * slots,
+
+        //  List of timers out of reach of the top level.
+        far_slot = due_slot + 1
+    };
+
+    static const uint32_t nil = 0xffffffff;
+
+    struct node_t
+    {
+        uint64_t expiration;
+        void *owner;
+        void *arg;
+        int id;
+
+        //  Neighbours in the circular list of the slot, or the next free
+        //  node.
+        uint32_t prev;
+        uint32_t next;
+
+        //  Next node in the same hash bucket.
+        uint32_t hash_next;
+
+        uint32_t slot;
+    };
+
+    uint32_t alloc_node ();
+    void free_node (uint32_t index_);
+
+    //  Puts the node into the slot its expiration time belongs to.
+    void place (uint32_t index_);
+
+    void link (uint32_t slot_, uint32_t index_);
+
+    //  Adds an overdue node to the due list, keeping it sorted.
+    void link_due (uint32_t index_);
+    void unlink (uint32_t index_);
+
+    //  Removes the node from the wheel and the hash table.
+    void remove (uint32_t index_);
+
+    //  Returns the node with the given owner and id, or nil.
+    uint32_t lookup (void *owner_, int id_) const;
+    uint32_t bucket (void *owner_, int id_) const;
+    void hash_insert (uint32_t index_);
+    void hash_erase (uint32_t index_);
+    void rehash ();
+
+    //  Moves the timers of the current tick to the due list and advances
+    //  the current time, as far as possible without passing now_ or a
+    //  tick with timers.
+    void step (uint64_t now_);
+
+    //  Moves timers down a level after the current time wrapped around
+    //  lower levels.
+    void cascade ();
+
+    //  Places the timers of the far list anew.
+    void reach_far ();
+
+    //  Returns the first occupied slot of a level, in circular order from
+    //  start_, or -1.
+    int find_slot (int level_, unsigned start_) const;
+
+    std::vector<node_t> _nodes;
+    uint32_t _free;
+
+    //  First tick whose timers have not been moved to the due list.
+    uint64_t _now;
+
+    //  Heads of the slot lists, and of the due and far lists.
+    uint32_t _heads[far_slot + 1];
+
+    //  Earliest expiration in each slot above level 0, and in the far
+    //  list. Only lowered while the list is not empty, so it may be
+    //  earlier than the actual one.
+    uint64_t _slot_min[far_slot + 1];
+
+    //  Occupied slots of each level, and number of timers on it.
+    uint64_t _occupied[levels][slots / 64];
+    size_t _level_count[levels];
+
+    size_t _count;
+
+    std::vector<uint32_t> _buckets;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (timer_wheel_t)
+};
+}
+
+#endif
@@ -4,7 +4,8 @@
 #include "timers.hpp"
 #include "err.hpp"
 
-#include <algorithm>
+#include <limits.h>
+#include <new>
 
 zmq::timers_t::timers_t () : _tag (0xCAFEDADA), _next_timer_id (0)
 {
@@ -12,6 +13,12 @@ zmq::timers_t::timers_t () : _tag (0xCAFEDADA), _next_timer_id (0)
 
 zmq::timers_t::~timers_t ()
 {
+    void *owner;
+    int timer_id;
+    void *timer;
+    while (_timers.pop (&owner, &timer_id, &timer))
+        delete static_cast<timer_t *> (timer);
+
     //  Mark the timers as dead
     _tag = 0xdeadbeef;
 }
@@ -21,6 +28,15 @@ bool zmq::timers_t::check_tag () const
     return _tag == 0xCAFEDADA;
 }
 
+void zmq::timers_t::schedule (uint64_t now_, int timer_id_, timer_t *timer_)
+{
+    //  Intervals too long to represent never expire in practice.
+    const uint64_t max = ~uint64_t (0);
+    const uint64_t when =
+      timer_->interval > max - now_ ? max : now_ + timer_->interval;
+    _timers.add (now_, when, NULL, timer_id_, timer_);
+}
+
 int zmq::timers_t::add (size_t interval_, timers_timer_fn handler_, void *arg_)
 {
     if (handler_ == NULL) {
@@ -28,130 +44,94 @@ int zmq::timers_t::add (size_t interval_, timers_timer_fn handler_, void *arg_)
         return -1;
     }
 
-    uint64_t when = _clock.now_ms () + interval_;
-    timer_t timer = {++_next_timer_id, interval_, handler_, arg_};
-    _timers.insert (timersmap_t::value_type (when, timer));
+    timer_t *timer = new (std::nothrow) timer_t;
+    alloc_assert (timer);
+    timer->interval = interval_;
+    timer->handler = handler_;
+    timer->arg = arg_;
 
-    return timer.timer_id;
+    const int timer_id = ++_next_timer_id;
+    schedule (_clock.now_ms (), timer_id, timer);
+    return timer_id;
 }
 
-struct zmq::timers_t::match_by_id
-{
-    match_by_id (int timer_id_) : _timer_id (timer_id_) {}
-
-    bool operator() (timersmap_t::value_type const &entry_) const
-    {
-        return entry_.second.timer_id == _timer_id;
-    }
-
-  private:
-    int _timer_id;
-};
-
 int zmq::timers_t::cancel (int timer_id_)
 {
-    // check first if timer exists at all
-    if (_timers.end ()
-        == std::find_if (_timers.begin (), _timers.end (),
-                         match_by_id (timer_id_))) {
+    void *timer;
+    if (!_timers.cancel (NULL, timer_id_, &timer)) {
         errno = EINVAL;
         return -1;
     }
 
-    // check if timer was already canceled
-    if (_cancelled_timers.count (timer_id_)) {
-        errno = EINVAL;
-        return -1;
-    }
-
-    _cancelled_timers.insert (timer_id_);
-
+    delete static_cast<timer_t *> (timer);
     return 0;
 }
 
 int zmq::timers_t::set_interval (int timer_id_, size_t interval_)
 {
-    const timersmap_t::iterator end = _timers.end ();
-    const timersmap_t::iterator it =
-      std::find_if (_timers.begin (), end, match_by_id (timer_id_));
-    if (it != end) {
-        timer_t timer = it->second;
-        timer.interval = interval_;
-        uint64_t when = _clock.now_ms () + interval_;
-        _timers.erase (it);
-        _timers.insert (timersmap_t::value_type (when, timer));
-
-        return 0;
+    void *timer;
+    if (!_timers.cancel (NULL, timer_id_, &timer)) {
+        errno = EINVAL;
+        return -1;
     }
 
-    errno = EINVAL;
-    return -1;
+    static_cast<timer_t *> (timer)->interval = interval_;
+    schedule (_clock.now_ms (), timer_id_, static_cast<timer_t *> (timer));
+    return 0;
 }
 
 int zmq::timers_t::reset (int timer_id_)
 {
-    const timersmap_t::iterator end = _timers.end ();
-    const timersmap_t::iterator it =
-      std::find_if (_timers.begin (), end, match_by_id (timer_id_));
-    if (it != end) {
-        timer_t timer = it->second;
-        uint64_t when = _clock.now_ms () + timer.interval;
-        _timers.erase (it);
-        _timers.insert (timersmap_t::value_type (when, timer));
-
-        return 0;
+    void *timer;
+    if (!_timers.cancel (NULL, timer_id_, &timer)) {
+        errno = EINVAL;
+        return -1;
     }
 
-    errno = EINVAL;
-    return -1;
+    schedule (_clock.now_ms (), timer_id_, static_cast<timer_t *> (timer));
+    return 0;
 }
 
 long zmq::timers_t::timeout ()
 {
-    const uint64_t now = _clock.now_ms ();
-    long res = -1;
-
-    const timersmap_t::iterator begin = _timers.begin ();
-    const timersmap_t::iterator end = _timers.end ();
-    timersmap_t::iterator it = begin;
-    for (; it != end; ++it) {
-        if (0 == _cancelled_timers.erase (it->second.timer_id)) {
-            //  Live timer, lets return the timeout
-            res = std::max (static_cast<long> (it->first - now), 0l);
-            break;
-        }
-    }
+    if (_timers.empty ())
+        return -1;
 
-    //  Remove timed-out timers
-    _timers.erase (begin, it);
+    const uint64_t now = _clock.now_ms ();
+    const uint64_t next = _timers.next_expiration ();
+    if (next <= now)
+        return 0;
 
-    return res;
+    //  Timers that never expire in practice wait as long as a long can say.
+    const uint64_t wait = next - now;
+    return wait > static_cast<uint64_t> (LONG_MAX) ? LONG_MAX
+                                                    : static_cast<long> (wait);
 }
 
 int zmq::timers_t::execute ()
 {
     const uint64_t now = _clock.now_ms ();
 
-    const timersmap_t::iterator begin = _timers.begin ();
-    const timersmap_t::iterator end = _timers.end ();
-    timersmap_t::iterator it = _timers.begin ();
-    for (; it != end; ++it) {
-        if (0 == _cancelled_timers.erase (it->second.timer_id)) {
-            //  Timer is not cancelled
-
-            //  Map is ordered, if we have to wait for current timer we can stop.
-            if (it->first > now)
-                break;
-
-            const timer_t &timer = it->second;
-
-            timer.handler (timer.timer_id, timer.arg);
-
-            _timers.insert (
-              timersmap_t::value_type (now + timer.interval, timer));
-        }
+    //  Reschedule the due timers before running any handler, so that
+    //  handlers may cancel, reset or change any timer, including their own,
+    //  and a timer runs at most once per call.
+    void *owner;
+    int timer_id;
+    void *timer;
+    _due.clear ();
+    while (_timers.expire (now, &owner, &timer_id, &timer))
+        _due.push_back (due_t (timer_id, static_cast<timer_t *> (timer)));
+    for (due_list_t::size_type i = 0; i != _due.size (); i++)
+        schedule (now, _due[i].first, _due[i].second);
+
+    for (due_list_t::size_type i = 0; i != _due.size (); i++) {
+        //  Skip the timers cancelled by previous handlers.
+        uint64_t expiration;
+        if (!_timers.find (NULL, _due[i].first, &expiration, &timer))
+            continue;
+        const timer_t *const t = static_cast<timer_t *> (timer);
+        t->handler (_due[i].first, t->arg);
     }
-    _timers.erase (begin, it);
 
     return 0;
 }
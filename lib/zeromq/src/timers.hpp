@@ -4,10 +4,11 @@
 #define __ZMQ_TIMERS_HPP_INCLUDED__
 
 #include <stddef.h>
-#include <map>
-#include <set>
+#include <utility>
+#include <vector>
 
 #include "clock.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -25,12 +26,10 @@ class timers_t
     int add (size_t interval_, timers_timer_fn handler_, void *arg_);
 
     //  Set the interval of the timer.
-    //  This method is slow, cancelling exsting and adding a new timer yield better performance.
     //  Returns 0 on success and -1 on error.
     int set_interval (int timer_id_, size_t interval_);
 
     //  Reset the timer.
-    //  This method is slow, cancelling exsting and adding a new timer yield better performance.
     //  Returns 0 on success and -1 on error.
     int reset (int timer_id_);
 
@@ -60,19 +59,21 @@ class timers_t
 
     typedef struct timer_t
     {
-        int timer_id;
         size_t interval;
         timers_timer_fn *handler;
         void *arg;
     } timer_t;
 
-    typedef std::multimap<uint64_t, timer_t> timersmap_t;
-    timersmap_t _timers;
+    //  Schedules the timer to expire interval after now_.
+    void schedule (uint64_t now_, int timer_id_, timer_t *timer_);
 
-    typedef std::set<int> cancelled_timers_t;
-    cancelled_timers_t _cancelled_timers;
+    //  Active timers, keyed by timer id and carrying their timer_t.
+    timer_wheel_t _timers;
 
-    struct match_by_id;
+    //  Timers being executed.
+    typedef std::pair<int, timer_t *> due_t;
+    typedef std::vector<due_t> due_list_t;
+    due_list_t _due;
 
     ZMQ_NON_COPYABLE_NOR_MOVABLE (timers_t)
 };
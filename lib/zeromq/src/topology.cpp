@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "topology.hpp"
+#include "macros.hpp"
+
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace
+{
+//  Largest CPU number accepted in lists, to reject nonsense early.
+const long max_cpu = 1 << 16;
+
+bool parse_cpu (const char *&p_, int &cpu_)
+{
+    if (*p_ < '0' || *p_ > '9')
+        return false;
+    char *end;
+    const long cpu = strtol (p_, &end, 10);
+    if (cpu > max_cpu)
+        return false;
+    cpu_ = static_cast<int> (cpu);
+    p_ = end;
+    return true;
+}
+
+#if defined ZMQ_HAVE_LINUX
+//  Reads a file of /sys holding a single line.
+bool read_line (const char *path_, std::string &line_)
+{
+    FILE *file = fopen (path_, "r");
+    if (!file)
+        return false;
+    char buf[4096];
+    const bool rc = fgets (buf, sizeof buf, file) != NULL;
+    fclose (file);
+    if (!rc)
+        return false;
+    line_ = buf;
+    while (!line_.empty ()
+           && (line_[line_.size () - 1] == '\n'
+               || line_[line_.size () - 1] == ' '))
+        line_.resize (line_.size () - 1);
+    return true;
+}
+
+bool read_topology (int cpu_, const char *name_, int &value_)
+{
+    char path[128];
+    snprintf (path, sizeof path, "/sys/devices/system/cpu/cpu%d/topology/%s",
+              cpu_, name_);
+    std::string line;
+    if (!read_line (path, line) || line.empty ())
+        return false;
+    value_ = atoi (line.c_str ());
+    return true;
+}
+#endif
+}
+
+bool zmq::parse_cpu_list (const std::string &list_, std::set<int> &cpus_)
+{
+    std::set<int> cpus;
+    const char *p = list_.c_str ();
+    while (*p) {
+        int first;
+        if (!parse_cpu (p, first))
+            return false;
+        int last = first;
+        if (*p == '-') {
+            ++p;
+            if (!parse_cpu (p, last) || last < first)
+                return false;
+        }
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.insert (cpu);
+        if (*p == ',' && p[1])
+            ++p;
+        else if (*p)
+            return false;
+    }
+    cpus_.swap (cpus);
+    return true;
+}
+
+bool zmq::get_package_cores (int package_,
+                             std::vector<std::set<int> > &cores_)
+{
+    cores_.clear ();
+#if defined ZMQ_HAVE_LINUX
+    std::string line;
+    std::set<int> online;
+    if (!read_line ("/sys/devices/system/cpu/online", line)
+        || !parse_cpu_list (line, online))
+        return false;
+
+    std::map<int, std::set<int> > cores;
+    for (std::set<int>::const_iterator it = online.begin (),
+                                       end = online.end ();
+         it != end; ++it) {
+        int package;
+        int core;
+        if (read_topology (*it, "physical_package_id", package)
+            && package == package_ && read_topology (*it, "core_id", core))
+            cores[core].insert (*it);
+    }
+    for (std::map<int, std::set<int> >::const_iterator it = cores.begin (),
+                                                       end = cores.end ();
+         it != end; ++it)
+        cores_.push_back (it->second);
+#else
+    LIBZMQ_UNUSED (package_);
+#endif
+    return !cores_.empty ();
+}
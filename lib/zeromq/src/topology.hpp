@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_TOPOLOGY_HPP_INCLUDED__
+#define __ZMQ_TOPOLOGY_HPP_INCLUDED__
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace zmq
+{
+//  Parses a list of CPUs in the format the Linux kernel uses, such as
+//  "0-3,8,10-11". An empty list is valid. Returns false on syntax errors.
+bool parse_cpu_list (const std::string &list_, std::set<int> &cpus_);
+
+//  Fills cores_ with the online CPUs of each core of the given physical
+//  package (socket), ordered by core id; hardware threads of a core share
+//  an entry. Returns false if the topology is unknown or the package has
+//  no online CPUs.
+bool get_package_cores (int package_, std::vector<std::set<int> > &cores_);
+}
+
+#endif
@@ -19,6 +19,8 @@
 #include "err.hpp"
 #include "ip.hpp"
 
+#include <algorithm>
+
 //  OSX uses a different name for this socket option
 #ifndef IPV6_ADD_MEMBERSHIP
 #define IPV6_ADD_MEMBERSHIP IPV6_JOIN_GROUP
@@ -28,6 +30,13 @@
 #include <TargetConditionals.h>
 #endif
 
+#if defined ZMQ_HAVE_UDP_GSO
+//  Largest UDP payload over IPv4, which a segmented send may not exceed.
+static const size_t max_gso_size = 65507;
+//  Receive buffer size with GRO, which coalesces up to 64 KB.
+static const size_t max_gro_size = 65536;
+#endif
+
 zmq::udp_engine_t::udp_engine_t (const options_t &options_) :
     _plugged (false),
     _fd (-1),
@@ -38,6 +47,17 @@ zmq::udp_engine_t::udp_engine_t (const options_t &options_) :
     _send_enabled (false),
     _recv_enabled (false)
 {
+#if defined ZMQ_HAVE_UDP_MMSG
+    _out_pos = 0;
+    _out_count = 0;
+    _in_pos = 0;
+    _in_count = 0;
+    _in_offset = 0;
+#endif
+#if defined ZMQ_HAVE_UDP_GSO
+    _gso = false;
+    _gro = false;
+#endif
 }
 
 zmq::udp_engine_t::~udp_engine_t ()
@@ -177,6 +197,19 @@ void zmq::udp_engine_t::plug (io_thread_t *io_thread_, session_base_t *session_)
         }
     }
 
+#if defined ZMQ_HAVE_UDP_GSO
+    //  Segmentation offload is used where the kernel supports it.
+    if (rc == 0 && _send_enabled && _options.udp_gso) {
+        int segment = 0;
+        socklen_t len = sizeof segment;
+        _gso = getsockopt (_fd, SOL_UDP, UDP_SEGMENT, &segment, &len) == 0;
+    }
+    if (rc == 0 && _recv_enabled && _options.udp_gro) {
+        int on = 1;
+        _gro = setsockopt (_fd, SOL_UDP, UDP_GRO, &on, sizeof on) == 0;
+    }
+#endif
+
     if (rc != 0) {
         error (protocol_error);
     } else {
@@ -407,81 +440,219 @@ int zmq::udp_engine_t::resolve_raw_address (const char *name_, size_t length_)
     return 0;
 }
 
-void zmq::udp_engine_t::out_event ()
+int zmq::udp_engine_t::pull_datagram (char *buffer_, size_t *size_)
 {
     msg_t group_msg;
     int rc = _session->pull_msg (&group_msg);
     errno_assert (rc == 0 || (rc == -1 && errno == EAGAIN));
+    if (rc != 0)
+        return -1;
 
-    if (rc == 0) {
-        msg_t body_msg;
-        rc = _session->pull_msg (&body_msg);
-        //  If there's a group, there should also be a body
-        errno_assert (rc == 0);
+    msg_t body_msg;
+    rc = _session->pull_msg (&body_msg);
+    //  If there's a group, there should also be a body
+    errno_assert (rc == 0);
 
-        const size_t group_size = group_msg.size ();
-        const size_t body_size = body_msg.size ();
-        size_t size;
+    const size_t group_size = group_msg.size ();
+    const size_t body_size = body_msg.size ();
 
-        if (_options.raw_socket) {
-            rc = resolve_raw_address (static_cast<char *> (group_msg.data ()),
-                                      group_size);
+    if (_options.raw_socket) {
+        rc = resolve_raw_address (static_cast<char *> (group_msg.data ()),
+                                  group_size);
 
-            //  We discard the message if address is not valid
-            if (rc != 0) {
-                rc = group_msg.close ();
-                errno_assert (rc == 0);
+        //  We discard the message if address is not valid
+        if (rc != 0) {
+            rc = group_msg.close ();
+            errno_assert (rc == 0);
+
+            rc = body_msg.close ();
+            errno_assert (rc == 0);
+
+            errno = EINVAL;
+            return -1;
+        }
 
-                rc = body_msg.close ();
-                errno_assert (rc == 0);
+        *size_ = body_size;
+
+        memcpy (buffer_, body_msg.data (), body_size);
+    } else {
+        *size_ = group_size + body_size + 1;
+
+        // TODO: check if larger than maximum size
+        buffer_[0] = static_cast<unsigned char> (group_size);
+        memcpy (buffer_ + 1, group_msg.data (), group_size);
+        memcpy (buffer_ + 1 + group_size, body_msg.data (), body_size);
+    }
+
+    rc = group_msg.close ();
+    errno_assert (rc == 0);
+
+    body_msg.close ();
+    errno_assert (rc == 0);
+
+    return 0;
+}
 
-                return;
+#if defined ZMQ_HAVE_UDP_MMSG
+void zmq::udp_engine_t::out_event ()
+{
+    //  Once the batch has been sent, fill it with the messages queued.
+    if (_out_pos == _out_count) {
+        int count = 0;
+        while (count != udp_batch_size) {
+            char *const buffer = _out_buffers[count];
+            size_t size;
+            if (pull_datagram (buffer, &size) == -1) {
+                if (errno == EAGAIN)
+                    break;
+                continue;
             }
+            _out_iov[count].iov_base = buffer;
+            _out_iov[count].iov_len = size;
+            if (_options.raw_socket)
+                _out_raw_addresses[count] = _raw_address;
+            count++;
+        }
 
-            size = body_size;
+        if (count == 0) {
+            _out_pos = 0;
+            _out_count = 0;
+            reset_pollout (_handle);
+            return;
+        }
+        build_out_msgs (0, count);
+    }
 
-            memcpy (_out_buffer, body_msg.data (), body_size);
-        } else {
-            size = group_size + body_size + 1;
+    const int rc =
+      sendmmsg (_fd, _out_msgs + _out_pos, _out_count - _out_pos, 0);
+    if (rc < 0) {
+#if defined ZMQ_HAVE_UDP_GSO
+        //  The route cannot segment, e.g. the datagrams are larger than
+        //  its MTU. Send them one by one from now on.
+        if (_gso && (errno == EIO || errno == EINVAL)) {
+            _gso = false;
+            const msghdr &first = _out_msgs[_out_pos].msg_hdr;
+            const msghdr &last = _out_msgs[_out_count - 1].msg_hdr;
+            build_out_msgs (static_cast<int> (first.msg_iov - _out_iov),
+                            static_cast<int> (last.msg_iov - _out_iov
+                                              + last.msg_iovlen));
+            return;
+        }
+#endif
+        //  The datagrams left are sent when the socket is writable again.
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            assert_success_or_recoverable (_fd, rc);
+            error (connection_error);
+        }
+        return;
+    }
+    size_t nbytes = 0;
+    for (int i = 0; i != rc; i++)
+        nbytes += _out_msgs[_out_pos + i].msg_len;
+    add_bytes (nbytes);
+    _out_pos += rc;
+}
 
-            // TODO: check if larger than maximum size
-            _out_buffer[0] = static_cast<unsigned char> (group_size);
-            memcpy (_out_buffer + 1, group_msg.data (), group_size);
-            memcpy (_out_buffer + 1 + group_size, body_msg.data (), body_size);
+void zmq::udp_engine_t::build_out_msgs (int first_, int last_)
+{
+    _out_pos = 0;
+    _out_count = 0;
+    for (int i = first_; i != last_;) {
+        int count = 1;
+#if defined ZMQ_HAVE_UDP_GSO
+        //  Datagrams of the same size to the same address are sent as
+        //  one, only the last of them may be shorter.
+        const size_t size = _out_iov[i].iov_len;
+        if (_gso && size) {
+            size_t total = size;
+            while (i + count != last_) {
+                const size_t next = _out_iov[i + count].iov_len;
+                if (next > size || !next || total + next > max_gso_size
+                    || !same_out_address (i, i + count))
+                    break;
+                total += next;
+                count++;
+                if (next < size)
+                    break;
+            }
         }
+#endif
 
-        rc = group_msg.close ();
-        errno_assert (rc == 0);
+        msghdr &hdr = _out_msgs[_out_count].msg_hdr;
+        memset (&hdr, 0, sizeof hdr);
+        hdr.msg_iov = &_out_iov[i];
+        hdr.msg_iovlen = count;
+        if (_options.raw_socket) {
+            hdr.msg_name = &_out_raw_addresses[i];
+            hdr.msg_namelen = sizeof (sockaddr_in);
+        } else {
+            hdr.msg_name = const_cast<sockaddr *> (_out_address);
+            hdr.msg_namelen = _out_address_len;
+        }
+#if defined ZMQ_HAVE_UDP_GSO
+        if (count > 1) {
+            hdr.msg_control = _out_control[_out_count];
+            hdr.msg_controllen = sizeof _out_control[_out_count];
+            cmsghdr *const cmsg = CMSG_FIRSTHDR (&hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN (sizeof (uint16_t));
+            const uint16_t segment = static_cast<uint16_t> (size);
+            memcpy (CMSG_DATA (cmsg), &segment, sizeof segment);
+        }
+#endif
+        _out_count++;
+        i += count;
+    }
+}
 
-        body_msg.close ();
-        errno_assert (rc == 0);
+#if defined ZMQ_HAVE_UDP_GSO
+bool zmq::udp_engine_t::same_out_address (int first_, int second_) const
+{
+    if (!_options.raw_socket)
+        return true;
+    const sockaddr_in &first = _out_raw_addresses[first_];
+    const sockaddr_in &second = _out_raw_addresses[second_];
+    return first.sin_addr.s_addr == second.sin_addr.s_addr
+           && first.sin_port == second.sin_port;
+}
+#endif
+#else
+void zmq::udp_engine_t::out_event ()
+{
+    size_t size;
+    int rc = pull_datagram (_out_buffer, &size);
+    if (rc != 0) {
+        if (errno == EAGAIN)
+            reset_pollout (_handle);
+        return;
+    }
 
 #ifdef ZMQ_HAVE_WINDOWS
-        rc = sendto (_fd, _out_buffer, static_cast<int> (size), 0, _out_address,
-                     _out_address_len);
+    rc = sendto (_fd, _out_buffer, static_cast<int> (size), 0, _out_address,
+                 _out_address_len);
 #elif defined ZMQ_HAVE_VXWORKS
-        rc = sendto (_fd, reinterpret_cast<caddr_t> (_out_buffer), size, 0,
-                     (sockaddr *) _out_address, _out_address_len);
+    rc = sendto (_fd, reinterpret_cast<caddr_t> (_out_buffer), size, 0,
+                 (sockaddr *) _out_address, _out_address_len);
 #else
-        rc = sendto (_fd, _out_buffer, size, 0, _out_address, _out_address_len);
+    rc = sendto (_fd, _out_buffer, size, 0, _out_address, _out_address_len);
 #endif
-        if (rc < 0) {
+    if (rc < 0) {
 #ifdef ZMQ_HAVE_WINDOWS
-            if (WSAGetLastError () != WSAEWOULDBLOCK) {
-                assert_success_or_recoverable (_fd, rc);
-                error (connection_error);
-            }
+        if (WSAGetLastError () != WSAEWOULDBLOCK) {
+            assert_success_or_recoverable (_fd, rc);
+            error (connection_error);
+        }
 #else
-            if (rc != EWOULDBLOCK) {
-                assert_success_or_recoverable (_fd, rc);
-                error (connection_error);
-            }
-#endif
+        if (rc != EWOULDBLOCK) {
+            assert_success_or_recoverable (_fd, rc);
+            error (connection_error);
         }
-    } else {
-        reset_pollout (_handle);
-    }
+#endif
+    } else
+        add_bytes (size);
 }
+#endif
 
 const zmq::endpoint_uri_pair_t &zmq::udp_engine_t::get_endpoint () const
 {
@@ -501,6 +672,91 @@ void zmq::udp_engine_t::restart_output ()
     }
 }
 
+#if defined ZMQ_HAVE_UDP_MMSG
+void zmq::udp_engine_t::in_event ()
+{
+    //  Once the batch has been pushed, read the datagrams waiting.
+    if (_in_pos == _in_count) {
+        int count = udp_batch_size;
+        size_t size = MAX_UDP_MSG;
+#if defined ZMQ_HAVE_UDP_GSO
+        if (_gro) {
+            count = static_cast<int> (sizeof _in_buffers / max_gro_size);
+            size = max_gro_size;
+        }
+#endif
+        for (int i = 0; i != count; i++) {
+            _in_iov[i].iov_base = _in_buffers + i * size;
+            _in_iov[i].iov_len = size;
+
+            msghdr &hdr = _in_msgs[i].msg_hdr;
+            memset (&hdr, 0, sizeof hdr);
+            hdr.msg_name = &_in_addresses[i];
+            hdr.msg_namelen = sizeof (sockaddr_storage);
+            hdr.msg_iov = &_in_iov[i];
+            hdr.msg_iovlen = 1;
+#if defined ZMQ_HAVE_UDP_GSO
+            if (_gro) {
+                hdr.msg_control = _in_control[i];
+                hdr.msg_controllen = sizeof _in_control[i];
+            }
+#endif
+        }
+
+        const int nmsgs = recvmmsg (_fd, _in_msgs, count, 0, NULL);
+        if (nmsgs < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                assert_success_or_recoverable (_fd, nmsgs);
+                error (connection_error);
+            }
+            return;
+        }
+        size_t nbytes = 0;
+        for (int i = 0; i != nmsgs; i++)
+            nbytes += _in_msgs[i].msg_len;
+        add_bytes (nbytes);
+        _in_pos = 0;
+        _in_count = nmsgs;
+        _in_offset = 0;
+    }
+
+    //  If the pipe fills up, the datagrams left are pushed once input
+    //  is restarted.
+    while (_in_pos != _in_count) {
+        const int pos = _in_pos;
+        const msghdr &hdr = _in_msgs[pos].msg_hdr;
+        const size_t size = _in_msgs[pos].msg_len;
+
+        //  A buffer received with GRO holds datagrams of the segment size,
+        //  the last one may be shorter.
+        size_t segment = size;
+#if defined ZMQ_HAVE_UDP_GSO
+        for (const cmsghdr *cmsg = CMSG_FIRSTHDR (&hdr); cmsg;
+             cmsg = CMSG_NXTHDR (const_cast<msghdr *> (&hdr),
+                                 const_cast<cmsghdr *> (cmsg)))
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int gro_size;
+                memcpy (&gro_size, CMSG_DATA (cmsg), sizeof gro_size);
+                if (gro_size > 0)
+                    segment = static_cast<size_t> (gro_size);
+            }
+#endif
+        const size_t nbytes = std::min (segment, size - _in_offset);
+        if (!push_datagram (static_cast<char *> (hdr.msg_iov->iov_base)
+                              + _in_offset,
+                            static_cast<int> (nbytes), &_in_addresses[pos]))
+            break;
+
+        //  Move on only once the datagram is in the pipe.
+        _in_offset += nbytes;
+        if (_in_offset >= size) {
+            _in_pos++;
+            _in_offset = 0;
+        }
+    }
+    _session->flush ();
+}
+#else
 void zmq::udp_engine_t::in_event ()
 {
     sockaddr_storage in_address;
@@ -525,34 +781,45 @@ void zmq::udp_engine_t::in_event ()
 #endif
         return;
     }
+    add_bytes (nbytes);
+
+    if (push_datagram (_in_buffer, nbytes, &in_address))
+        _session->flush ();
+}
+#endif
 
+bool zmq::udp_engine_t::push_datagram (const char *buffer_,
+                                       int nbytes_,
+                                       const sockaddr_storage *address_)
+{
     int rc;
     int body_size;
     int body_offset;
     msg_t msg;
 
     if (_options.raw_socket) {
-        zmq_assert (in_address.ss_family == AF_INET);
-        sockaddr_to_msg (&msg, reinterpret_cast<sockaddr_in *> (&in_address));
+        zmq_assert (address_->ss_family == AF_INET);
+        sockaddr_to_msg (&msg,
+                         reinterpret_cast<const sockaddr_in *> (address_));
 
-        body_size = nbytes;
+        body_size = nbytes_;
         body_offset = 0;
     } else {
-        // TODO in out_event, the group size is an *unsigned* char. what is
-        // the maximum value?
-        const char *group_buffer = _in_buffer + 1;
-        const int group_size = _in_buffer[0];
+        // TODO in pull_datagram, the group size is an *unsigned* char. what
+        // is the maximum value?
+        const char *group_buffer = buffer_ + 1;
+        const int group_size = buffer_[0];
+
+        //  This doesn't fit, just ignore
+        if (nbytes_ - 1 < group_size)
+            return true;
 
         rc = msg.init_size (group_size);
         errno_assert (rc == 0);
         msg.set_flags (msg_t::more);
         memcpy (msg.data (), group_buffer, group_size);
 
-        //  This doesn't fit, just ignore
-        if (nbytes - 1 < group_size)
-            return;
-
-        body_size = nbytes - 1 - group_size;
+        body_size = nbytes_ - 1 - group_size;
         body_offset = 1 + group_size;
     }
     // Push group description to session
@@ -565,14 +832,14 @@ void zmq::udp_engine_t::in_event ()
         errno_assert (rc == 0);
 
         reset_pollin (_handle);
-        return;
+        return false;
     }
 
     rc = msg.close ();
     errno_assert (rc == 0);
     rc = msg.init_size (body_size);
     errno_assert (rc == 0);
-    memcpy (msg.data (), _in_buffer + body_offset, body_size);
+    memcpy (msg.data (), buffer_ + body_offset, body_size);
 
     // Push message body to session
     rc = _session->push_msg (&msg);
@@ -583,12 +850,12 @@ void zmq::udp_engine_t::in_event ()
 
         _session->reset ();
         reset_pollin (_handle);
-        return;
+        return false;
     }
 
     rc = msg.close ();
     errno_assert (rc == 0);
-    _session->flush ();
+    return true;
 }
 
 bool zmq::udp_engine_t::restart_input ()
@@ -6,6 +6,22 @@
 #include "i_engine.hpp"
 #include "address.hpp"
 #include "msg.hpp"
+#include "config.hpp"
+#include "stdint.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+#include <sys/socket.h>
+//  recvmmsg and sendmmsg move several datagrams per system call.
+#if defined MSG_WAITFORONE
+#define ZMQ_HAVE_UDP_MMSG
+#include <netinet/udp.h>
+//  UDP_SEGMENT sends datagrams of the same size as one buffer that is
+//  split up on the way, UDP_GRO receives them as one buffer again.
+#if defined UDP_SEGMENT && defined UDP_GRO
+#define ZMQ_HAVE_UDP_GSO
+#endif
+#endif
+#endif
 
 #define MAX_UDP_MSG 8192
 
@@ -49,6 +65,27 @@ class udp_engine_t ZMQ_FINAL : public io_object_t, public i_engine
 
   private:
     int resolve_raw_address (const char *name_, size_t length_);
+
+    //  Pulls the next group and body from the session into the buffer.
+    //  Returns -1 with errno set to EAGAIN if there is no message, or to
+    //  EINVAL if the message was dropped for its raw address.
+    int pull_datagram (char *buffer_, size_t *size_);
+
+    //  Pushes the group and body held in a datagram to the session.
+    //  Returns false if the pipe is full.
+    bool push_datagram (const char *buffer_,
+                        int nbytes_,
+                        const sockaddr_storage *address_);
+
+#if defined ZMQ_HAVE_UDP_MMSG
+    //  Builds the messages for sendmmsg from the datagrams formatted
+    //  between first_ and last_, coalescing them where GSO is enabled.
+    void build_out_msgs (int first_, int last_);
+#endif
+#if defined ZMQ_HAVE_UDP_GSO
+    //  Whether datagrams first_ and second_ go to the same address.
+    bool same_out_address (int first_, int second_) const;
+#endif
     static void sockaddr_to_msg (zmq::msg_t *msg_, const sockaddr_in *addr_);
 
     static int set_udp_reuse_address (fd_t s_, bool on_);
@@ -82,8 +119,37 @@ class udp_engine_t ZMQ_FINAL : public io_object_t, public i_engine
     const struct sockaddr *_out_address;
     zmq_socklen_t _out_address_len;
 
+#if defined ZMQ_HAVE_UDP_MMSG
+    //  Datagrams formatted for sendmmsg, one entry of _out_iov each. The
+    //  messages before _out_pos are sent.
+    char _out_buffers[udp_batch_size][MAX_UDP_MSG];
+    sockaddr_in _out_raw_addresses[udp_batch_size];
+    iovec _out_iov[udp_batch_size];
+    mmsghdr _out_msgs[udp_batch_size];
+    int _out_pos;
+    int _out_count;
+
+    //  Buffers filled by recvmmsg, those before _in_pos are pushed and
+    //  _in_offset bytes of the one at _in_pos. With GRO there are fewer,
+    //  larger buffers in the same space.
+    char _in_buffers[udp_batch_size * MAX_UDP_MSG];
+    sockaddr_storage _in_addresses[udp_batch_size];
+    iovec _in_iov[udp_batch_size];
+    mmsghdr _in_msgs[udp_batch_size];
+    int _in_pos;
+    int _in_count;
+    size_t _in_offset;
+#else
     char _out_buffer[MAX_UDP_MSG];
     char _in_buffer[MAX_UDP_MSG];
+#endif
+#if defined ZMQ_HAVE_UDP_GSO
+    //  Control messages carrying the segment sizes.
+    char _out_control[udp_batch_size][CMSG_SPACE (sizeof (uint16_t))];
+    char _in_control[udp_batch_size][CMSG_SPACE (sizeof (int))];
+    bool _gso;
+    bool _gro;
+#endif
     bool _send_enabled;
     bool _recv_enabled;
 };
@@ -87,11 +87,14 @@ int zmq::v2_decoder_t::size_ready (uint64_t msg_size_,
     // data into a new message and complete it in the next receive.
 
     shared_message_memory_allocator &allocator = get_allocator ();
+    allocator.add_message_size (static_cast<size_t> (msg_size_));
     if (unlikely (!_zero_copy
                   || msg_size_ > static_cast<size_t> (
-                       allocator.data () + allocator.size () - read_pos_))) {
+                       allocator.data () + allocator.size () - read_pos_)
+                  || !allocator.zero_copy (static_cast<size_t> (msg_size_)))) {
         // a new message has started, but the size would exceed the pre-allocated arena
         // this happens every time when a message does not fit completely into the buffer
+        // small messages are copied as well, so that they do not pin the buffer
         rc = _in_progress.init_size (static_cast<size_t> (msg_size_));
     } else {
         // construct message using n bytes from the buffer as storage
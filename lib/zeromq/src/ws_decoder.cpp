@@ -10,6 +10,7 @@
 #include "likely.hpp"
 #include "wire.hpp"
 #include "err.hpp"
+#include "simd.hpp"
 
 zmq::ws_decoder_t::ws_decoder_t (size_t bufsize_,
                                  int64_t maxmsgsize_,
@@ -185,14 +186,17 @@ int zmq::ws_decoder_t::size_ready (unsigned char const *read_pos_)
     // data into a new message and complete it in the next receive.
 
     shared_message_memory_allocator &allocator = get_allocator ();
+    allocator.add_message_size (static_cast<size_t> (_size));
     if (unlikely (!_zero_copy || allocator.data () > read_pos_
                   || static_cast<size_t> (read_pos_ - allocator.data ())
                        > allocator.size ()
                   || _size > static_cast<size_t> (
-                       allocator.data () + allocator.size () - read_pos_))) {
+                       allocator.data () + allocator.size () - read_pos_)
+                  || !allocator.zero_copy (static_cast<size_t> (_size)))) {
         // a new message has started, but the size would exceed the pre-allocated arena
         // (or read_pos_ is in the initial handshake buffer)
         // this happens every time when a message does not fit completely into the buffer
+        // small messages are copied as well, so that they do not pin the buffer
         rc = _in_progress.init_size (static_cast<size_t> (_size));
     } else {
         // construct message using n bytes from the buffer as storage
@@ -234,12 +238,12 @@ int zmq::ws_decoder_t::size_ready (unsigned char const *read_pos_)
 int zmq::ws_decoder_t::message_ready (unsigned char const *)
 {
     if (_must_mask) {
-        int mask_index = _opcode == ws_protocol_t::opcode_binary ? 1 : 0;
+        const size_t mask_index =
+          _opcode == ws_protocol_t::opcode_binary ? 1 : 0;
 
         unsigned char *data =
           static_cast<unsigned char *> (_in_progress.data ());
-        for (size_t i = 0; i < _size; ++i, mask_index++)
-            data[i] = data[i] ^ _mask[mask_index % 4];
+        mask (data, data, _size, _mask, mask_index);
     }
 
     //  Message is completely read. Signal this to the caller
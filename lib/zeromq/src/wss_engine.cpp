@@ -197,3 +197,20 @@ int zmq::wss_engine_t::write (const void *data_, size_t size_)
     // TODO: change return type to ssize_t (signed)
     return rc;
 }
+
+#if defined ZMQ_HAVE_WRITEV
+int zmq::wss_engine_t::writev (const iovec *iov_, int iovcnt_)
+{
+    //  TLS records are written one buffer at a time.
+    LIBZMQ_UNUSED (iovcnt_);
+    return write (iov_->iov_base, iov_->iov_len);
+}
+#endif
+
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+bool zmq::wss_engine_t::enable_zerocopy ()
+{
+    //  Data is encrypted before it reaches the socket.
+    return false;
+}
+#endif
@@ -29,6 +29,12 @@ class wss_engine_t : public ws_engine_t
     void plug_internal ();
     int read (void *data, size_t size_);
     int write (const void *data_, size_t size_);
+#if defined ZMQ_HAVE_WRITEV
+    int writev (const iovec *iov_, int iovcnt_);
+#endif
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    bool enable_zerocopy ();
+#endif
 
   private:
     bool do_handshake ();
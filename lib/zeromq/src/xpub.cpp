@@ -4,14 +4,18 @@
 #include <string.h>
 
 #include "xpub.hpp"
+#include "ctx.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
 #include "macros.hpp"
 #include "generic_mtrie_impl.hpp"
+#include "generic_radix_mtrie_impl.hpp"
 
 zmq::xpub_t::xpub_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_),
+    _radix (false),
+    _fanout_threads (0),
     _verbose_subs (false),
     _verbose_unsubs (false),
     _more_send (false),
@@ -51,7 +55,7 @@ void zmq::xpub_t::xattach_pipe (pipe_t *pipe_,
     //  If subscribe_to_all_ is specified, the caller would like to subscribe
     //  to all data on this pipe, implicitly.
     if (subscribe_to_all_)
-        _subscriptions.add (NULL, 0, pipe_);
+        add_subscription (NULL, 0, pipe_);
 
     // if welcome message exists, send a copy of it
     if (_welcome_msg.size () > 0) {
@@ -115,14 +119,13 @@ void zmq::xpub_t::xread_activated (pipe_t *pipe_)
                 _pending_pipes.push_back (pipe_);
             } else {
                 if (!subscribe) {
-                    const mtrie_t::rm_result rm_result =
-                      _subscriptions.rm (data, size, pipe_);
-                    //  TODO reconsider what to do if rm_result == mtrie_t::not_found
-                    notify =
-                      rm_result != mtrie_t::values_remain || _verbose_unsubs;
+                    //  TODO reconsider what to do if the subscription is not found
+                    const bool last_removed =
+                      rm_subscription (data, size, pipe_);
+                    notify = last_removed || _verbose_unsubs;
                 } else {
                     const bool first_added =
-                      _subscriptions.add (data, size, pipe_);
+                      add_subscription (data, size, pipe_);
                     notify = first_added || _verbose_subs;
                 }
             }
@@ -201,14 +204,42 @@ int zmq::xpub_t::xsetsockopt (int option_,
             _manual = (*static_cast<const int *> (optval_) != 0);
         else if (option_ == ZMQ_ONLY_FIRST_SUBSCRIBE)
             _only_first_subscribe = (*static_cast<const int *> (optval_) != 0);
+    } else if (option_ == ZMQ_XPUB_MATCHER) {
+        //  The subscriptions are not moved between the tries, so the
+        //  matcher can only be changed while there are none.
+        if (optvallen_ != sizeof (int)
+            || (*static_cast<const int *> (optval_) != ZMQ_XPUB_MATCHER_MTRIE
+                && *static_cast<const int *> (optval_)
+                     != ZMQ_XPUB_MATCHER_RADIX)
+            || _subscriptions.num_prefixes () != 0
+            || _radix_subscriptions.num_prefixes () != 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        _radix =
+          *static_cast<const int *> (optval_) == ZMQ_XPUB_MATCHER_RADIX;
+    } else if (option_ == ZMQ_XPUB_FANOUT_THREADS) {
+        if (optvallen_ != sizeof (int)
+            || *static_cast<const int *> (optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+#if defined ZMQ_USE_CV_IMPL_NONE
+        //  The helpers wait on condition variables.
+        errno = ENOTSUP;
+        return -1;
+#else
+        _fanout_threads = *static_cast<const int *> (optval_);
+        _dist.set_fanout (get_ctx (), _fanout_threads);
+#endif
     } else if (option_ == ZMQ_SUBSCRIBE && _manual) {
         if (_last_pipe != NULL)
-            _subscriptions.add ((unsigned char *) optval_, optvallen_,
-                                _last_pipe);
+            add_subscription (static_cast<const unsigned char *> (optval_),
+                              optvallen_, _last_pipe);
     } else if (option_ == ZMQ_UNSUBSCRIBE && _manual) {
         if (_last_pipe != NULL)
-            _subscriptions.rm ((unsigned char *) optval_, optvallen_,
-                               _last_pipe);
+            rm_subscription (static_cast<const unsigned char *> (optval_),
+                             optvallen_, _last_pipe);
     } else if (option_ == ZMQ_XPUB_WELCOME_MSG) {
         _welcome_msg.close ();
 
@@ -233,8 +264,18 @@ int zmq::xpub_t::xgetsockopt (int option_, void *optval_, size_t *optvallen_)
     if (option_ == ZMQ_TOPICS_COUNT) {
         // make sure to use a multi-thread safe function to avoid race conditions with I/O threads
         // where subscriptions are processed:
+        return do_getsockopt<int> (
+          optval_, optvallen_,
+          (int) (_radix ? _radix_subscriptions.num_prefixes ()
+                        : _subscriptions.num_prefixes ()));
+    }
+    if (option_ == ZMQ_XPUB_MATCHER) {
         return do_getsockopt<int> (optval_, optvallen_,
-                                   (int) _subscriptions.num_prefixes ());
+                                   _radix ? ZMQ_XPUB_MATCHER_RADIX
+                                          : ZMQ_XPUB_MATCHER_MTRIE);
+    }
+    if (option_ == ZMQ_XPUB_FANOUT_THREADS) {
+        return do_getsockopt<int> (optval_, optvallen_, _fanout_threads);
     }
 
     // room for future options here
@@ -259,7 +300,11 @@ void zmq::xpub_t::xpipe_terminated (pipe_t *pipe_)
         //  Remove pipe without actually sending the message as it was taken
         //  care of by the manual call above. subscriptions is the real mtrie,
         //  so the pipe must be removed from there or it will be left over.
-        _subscriptions.rm (pipe_, stub, static_cast<void *> (NULL), false);
+        if (_radix)
+            _radix_subscriptions.rm (pipe_, stub, static_cast<void *> (NULL),
+                                     false);
+        else
+            _subscriptions.rm (pipe_, stub, static_cast<void *> (NULL), false);
 
         // In case the pipe is currently set as last we must clear it to prevent
         // subscriptions from being re-added.
@@ -270,12 +315,50 @@ void zmq::xpub_t::xpipe_terminated (pipe_t *pipe_)
         //  Remove the pipe from the trie. If there are topics that nobody
         //  is interested in anymore, send corresponding unsubscriptions
         //  upstream.
-        _subscriptions.rm (pipe_, send_unsubscription, this, !_verbose_unsubs);
+        if (_radix)
+            _radix_subscriptions.rm (pipe_, send_unsubscription, this,
+                                     !_verbose_unsubs);
+        else
+            _subscriptions.rm (pipe_, send_unsubscription, this,
+                               !_verbose_unsubs);
     }
 
     _dist.pipe_terminated (pipe_);
 }
 
+bool zmq::xpub_t::add_subscription (const unsigned char *data_,
+                                    size_t size_,
+                                    pipe_t *pipe_)
+{
+    if (_radix)
+        return _radix_subscriptions.add (data_, size_, pipe_);
+    return _subscriptions.add (data_, size_, pipe_);
+}
+
+bool zmq::xpub_t::rm_subscription (const unsigned char *data_,
+                                   size_t size_,
+                                   pipe_t *pipe_)
+{
+    if (_radix)
+        return _radix_subscriptions.rm (data_, size_, pipe_)
+               != radix_mtrie_t::values_remain;
+    return _subscriptions.rm (data_, size_, pipe_) != mtrie_t::values_remain;
+}
+
+template <typename Arg>
+void zmq::xpub_t::match_subscriptions (msg_t *msg_,
+                                       void (*func_) (pipe_t *pipe_,
+                                                      Arg arg_),
+                                       Arg arg_)
+{
+    const unsigned char *const data =
+      static_cast<const unsigned char *> (msg_->data ());
+    if (_radix)
+        _radix_subscriptions.match (data, msg_->size (), func_, arg_);
+    else
+        _subscriptions.match (data, msg_->size (), func_, arg_);
+}
+
 void zmq::xpub_t::mark_as_matching (pipe_t *pipe_, xpub_t *self_)
 {
     self_->_dist.match (pipe_);
@@ -297,13 +380,10 @@ int zmq::xpub_t::xsend (msg_t *msg_)
         _dist.unmatch ();
 
         if (unlikely (_manual && _last_pipe && _send_last_pipe)) {
-            _subscriptions.match (static_cast<unsigned char *> (msg_->data ()),
-                                  msg_->size (), mark_last_pipe_as_matching,
-                                  this);
+            match_subscriptions (msg_, mark_last_pipe_as_matching, this);
             _last_pipe = NULL;
         } else
-            _subscriptions.match (static_cast<unsigned char *> (msg_->data ()),
-                                  msg_->size (), mark_as_matching, this);
+            match_subscriptions (msg_, mark_as_matching, this);
         // If inverted matching is used, reverse the selection now
         if (options.invert_matching) {
             _dist.reverse_match ();
@@ -8,6 +8,7 @@
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "mtrie.hpp"
+#include "radix_mtrie.hpp"
 #include "dist.hpp"
 
 namespace zmq
@@ -48,15 +49,38 @@ class xpub_t : public socket_base_t
     //  Function to be applied to each matching pipes.
     static void mark_as_matching (zmq::pipe_t *pipe_, xpub_t *self_);
 
+    //  Add and remove subscriptions in the trie selected with
+    //  ZMQ_XPUB_MATCHER. rm_subscription returns true unless other pipes
+    //  remain subscribed to the prefix.
+    bool add_subscription (const unsigned char *data_,
+                           size_t size_,
+                           pipe_t *pipe_);
+    bool rm_subscription (const unsigned char *data_,
+                          size_t size_,
+                          pipe_t *pipe_);
+    template <typename Arg>
+    void match_subscriptions (msg_t *msg_,
+                              void (*func_) (pipe_t *pipe_, Arg arg_),
+                              Arg arg_);
+
     //  List of all subscriptions mapped to corresponding pipes.
     mtrie_t _subscriptions;
 
+    //  The same with ZMQ_XPUB_MATCHER_RADIX, which suits large numbers of
+    //  topics and subscribers better.
+    radix_mtrie_t _radix_subscriptions;
+    bool _radix;
+
     //  List of manual subscriptions mapped to corresponding pipes.
     mtrie_t _manual_subscriptions;
 
     //  Distributor of messages holding the list of outbound pipes.
     dist_t _dist;
 
+    //  Number of helper threads writing messages to many subscribers,
+    //  as set with ZMQ_XPUB_FANOUT_THREADS.
+    int _fanout_threads;
+
     // If true, send all subscription messages upstream, not just
     // unique ones
     bool _verbose_subs;
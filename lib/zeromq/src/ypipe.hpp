@@ -19,8 +19,9 @@ namespace zmq
 template <typename T, int N> class ypipe_t ZMQ_FINAL : public ypipe_base_t<T>
 {
   public:
-    //  Initialises the pipe.
-    ypipe_t ()
+    //  Initialises the pipe, taking its chunks from the pool if one is
+    //  given.
+    explicit ypipe_t (chunk_pool_t *pool_ = NULL) : _queue (pool_)
     {
         //  Insert terminator element into the queue.
         _queue.push ();
@@ -8,6 +8,7 @@
 
 #include "err.hpp"
 #include "atomic_ptr.hpp"
+#include "chunk_pool.hpp"
 #include "platform.hpp"
 
 namespace zmq
@@ -24,6 +25,9 @@ namespace zmq
 //  T is the type of the object in the queue.
 //  N is granularity of the queue (how many pushes have to be done till
 //  actual memory allocation is required).
+//
+//  Chunks are taken from and returned to the pool if one is given. The
+//  pool must outlive the queue.
 #if defined HAVE_POSIX_MEMALIGN
 // ALIGN is the memory alignment size to use in the case where we have
 // posix_memalign available. Default value is 64, this alignment will
@@ -38,8 +42,9 @@ template <typename T, int N> class yqueue_t
 {
   public:
     //  Create the queue.
-    inline yqueue_t ()
+    inline explicit yqueue_t (chunk_pool_t *pool_ = NULL) : _pool (pool_)
     {
+        zmq_assert (!_pool || _pool->chunk_size () >= sizeof (chunk_t));
         _begin_chunk = allocate_chunk ();
         alloc_assert (_begin_chunk);
         _begin_pos = 0;
@@ -54,18 +59,21 @@ template <typename T, int N> class yqueue_t
     {
         while (true) {
             if (_begin_chunk == _end_chunk) {
-                free (_begin_chunk);
+                free_chunk (_begin_chunk);
                 break;
             }
             chunk_t *o = _begin_chunk;
             _begin_chunk = _begin_chunk->next;
-            free (o);
+            free_chunk (o);
         }
 
         chunk_t *sc = _spare_chunk.xchg (NULL);
-        free (sc);
+        free_chunk (sc);
     }
 
+    //  Size of the chunks the queue allocates.
+    static size_t chunk_size () { return sizeof (chunk_t); }
+
     //  Returns reference to the front element of the queue.
     //  If the queue is empty, behaviour is undefined.
     inline T &front () { return _begin_chunk->values[_begin_pos]; }
@@ -122,7 +130,7 @@ template <typename T, int N> class yqueue_t
         else {
             _end_pos = N - 1;
             _end_chunk = _end_chunk->prev;
-            free (_end_chunk->next);
+            free_chunk (_end_chunk->next);
             _end_chunk->next = NULL;
         }
     }
@@ -140,7 +148,7 @@ template <typename T, int N> class yqueue_t
             //  so for cache reasons we'll get rid of the spare and
             //  use 'o' as the spare.
             chunk_t *cs = _spare_chunk.xchg (o);
-            free (cs);
+            free_chunk (cs);
         }
     }
 
@@ -153,8 +161,10 @@ template <typename T, int N> class yqueue_t
         chunk_t *next;
     };
 
-    static inline chunk_t *allocate_chunk ()
+    inline chunk_t *allocate_chunk ()
     {
+        if (_pool)
+            return static_cast<chunk_t *> (_pool->allocate ());
 #if defined HAVE_POSIX_MEMALIGN
         void *pv;
         if (posix_memalign (&pv, ALIGN, sizeof (chunk_t)) == 0)
@@ -165,6 +175,14 @@ template <typename T, int N> class yqueue_t
 #endif
     }
 
+    inline void free_chunk (chunk_t *chunk_)
+    {
+        if (_pool && chunk_)
+            _pool->deallocate (chunk_);
+        else
+            free (chunk_);
+    }
+
     //  Back position may point to invalid memory if the queue is empty,
     //  while begin & end positions are always valid. Begin position is
     //  accessed exclusively be queue reader (front/pop), while back and
@@ -181,6 +199,9 @@ template <typename T, int N> class yqueue_t
     //  us from having to call malloc/free.
     atomic_ptr_t<chunk_t> _spare_chunk;
 
+    //  Pool the chunks come from, if any.
+    chunk_pool_t *const _pool;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (yqueue_t)
 };
 }
@@ -0,0 +1,236 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static int get_int_option (void *socket_, int option_)
+{
+    int value = -1;
+    size_t size = sizeof (value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket_, option_, &value, &size));
+    return value;
+}
+
+static void set_int_option (void *socket_, int option_, int value_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, option_, &value_, sizeof (int)));
+}
+
+static void expect_nothing (void *socket_)
+{
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                               zmq_recv (socket_, NULL, 0, ZMQ_DONTWAIT));
+}
+
+//  Creates a PUSH socket connected to a PULL socket.
+static void create_pipeline (void **push_, void **pull_)
+{
+    *pull_ = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (*pull_, "inproc://cork"));
+    *push_ = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (*push_, "inproc://cork"));
+}
+
+void test_options ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    const int options[] = {ZMQ_CORK, ZMQ_CORK_MSGS, ZMQ_CORK_BYTES,
+                           ZMQ_CORK_IVL};
+    for (size_t i = 0; i != sizeof (options) / sizeof (options[0]); i++) {
+        TEST_ASSERT_EQUAL_INT (0, get_int_option (push, options[i]));
+        set_int_option (push, options[i], 1);
+        TEST_ASSERT_EQUAL_INT (1, get_int_option (push, options[i]));
+        set_int_option (push, options[i], 0);
+
+        int value = -1;
+        TEST_ASSERT_FAILURE_ERRNO (
+          EINVAL, zmq_setsockopt (push, options[i], &value, sizeof (int)));
+    }
+
+    int value = 2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_CORK, &value, sizeof (int)));
+    test_context_socket_close (push);
+}
+
+void test_explicit ()
+{
+    void *push, *pull;
+    create_pipeline (&push, &pull);
+
+    set_int_option (push, ZMQ_CORK, 1);
+    send_string_expect_success (push, "1", 0);
+    send_string_expect_success (push, "2", ZMQ_SNDMORE);
+    send_string_expect_success (push, "3", 0);
+    expect_nothing (pull);
+
+    set_int_option (push, ZMQ_CORK, 0);
+    recv_string_expect_success (pull, "1", 0);
+    recv_string_expect_success (pull, "2", 0);
+    recv_string_expect_success (pull, "3", 0);
+
+    //  Uncorked, messages are passed on one by one again.
+    send_string_expect_success (push, "4", 0);
+    recv_string_expect_success (pull, "4", ZMQ_DONTWAIT);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_message_limit ()
+{
+    void *push, *pull;
+    create_pipeline (&push, &pull);
+
+    //  A message with several parts counts once.
+    set_int_option (push, ZMQ_CORK_MSGS, 2);
+    send_string_expect_success (push, "1", ZMQ_SNDMORE);
+    send_string_expect_success (push, "2", 0);
+    expect_nothing (pull);
+    send_string_expect_success (push, "3", 0);
+    recv_string_expect_success (pull, "1", 0);
+    recv_string_expect_success (pull, "2", 0);
+    recv_string_expect_success (pull, "3", 0);
+
+    send_string_expect_success (push, "4", 0);
+    expect_nothing (pull);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_byte_limit ()
+{
+    void *push, *pull;
+    create_pipeline (&push, &pull);
+
+    set_int_option (push, ZMQ_CORK_BYTES, 10);
+    send_string_expect_success (push, "12345", 0);
+    expect_nothing (pull);
+    send_string_expect_success (push, "67890", 0);
+    recv_string_expect_success (pull, "12345", 0);
+    recv_string_expect_success (pull, "67890", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_interval ()
+{
+    void *push, *pull;
+    create_pipeline (&push, &pull);
+
+    set_int_option (push, ZMQ_CORK_IVL, 100000);
+    send_string_expect_success (push, "1", 0);
+    expect_nothing (pull);
+
+    //  The message is passed on while the socket is not used.
+    set_int_option (pull, ZMQ_RCVTIMEO, 1000);
+    recv_string_expect_success (pull, "1", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_interval_reset ()
+{
+    void *push, *pull;
+    create_pipeline (&push, &pull);
+
+    //  Unsetting the interval stops its timer, setting it again starts a
+    //  new one.
+    set_int_option (push, ZMQ_CORK, 1);
+    set_int_option (push, ZMQ_CORK_IVL, 10000);
+    set_int_option (push, ZMQ_CORK_IVL, 0);
+    msleep (SETTLE_TIME);
+    set_int_option (push, ZMQ_CORK_IVL, 100000);
+    send_string_expect_success (push, "1", 0);
+    expect_nothing (pull);
+    set_int_option (pull, ZMQ_RCVTIMEO, 1000);
+    recv_string_expect_success (pull, "1", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_blocking_recv ()
+{
+    void *a = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (a, "inproc://cork"));
+    void *b = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (b, "inproc://cork"));
+
+    //  A request is not held back while its sender waits for the reply.
+    set_int_option (a, ZMQ_CORK, 1);
+    set_int_option (a, ZMQ_RCVTIMEO, 10);
+    send_string_expect_success (a, "request", 0);
+    expect_nothing (b);
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN, zmq_recv (a, NULL, 0, 0));
+    recv_string_expect_success (b, "request", 0);
+
+    test_context_socket_close (a);
+    test_context_socket_close (b);
+}
+
+void test_subscription ()
+{
+    void *pub = test_context_socket (ZMQ_PUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://cork"));
+    void *sub = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://cork"));
+
+    //  Subscriptions are not held back.
+    set_int_option (sub, ZMQ_CORK, 1);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    msleep (SETTLE_TIME);
+    send_string_expect_success (pub, "1", 0);
+    set_int_option (sub, ZMQ_RCVTIMEO, 1000);
+    recv_string_expect_success (sub, "1", 0);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (pub);
+}
+
+void test_hwm ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    set_int_option (pull, ZMQ_RCVHWM, 1);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://cork"));
+    void *push = test_context_socket (ZMQ_PUSH);
+    set_int_option (push, ZMQ_SNDHWM, 1);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://cork"));
+
+    //  A full pipe passes on what it held, so that the reader can make
+    //  room in it.
+    set_int_option (push, ZMQ_CORK, 1);
+    send_string_expect_success (push, "1", 0);
+    send_string_expect_success (push, "2", 0);
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                               zmq_send (push, "3", 1, ZMQ_DONTWAIT));
+    recv_string_expect_success (pull, "1", 0);
+    recv_string_expect_success (pull, "2", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_options);
+    RUN_TEST (test_explicit);
+    RUN_TEST (test_message_limit);
+    RUN_TEST (test_byte_limit);
+    RUN_TEST (test_interval);
+    RUN_TEST (test_interval_reset);
+    RUN_TEST (test_blocking_recv);
+    RUN_TEST (test_subscription);
+    RUN_TEST (test_hwm);
+    return UNITY_END ();
+}
@@ -4,6 +4,8 @@
 #include "testutil.hpp"
 #include "testutil_unity.hpp"
 
+#include <string.h>
+
 SETUP_TEARDOWN_TESTCONTEXT
 
 #define WAIT_FOR_BACKGROUND_THREAD_INSPECTION (0)
@@ -178,6 +180,192 @@ void test_ctx_zero_copy ()
 #endif
 }
 
+void test_ctx_msg_pool ()
+{
+#ifdef ZMQ_MSG_POOL
+    // Default value is 0.
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (get_test_context (), ZMQ_MSG_POOL));
+
+    // The pool is not available on every platform.
+    if (zmq_ctx_set (get_test_context (), ZMQ_MSG_POOL, 1) != 0) {
+        TEST_ASSERT_EQUAL_INT (EINVAL, errno);
+        return;
+    }
+    TEST_ASSERT_EQUAL_INT (1, zmq_ctx_get (get_test_context (), ZMQ_MSG_POOL));
+
+    void *pull = zmq_socket (get_test_context (), ZMQ_PULL);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (pull, endpoint, sizeof endpoint);
+
+    void *push = zmq_socket (get_test_context (), ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    // Sizes within the smallest, a middle and the largest class and one
+    // beyond it, each sent a few times so that blocks get reused.
+    const size_t sizes[] = {100, 1000, 5000, 130000, 200000};
+    for (size_t i = 0; i != sizeof sizes / sizeof sizes[0]; i++) {
+        for (int j = 0; j != 3; j++) {
+            zmq_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msg, sizes[i]));
+            memset (zmq_msg_data (&msg), static_cast<int> (i + j),
+                    sizes[i]);
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (sizes[i]),
+                                   zmq_msg_send (&msg, push, 0));
+
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (sizes[i]),
+                                   zmq_msg_recv (&msg, pull, 0));
+            const unsigned char *data =
+              static_cast<const unsigned char *> (zmq_msg_data (&msg));
+            TEST_ASSERT_EQUAL_UINT8 (i + j, data[0]);
+            TEST_ASSERT_EQUAL_UINT8 (i + j, data[sizes[i] - 1]);
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+        }
+    }
+
+    // Messages from the pool can be released after it is switched off.
+    zmq_msg_t kept;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&kept, 1000));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_MSG_POOL, 0));
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (get_test_context (), ZMQ_MSG_POOL));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&kept));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (push));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+#endif
+}
+
+void test_ctx_pipe_chunk_pool ()
+{
+#ifdef ZMQ_PIPE_CHUNK_POOL
+    // Default value is 0.
+    TEST_ASSERT_EQUAL_INT (
+      0, zmq_ctx_get (get_test_context (), ZMQ_PIPE_CHUNK_POOL));
+
+    // The pool is not available on every platform.
+    if (zmq_ctx_set (get_test_context (), ZMQ_PIPE_CHUNK_POOL, 4) != 0) {
+        TEST_ASSERT_EQUAL_INT (EINVAL, errno);
+        return;
+    }
+    TEST_ASSERT_EQUAL_INT (
+      4, zmq_ctx_get (get_test_context (), ZMQ_PIPE_CHUNK_POOL));
+
+    void *pull = zmq_socket (get_test_context (), ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://chunk_pool"));
+    void *push = zmq_socket (get_test_context (), ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://chunk_pool"));
+
+    // Bursts spanning several chunks make the pipe grow and shrink.
+    for (int burst = 0; burst != 3; burst++) {
+        for (int i = 0; i != 1000; i++)
+            TEST_ASSERT_EQUAL_INT (
+              sizeof i, zmq_send (push, &i, sizeof i, 0));
+        for (int i = 0; i != 1000; i++) {
+            int value;
+            TEST_ASSERT_EQUAL_INT (sizeof value,
+                                   zmq_recv (pull, &value, sizeof value, 0));
+            TEST_ASSERT_EQUAL_INT (i, value);
+        }
+    }
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (push));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+#endif
+}
+
+void test_ctx_io_thread_spin ()
+{
+#ifdef ZMQ_IO_THREAD_SPIN
+    // Default value is 0.
+    TEST_ASSERT_EQUAL_INT (
+      0, zmq_ctx_get (get_test_context (), ZMQ_IO_THREAD_SPIN));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_ctx_set (get_test_context (), ZMQ_IO_THREAD_SPIN, -1));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_IO_THREAD_SPIN, 1000));
+    TEST_ASSERT_EQUAL_INT (
+      1000, zmq_ctx_get (get_test_context (), ZMQ_IO_THREAD_SPIN));
+
+    // Requests and replies pass through spinning I/O threads, which fall
+    // back to blocking while the peers pause.
+    void *rep = zmq_socket (get_test_context (), ZMQ_REP);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (rep, endpoint, sizeof endpoint);
+    void *req = zmq_socket (get_test_context (), ZMQ_REQ);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (req, endpoint));
+
+    for (int i = 0; i != 100; i++) {
+        send_string_expect_success (req, "request", 0);
+        recv_string_expect_success (rep, "request", 0);
+        send_string_expect_success (rep, "reply", 0);
+        recv_string_expect_success (req, "reply", 0);
+        if (i % 10 == 0)
+            msleep (2);
+    }
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (req));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (rep));
+#endif
+}
+
+void test_ctx_io_thread_affinity ()
+{
+#ifdef ZMQ_IO_THREAD_AFFINITY
+    // Default is no CPUs of their own.
+    char affinity[64];
+    size_t affinity_len = sizeof affinity;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_get_ext (
+      get_test_context (), ZMQ_IO_THREAD_AFFINITY, affinity, &affinity_len));
+    TEST_ASSERT_EQUAL_STRING ("", affinity);
+
+    const char *const valid = "0-1,3;;2";
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set_ext (
+      get_test_context (), ZMQ_IO_THREAD_AFFINITY, valid, strlen (valid)));
+    affinity_len = sizeof affinity;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_get_ext (
+      get_test_context (), ZMQ_IO_THREAD_AFFINITY, affinity, &affinity_len));
+    TEST_ASSERT_EQUAL_STRING (valid, affinity);
+
+    // The string and its terminating zero must fit.
+    affinity_len = strlen (valid);
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_ctx_get_ext (get_test_context (), ZMQ_IO_THREAD_AFFINITY,
+                               affinity, &affinity_len));
+
+    const char *const invalid[] = {"a", "1-", "3-1", "1,", ",1", "1;x", "-1"};
+    for (size_t i = 0; i != sizeof invalid / sizeof *invalid; i++)
+        TEST_ASSERT_FAILURE_ERRNO (
+          EINVAL,
+          zmq_ctx_set_ext (get_test_context (), ZMQ_IO_THREAD_AFFINITY,
+                           invalid[i], strlen (invalid[i])));
+    affinity_len = sizeof affinity;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_get_ext (
+      get_test_context (), ZMQ_IO_THREAD_AFFINITY, affinity, &affinity_len));
+    TEST_ASSERT_EQUAL_STRING (valid, affinity);
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set_ext (get_test_context (), ZMQ_IO_THREAD_AFFINITY, "", 0));
+#endif
+}
+
+void test_ctx_io_thread_package ()
+{
+#ifdef ZMQ_IO_THREAD_PACKAGE
+    // Default value is -1.
+    TEST_ASSERT_EQUAL_INT (
+      -1, zmq_ctx_get (get_test_context (), ZMQ_IO_THREAD_PACKAGE));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_ctx_set (get_test_context (), ZMQ_IO_THREAD_PACKAGE, -2));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_IO_THREAD_PACKAGE, 1));
+    TEST_ASSERT_EQUAL_INT (
+      1, zmq_ctx_get (get_test_context (), ZMQ_IO_THREAD_PACKAGE));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_IO_THREAD_PACKAGE, -1));
+#endif
+}
+
 void test_ctx_option_max_sockets ()
 {
     TEST_ASSERT_EQUAL_INT (ZMQ_MAX_SOCKETS_DFLT,
@@ -277,6 +465,11 @@ int main (void)
     RUN_TEST (test_ctx_option_ipv6_set);
     RUN_TEST (test_ctx_thread_opts);
     RUN_TEST (test_ctx_zero_copy);
+    RUN_TEST (test_ctx_msg_pool);
+    RUN_TEST (test_ctx_pipe_chunk_pool);
+    RUN_TEST (test_ctx_io_thread_spin);
+    RUN_TEST (test_ctx_io_thread_affinity);
+    RUN_TEST (test_ctx_io_thread_package);
     RUN_TEST (test_ctx_option_blocky);
     RUN_TEST (test_ctx_option_invalid);
     return UNITY_END ();
@@ -0,0 +1,223 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <string.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static const int npulls = 3;
+
+static void connect_pulls (void *push_, void *pulls_[], const int weights_[])
+{
+    for (int i = 0; i < npulls; i++) {
+        char endpoint[32];
+        snprintf (endpoint, sizeof endpoint, "inproc://lb-%d", i);
+
+        pulls_[i] = test_context_socket (ZMQ_PULL);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pulls_[i], endpoint));
+
+        if (weights_)
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+              push_, ZMQ_LB_WEIGHT, &weights_[i], sizeof (int)));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push_, endpoint));
+    }
+}
+
+static int drain (void *pull_)
+{
+    int count = 0;
+    char buffer[16];
+    while (zmq_recv (pull_, buffer, sizeof buffer, ZMQ_DONTWAIT) >= 0)
+        count++;
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    return count;
+}
+
+void test_options ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+
+    int value = -1;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_LB_STRATEGY, &value, &size));
+    TEST_ASSERT_EQUAL_INT (ZMQ_LB_ROUND_ROBIN, value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_LB_WEIGHT, &value, &size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+
+    value = ZMQ_LB_POWER_OF_TWO;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_STRATEGY, &value, sizeof value));
+    value = -1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_LB_STRATEGY, &value, &size));
+    TEST_ASSERT_EQUAL_INT (ZMQ_LB_POWER_OF_TWO, value);
+
+    value = ZMQ_LB_POWER_OF_TWO + 1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_LB_STRATEGY, &value, sizeof value));
+    value = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_LB_WEIGHT, &value, sizeof value));
+
+    test_context_socket_close (push);
+}
+
+void test_weighted ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    int strategy = ZMQ_LB_WEIGHTED;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_STRATEGY, &strategy, sizeof strategy));
+
+    void *pulls[npulls];
+    const int weights[npulls] = {3, 1, 2};
+    connect_pulls (push, pulls, weights);
+
+    //  Every full cycle hands out as many messages as the weights add up to.
+    for (int i = 0; i < 60; i++)
+        send_string_expect_success (push, "x", 0);
+
+    TEST_ASSERT_EQUAL_INT (30, drain (pulls[0]));
+    TEST_ASSERT_EQUAL_INT (10, drain (pulls[1]));
+    TEST_ASSERT_EQUAL_INT (20, drain (pulls[2]));
+
+    for (int i = 0; i < npulls; i++)
+        test_context_socket_close (pulls[i]);
+    test_context_socket_close (push);
+}
+
+static void test_multipart (int strategy_)
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_STRATEGY, &strategy_, sizeof strategy_));
+
+    void *pulls[npulls];
+    connect_pulls (push, pulls, NULL);
+
+    const int count = 30;
+    for (int i = 0; i < count; i++) {
+        char id[16];
+        snprintf (id, sizeof id, "%d", i);
+        send_string_expect_success (push, id, ZMQ_SNDMORE);
+        send_string_expect_success (push, id, 0);
+    }
+
+    //  Both parts of every message arrive at the same peer, in order.
+    int received = 0;
+    for (int i = 0; i < npulls; i++) {
+        char first[16], second[16];
+        int rc;
+        while ((rc = zmq_recv (pulls[i], first, sizeof first - 1,
+                               ZMQ_DONTWAIT))
+               >= 0) {
+            first[rc] = 0;
+            int more;
+            size_t more_size = sizeof more;
+            TEST_ASSERT_SUCCESS_ERRNO (
+              zmq_getsockopt (pulls[i], ZMQ_RCVMORE, &more, &more_size));
+            TEST_ASSERT_TRUE (more);
+
+            rc = TEST_ASSERT_SUCCESS_ERRNO (
+              zmq_recv (pulls[i], second, sizeof second - 1, 0));
+            second[rc] = 0;
+            TEST_ASSERT_EQUAL_STRING (first, second);
+            received++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT (count, received);
+
+    for (int i = 0; i < npulls; i++)
+        test_context_socket_close (pulls[i]);
+    test_context_socket_close (push);
+}
+
+void test_multipart_round_robin ()
+{
+    test_multipart (ZMQ_LB_ROUND_ROBIN);
+}
+
+void test_multipart_least_loaded ()
+{
+    test_multipart (ZMQ_LB_LEAST_LOADED);
+}
+
+void test_multipart_weighted ()
+{
+    test_multipart (ZMQ_LB_WEIGHTED);
+}
+
+void test_multipart_power_of_two ()
+{
+    test_multipart (ZMQ_LB_POWER_OF_TWO);
+}
+
+void test_least_loaded_prefers_idle_peer ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    int strategy = ZMQ_LB_LEAST_LOADED;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_STRATEGY, &strategy, sizeof strategy));
+
+    //  With a high water mark of one on both sides the readers report
+    //  every message they consume, so queue depths are exact.
+    int hwm = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof hwm));
+
+    void *pulls[npulls];
+    for (int i = 0; i < npulls; i++) {
+        char endpoint[32];
+        snprintf (endpoint, sizeof endpoint, "inproc://lb-%d", i);
+        pulls[i] = test_context_socket (ZMQ_PULL);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (pulls[i], ZMQ_RCVHWM, &hwm, sizeof hwm));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pulls[i], endpoint));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+    }
+
+    //  Equal depths fall back to round-robin: one message each.
+    for (int i = 0; i < npulls; i++)
+        send_string_expect_success (push, "x", 0);
+
+    //  Every peer but the first consumes its message.
+    for (int i = 1; i < npulls; i++)
+        recv_string_expect_success (pulls[i], "x", 0);
+
+    //  Let the push socket process the read notifications.
+    int events;
+    size_t events_size = sizeof events;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_EVENTS, &events, &events_size));
+
+    //  The first peer still has room, but the idle peers are preferred.
+    for (int i = 1; i < npulls; i++)
+        send_string_expect_success (push, "y", 0);
+
+    TEST_ASSERT_EQUAL_INT (1, drain (pulls[0]));
+    for (int i = 1; i < npulls; i++)
+        TEST_ASSERT_EQUAL_INT (1, drain (pulls[i]));
+
+    for (int i = 0; i < npulls; i++)
+        test_context_socket_close (pulls[i]);
+    test_context_socket_close (push);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_options);
+    RUN_TEST (test_weighted);
+    RUN_TEST (test_multipart_round_robin);
+    RUN_TEST (test_multipart_least_loaded);
+    RUN_TEST (test_multipart_weighted);
+    RUN_TEST (test_multipart_power_of_two);
+    RUN_TEST (test_least_loaded_prefers_idle_peer);
+    return UNITY_END ();
+}
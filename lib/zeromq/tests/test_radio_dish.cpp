@@ -250,6 +250,20 @@ void test_radio_dish_udp (int ipv6_)
     msg_send_expect_success (radio, "TV", "Friends");
     msg_recv_cmp (dish, "TV", "Friends");
 
+    //  Enough datagrams to span several send and receive batches, from
+    //  two groups, arriving in the order they were sent.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_join (dish, "Radio"));
+    const int count = 100;
+    char body[16];
+    for (int i = 0; i != count; i++) {
+        snprintf (body, sizeof body, "%d", i);
+        msg_send_expect_success (radio, i % 3 ? "TV" : "Radio", body);
+    }
+    for (int i = 0; i != count; i++) {
+        snprintf (body, sizeof body, "%d", i);
+        msg_recv_cmp (dish, i % 3 ? "TV" : "Radio", body);
+    }
+
     test_context_socket_close (dish);
     test_context_socket_close (radio);
 }
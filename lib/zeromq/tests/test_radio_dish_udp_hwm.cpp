@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+// Helper macro to define the v4/v6 function pairs
+#define MAKE_TEST_V4V6(_test)                                                  \
+    static void _test##_ipv4 ()                                                \
+    {                                                                          \
+        _test (false);                                                         \
+    }                                                                          \
+                                                                               \
+    static void _test##_ipv6 ()                                                \
+    {                                                                          \
+        if (!is_ipv6_available ()) {                                           \
+            TEST_IGNORE_MESSAGE ("ipv6 is not available");                     \
+        }                                                                      \
+        _test (true);                                                          \
+    }
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static void
+msg_send_expect_success (void *s_, const char *group_, const char *body_)
+{
+    zmq_msg_t msg;
+    const size_t len = strlen (body_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msg, len));
+    memcpy (zmq_msg_data (&msg), body_, len);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_set_group (&msg, group_));
+    TEST_ASSERT_EQUAL_INT ((int) len, zmq_msg_send (&msg, s_, 0));
+}
+
+static void msg_recv_cmp (void *s_, const char *group_, const char *body_)
+{
+    zmq_msg_t msg;
+    const size_t len = strlen (body_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    const int rc = TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, s_, 0));
+    TEST_ASSERT_EQUAL_INT ((int) len, rc);
+    TEST_ASSERT_EQUAL_STRING (group_, zmq_msg_group (&msg));
+    TEST_ASSERT_EQUAL_STRING_LEN (body_, zmq_msg_data (&msg), len);
+    zmq_msg_close (&msg);
+}
+
+//  A burst larger than the receive high water mark fills the pipe while
+//  datagrams of the same receive batch are still waiting to be pushed.
+//  None of them may be lost.
+static void test_radio_dish_udp_hwm (int ipv6_)
+{
+    void *radio = test_context_socket (ZMQ_RADIO);
+    void *dish = test_context_socket (ZMQ_DISH);
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (radio, ZMQ_IPV6, &ipv6_, sizeof (int)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (dish, ZMQ_IPV6, &ipv6_, sizeof (int)));
+    const int hwm = 5;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (dish, ZMQ_RCVHWM, &hwm, sizeof hwm));
+
+    const char *radio_url = ipv6_ ? "udp://[::1]:5557" : "udp://127.0.0.1:5557";
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (dish, "udp://*:5557"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (radio, radio_url));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_join (dish, "TV"));
+
+    msleep (SETTLE_TIME);
+
+    const int count = 100;
+    char body[16];
+    for (int i = 0; i != count; i++) {
+        snprintf (body, sizeof body, "%d", i);
+        msg_send_expect_success (radio, "TV", body);
+    }
+    msleep (SETTLE_TIME);
+    for (int i = 0; i != count; i++) {
+        snprintf (body, sizeof body, "%d", i);
+        msg_recv_cmp (dish, "TV", body);
+    }
+
+    test_context_socket_close (dish);
+    test_context_socket_close (radio);
+}
+MAKE_TEST_V4V6 (test_radio_dish_udp_hwm)
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_radio_dish_udp_hwm_ipv4);
+    RUN_TEST (test_radio_dish_udp_hwm_ipv6);
+    return UNITY_END ();
+}
@@ -100,6 +100,9 @@ void test_corner_cases ()
     const int timer_id = TEST_ASSERT_SUCCESS_ERRNO (
       zmq_timers_add (timers, dummy_interval, handler, NULL));
 
+    //  a timer that never expires does not make the timeout negative
+    TEST_ASSERT_TRUE (zmq_timers_timeout (timers) > 0);
+
     //  attempt to cancel timer twice
     //  TODO should this case really be an error? canceling twice could be allowed
     TEST_ASSERT_SUCCESS_ERRNO (zmq_timers_cancel (timers, timer_id));
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static void test_option (int option_)
+{
+    void *radio = test_context_socket (ZMQ_RADIO);
+
+    int value = -1;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_getsockopt (radio, option_, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+
+    value = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (radio, option_, &value, sizeof value));
+    value = -1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_getsockopt (radio, option_, &value, &size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+
+    value = 2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (radio, option_, &value, sizeof value));
+
+    test_context_socket_close (radio);
+}
+
+void test_options ()
+{
+    test_option (ZMQ_UDP_GSO);
+    test_option (ZMQ_UDP_GRO);
+}
+
+//  Each round is sent in one burst and received before the next one, so
+//  that the receive buffer does not overflow. Bodies of the same size go
+//  to groups of the same length so that their datagrams can be coalesced.
+static const size_t round_1[] = {100, 100, 100, 100, 100, 100, 100, 100,
+                                 100, 100, 100, 100, 100, 100, 100, 100,
+                                 100, 100, 100, 100, 50};
+static const size_t round_2[] = {1000, 1000, 1000, 1000, 1000, 1000,
+                                 1000, 1000, 1000, 1000, 20,   1000};
+static const size_t round_3[] = {7000, 7000, 7000, 7000, 7000,
+                                 7000, 7000, 7000, 7000, 7000};
+static const size_t round_4[] = {0, 0, 10, 300, 300, 8000, 5, 5, 5};
+
+static const size_t *const rounds[] = {round_1, round_2, round_3, round_4};
+static const int round_sizes[] = {
+  sizeof round_1 / sizeof round_1[0], sizeof round_2 / sizeof round_2[0],
+  sizeof round_3 / sizeof round_3[0], sizeof round_4 / sizeof round_4[0]};
+
+static void fill (unsigned char *data_, size_t size_, int index_)
+{
+    for (size_t i = 0; i != size_; i++)
+        data_[i] = static_cast<unsigned char> (i * 13 + index_);
+}
+
+//  With a receive high water mark set, each round is received only after
+//  the pipe has filled up in the middle of a coalesced buffer.
+static void send_and_check (int gso_, int gro_, int hwm_ = 0)
+{
+    void *radio = test_context_socket (ZMQ_RADIO);
+    void *dish = test_context_socket (ZMQ_DISH);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (radio, ZMQ_UDP_GSO, &gso_, sizeof gso_));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (dish, ZMQ_UDP_GRO, &gro_, sizeof gro_));
+    if (hwm_)
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (dish, ZMQ_RCVHWM, &hwm_, sizeof hwm_));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (dish, "udp://*:5558"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (radio, "udp://127.0.0.1:5558"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_join (dish, "TV"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_join (dish, "FM"));
+    msleep (SETTLE_TIME);
+
+    unsigned char *data = static_cast<unsigned char *> (malloc (8192));
+    TEST_ASSERT_NOT_NULL (data);
+
+    int index = 0;
+    for (size_t r = 0; r != sizeof rounds / sizeof rounds[0]; r++) {
+        const size_t *const sizes = rounds[r];
+        for (int i = 0; i != round_sizes[r]; i++) {
+            zmq_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msg, sizes[i]));
+            fill (static_cast<unsigned char *> (zmq_msg_data (&msg)),
+                  sizes[i], index + i);
+            TEST_ASSERT_SUCCESS_ERRNO (
+              zmq_msg_set_group (&msg, i % 2 ? "FM" : "TV"));
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (sizes[i]),
+                                   zmq_msg_send (&msg, radio, 0));
+        }
+        if (hwm_)
+            msleep (SETTLE_TIME);
+        for (int i = 0; i != round_sizes[r]; i++) {
+            zmq_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (sizes[i]),
+                                   zmq_msg_recv (&msg, dish, 0));
+            TEST_ASSERT_EQUAL_STRING (i % 2 ? "FM" : "TV",
+                                      zmq_msg_group (&msg));
+            fill (data, sizes[i], index + i);
+            if (sizes[i])
+                TEST_ASSERT_EQUAL_MEMORY (data, zmq_msg_data (&msg),
+                                          sizes[i]);
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+        }
+        index += round_sizes[r];
+    }
+
+    free (data);
+    test_context_socket_close (dish);
+    test_context_socket_close (radio);
+}
+
+void test_gso_and_gro ()
+{
+    send_and_check (1, 1);
+}
+
+void test_gso_only ()
+{
+    //  Without GRO the kernel splits the datagrams before delivering them.
+    send_and_check (1, 0);
+}
+
+void test_gro_only ()
+{
+    send_and_check (0, 1);
+}
+
+void test_gro_hwm ()
+{
+    send_and_check (1, 1, 3);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_options);
+    RUN_TEST (test_gso_and_gro);
+    RUN_TEST (test_gso_only);
+    RUN_TEST (test_gro_only);
+    RUN_TEST (test_gro_hwm);
+    return UNITY_END ();
+}
@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <stdlib.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+void test_options ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+
+    int value = -1;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_WRITEV_THRESHOLD, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+
+    value = 4096;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_WRITEV_THRESHOLD, &value, sizeof value));
+    value = -1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_WRITEV_THRESHOLD, &value, &size));
+    TEST_ASSERT_EQUAL_INT (4096, value);
+
+    value = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL,
+      zmq_setsockopt (push, ZMQ_WRITEV_THRESHOLD, &value, sizeof value));
+
+    value = -1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_ZEROCOPY_THRESHOLD, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+
+    value = 65536;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_ZEROCOPY_THRESHOLD, &value, sizeof value));
+    value = -1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_ZEROCOPY_THRESHOLD, &value, &size));
+    TEST_ASSERT_EQUAL_INT (65536, value);
+
+    value = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL,
+      zmq_setsockopt (push, ZMQ_ZEROCOPY_THRESHOLD, &value, sizeof value));
+
+    test_context_socket_close (push);
+}
+
+//  Fills a message with a pattern that depends on its index.
+static void fill (unsigned char *data_, size_t size_, int index_)
+{
+    for (size_t i = 0; i != size_; i++)
+        data_[i] = static_cast<unsigned char> (i * 7 + index_);
+}
+
+static void send_and_check (bool ipc_,
+                            int option_,
+                            int threshold_,
+                            const size_t *sizes_,
+                            int count_)
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    void *push = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, option_, &threshold_, sizeof threshold_));
+
+    char endpoint[MAX_SOCKET_STRING];
+    if (ipc_)
+        bind_loopback_ipc (pull, endpoint, sizeof endpoint);
+    else
+        bind_loopback_ipv4 (pull, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    //  Every size is sent twice, the second time as the last part of a
+    //  two part message, so that small and large bodies are interleaved.
+    size_t max_size = 0;
+    for (int i = 0; i != count_; i++)
+        max_size = sizes_[i] > max_size ? sizes_[i] : max_size;
+    unsigned char *expected = static_cast<unsigned char *> (malloc (max_size));
+    TEST_ASSERT_NOT_NULL (expected);
+
+    for (int i = 0; i != count_; i++) {
+        fill (expected, sizes_[i], i);
+        send_string_expect_success (push, "head", ZMQ_SNDMORE);
+        TEST_ASSERT_EQUAL_INT (
+          static_cast<int> (sizes_[i]),
+          zmq_send (push, expected, sizes_[i], ZMQ_SNDMORE));
+        TEST_ASSERT_EQUAL_INT (static_cast<int> (sizes_[i]),
+                               zmq_send (push, expected, sizes_[i], 0));
+    }
+
+    for (int i = 0; i != count_; i++) {
+        fill (expected, sizes_[i], i);
+        recv_string_expect_success (pull, "head", 0);
+        for (int part = 0; part != 2; part++) {
+            zmq_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (sizes_[i]),
+                                   zmq_msg_recv (&msg, pull, 0));
+            if (sizes_[i])
+                TEST_ASSERT_EQUAL_MEMORY (expected, zmq_msg_data (&msg),
+                                          sizes_[i]);
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+        }
+    }
+
+    free (expected);
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+static const size_t sizes[] = {0,    1,     29,    100,    1023,  1024,
+                               5000, 65536, 10,    262144, 2048,  3,
+                               8192, 8192,  8192,  8192,   8192,  8192,
+                               8192, 8192,  8192,  8192,   8192,  8192,
+                               8192, 8192,  8192,  8192,   8192,  8192,
+                               8192, 8192,  8192,  8192,   8192,  8192,
+                               8192, 8192,  8192,  8192,   1000000};
+static const int size_count = sizeof sizes / sizeof sizes[0];
+
+void test_tcp_large_bodies_referenced ()
+{
+    send_and_check (false, ZMQ_WRITEV_THRESHOLD, 1024, sizes, size_count);
+}
+
+void test_tcp_all_bodies_referenced ()
+{
+    //  Bodies held inside the message itself are referenced as well.
+    send_and_check (false, ZMQ_WRITEV_THRESHOLD, 1, sizes, size_count);
+}
+
+void test_tcp_zerocopy ()
+{
+    //  Where MSG_ZEROCOPY is not available the bodies are written as with
+    //  ZMQ_WRITEV_THRESHOLD.
+    send_and_check (false, ZMQ_ZEROCOPY_THRESHOLD, 4096, sizes, size_count);
+    send_and_check (false, ZMQ_ZEROCOPY_THRESHOLD, 1, sizes, size_count);
+}
+
+void test_ipc ()
+{
+#if defined ZMQ_HAVE_IPC
+    send_and_check (true, ZMQ_WRITEV_THRESHOLD, 1024, sizes, size_count);
+    send_and_check (true, ZMQ_ZEROCOPY_THRESHOLD, 1024, sizes, size_count);
+#else
+    TEST_IGNORE_MESSAGE ("ipc is not available");
+#endif
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_options);
+    RUN_TEST (test_tcp_large_bodies_referenced);
+    RUN_TEST (test_tcp_all_bodies_referenced);
+    RUN_TEST (test_tcp_zerocopy);
+    RUN_TEST (test_ipc);
+    return UNITY_END ();
+}
@@ -153,6 +153,39 @@ void test_large_message ()
     test_context_socket_close (sb);
 }
 
+void test_message_sizes ()
+{
+    char connect_address[MAX_SOCKET_STRING];
+    size_t addr_length = sizeof (connect_address);
+    void *sb = test_context_socket (ZMQ_REP);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (sb, "ws://127.0.0.1:*/sizes"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, connect_address, &addr_length));
+
+    void *sc = test_context_socket (ZMQ_REQ);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sc, connect_address));
+
+    // Sizes around the widths the masking works at, so that every tail
+    // length is unmasked, in both directions.
+    unsigned char data[1100];
+    for (size_t i = 0; i < sizeof data; ++i)
+        data[i] = static_cast<unsigned char> (i * 7 + 3);
+    unsigned char buf[sizeof data];
+    for (size_t size = 0; size <= sizeof data; size += size < 80 ? 1 : 97) {
+        TEST_ASSERT_EQUAL_INT (size, zmq_send (sc, data, size, 0));
+        TEST_ASSERT_EQUAL_INT (size, zmq_recv (sb, buf, sizeof buf, 0));
+        if (size)
+            TEST_ASSERT_EQUAL_MEMORY (data, buf, size);
+        TEST_ASSERT_EQUAL_INT (size, zmq_send (sb, data, size, 0));
+        TEST_ASSERT_EQUAL_INT (size, zmq_recv (sc, buf, sizeof buf, 0));
+        if (size)
+            TEST_ASSERT_EQUAL_MEMORY (data, buf, size);
+    }
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
 void test_curve ()
 {
     char connect_address[MAX_SOCKET_STRING];
@@ -282,6 +315,7 @@ int main ()
     RUN_TEST (test_roundtrip);
     RUN_TEST (test_short_message);
     RUN_TEST (test_large_message);
+    RUN_TEST (test_message_sizes);
     RUN_TEST (test_heartbeat);
     RUN_TEST (test_mask_shared_msg);
     RUN_TEST (test_pub_sub);
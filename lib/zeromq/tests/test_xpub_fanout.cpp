@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <string.h>
+#include <vector>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+//  Enough subscribers for the helpers to take part in writing each message.
+const int subscriber_count = 1040;
+const int fanout_threads = 3;
+
+static int get_fanout_threads (void *socket_)
+{
+    int value = -1;
+    size_t size = sizeof (value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket_, ZMQ_XPUB_FANOUT_THREADS, &value, &size));
+    return value;
+}
+
+static void set_fanout_threads (void *socket_, int threads_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      socket_, ZMQ_XPUB_FANOUT_THREADS, &threads_, sizeof (int)));
+}
+
+//  Binds a verbose XPUB socket with fan-out helpers and connects
+//  subscriber_count SUB sockets to it, subscribed to everything.
+static void *create_publisher (std::vector<void *> &subs_, int hwm_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (
+      get_test_context (), ZMQ_MAX_SOCKETS, subscriber_count + 16));
+
+    void *pub = test_context_socket (ZMQ_XPUB);
+    set_fanout_threads (pub, fanout_threads);
+    const int verbose = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_XPUB_VERBOSE, &verbose, sizeof (int)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm_, sizeof (int)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://xpub_fanout"));
+
+    for (int i = 0; i != subscriber_count; i++) {
+        void *sub = zmq_socket (get_test_context (), ZMQ_SUB);
+        TEST_ASSERT_NOT_NULL (sub);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm_, sizeof (int)));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://xpub_fanout"));
+        subs_.push_back (sub);
+    }
+
+    //  Wait until the publisher knows of every subscriber.
+    for (int i = 0; i != subscriber_count; i++) {
+        char subscription[1];
+        TEST_ASSERT_EQUAL_INT (
+          1, TEST_ASSERT_SUCCESS_ERRNO (
+               zmq_recv (pub, subscription, sizeof (subscription), 0)));
+    }
+    return pub;
+}
+
+static void close_subscribers (std::vector<void *> &subs_)
+{
+    const int linger = 0;
+    for (size_t i = 0; i != subs_.size (); i++) {
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (subs_[i], ZMQ_LINGER, &linger, sizeof (int)));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_close (subs_[i]));
+    }
+}
+
+void test_option ()
+{
+    void *pub = test_context_socket (ZMQ_PUB);
+    TEST_ASSERT_EQUAL_INT (0, get_fanout_threads (pub));
+    set_fanout_threads (pub, 2);
+    TEST_ASSERT_EQUAL_INT (2, get_fanout_threads (pub));
+    set_fanout_threads (pub, 0);
+    TEST_ASSERT_EQUAL_INT (0, get_fanout_threads (pub));
+
+    int threads = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (pub, ZMQ_XPUB_FANOUT_THREADS, &threads,
+                              sizeof (int)));
+    test_context_socket_close (pub);
+}
+
+void test_distribute ()
+{
+    std::vector<void *> subs;
+    void *pub = create_publisher (subs, 1000);
+
+    //  A message small enough to be copied into each pipe, one that is
+    //  shared between them, and one with several parts.
+    char large[1024];
+    memset (large, 'x', sizeof (large));
+    send_string_expect_success (pub, "small", 0);
+    TEST_ASSERT_EQUAL_INT (
+      static_cast<int> (sizeof (large)),
+      TEST_ASSERT_SUCCESS_ERRNO (zmq_send (pub, large, sizeof (large), 0)));
+    send_string_expect_success (pub, "first", ZMQ_SNDMORE);
+    send_string_expect_success (pub, "second", 0);
+
+    char buffer[sizeof (large)];
+    for (int i = 0; i != subscriber_count; i++) {
+        recv_string_expect_success (subs[i], "small", 0);
+        TEST_ASSERT_EQUAL_INT (static_cast<int> (sizeof (large)),
+                               TEST_ASSERT_SUCCESS_ERRNO (zmq_recv (
+                                 subs[i], buffer, sizeof (buffer), 0)));
+        TEST_ASSERT_EQUAL_MEMORY (large, buffer, sizeof (large));
+        recv_string_expect_success (subs[i], "first", 0);
+        int more = 0;
+        size_t size = sizeof (more);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_getsockopt (subs[i], ZMQ_RCVMORE, &more, &size));
+        TEST_ASSERT_TRUE (more);
+        recv_string_expect_success (subs[i], "second", 0);
+        TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                                   zmq_recv (subs[i], NULL, 0, ZMQ_DONTWAIT));
+    }
+
+    close_subscribers (subs);
+    test_context_socket_close (pub);
+}
+
+void test_hwm ()
+{
+    //  Inproc pipes hold as many messages as both high-water marks
+    //  together, the rest is dropped.
+    std::vector<void *> subs;
+    void *pub = create_publisher (subs, 1);
+
+    send_string_expect_success (pub, "1", 0);
+    send_string_expect_success (pub, "2", 0);
+    send_string_expect_success (pub, "3", 0);
+    send_string_expect_success (pub, "4", 0);
+
+    for (int i = 0; i != subscriber_count; i++) {
+        recv_string_expect_success (subs[i], "1", 0);
+        recv_string_expect_success (subs[i], "2", 0);
+        TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                                   zmq_recv (subs[i], NULL, 0, ZMQ_DONTWAIT));
+    }
+
+    close_subscribers (subs);
+    test_context_socket_close (pub);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_distribute);
+    RUN_TEST (test_hwm);
+    return UNITY_END ();
+}
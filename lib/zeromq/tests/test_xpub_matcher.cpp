@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <string.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static int get_int_option (void *socket_, int option_)
+{
+    int value = -1;
+    size_t size = sizeof (value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket_, option_, &value, &size));
+    return value;
+}
+
+static void set_matcher (void *socket_, int matcher_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_XPUB_MATCHER, &matcher_, sizeof (int)));
+}
+
+static void subscribe (void *socket_, const char *topic_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_SUBSCRIBE, topic_, strlen (topic_)));
+}
+
+static void unsubscribe (void *socket_, const char *topic_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_UNSUBSCRIBE, topic_, strlen (topic_)));
+}
+
+//  Receives a (un)subscription passed on by the XPUB socket.
+static void
+recv_notification (void *socket_, bool subscribe_, const char *topic_)
+{
+    char buffer[64];
+    const int rc = TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_recv (socket_, buffer, sizeof (buffer), 0));
+    TEST_ASSERT_EQUAL_INT (1 + static_cast<int> (strlen (topic_)), rc);
+    TEST_ASSERT_EQUAL_INT (subscribe_ ? 1 : 0, buffer[0]);
+    TEST_ASSERT_EQUAL_MEMORY (topic_, buffer + 1, strlen (topic_));
+}
+
+void test_option ()
+{
+    void *pub = test_context_socket (ZMQ_XPUB);
+    TEST_ASSERT_EQUAL_INT (ZMQ_XPUB_MATCHER_MTRIE,
+                           get_int_option (pub, ZMQ_XPUB_MATCHER));
+    set_matcher (pub, ZMQ_XPUB_MATCHER_RADIX);
+    TEST_ASSERT_EQUAL_INT (ZMQ_XPUB_MATCHER_RADIX,
+                           get_int_option (pub, ZMQ_XPUB_MATCHER));
+
+    int matcher = 2;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_setsockopt (pub, ZMQ_XPUB_MATCHER,
+                                                       &matcher, sizeof (int)));
+    matcher = -1;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_setsockopt (pub, ZMQ_XPUB_MATCHER,
+                                                       &matcher, sizeof (int)));
+
+    //  The matcher cannot change once there are subscriptions.
+    void *sub = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://xpub_matcher"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://xpub_matcher"));
+    subscribe (sub, "A");
+    recv_notification (pub, true, "A");
+
+    matcher = ZMQ_XPUB_MATCHER_MTRIE;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_setsockopt (pub, ZMQ_XPUB_MATCHER,
+                                                       &matcher, sizeof (int)));
+
+    test_context_socket_close (sub);
+    test_context_socket_close (pub);
+}
+
+void test_match ()
+{
+    void *pub = test_context_socket (ZMQ_XPUB);
+    set_matcher (pub, ZMQ_XPUB_MATCHER_RADIX);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://xpub_matcher"));
+
+    void *sub1 = test_context_socket (ZMQ_SUB);
+    void *sub2 = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub1, "inproc://xpub_matcher"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub2, "inproc://xpub_matcher"));
+
+    //  Only the first subscription to a topic is passed on.
+    subscribe (sub1, "market.eu");
+    recv_notification (pub, true, "market.eu");
+    subscribe (sub2, "market.eu");
+    subscribe (sub2, "market");
+    recv_notification (pub, true, "market");
+    TEST_ASSERT_EQUAL_INT (2, get_int_option (pub, ZMQ_TOPICS_COUNT));
+
+    send_string_expect_success (pub, "market.eu.fr", 0);
+    send_string_expect_success (pub, "market.us", 0);
+    send_string_expect_success (pub, "other", 0);
+
+    //  A subscriber subscribed along two prefixes gets a single copy.
+    recv_string_expect_success (sub1, "market.eu.fr", 0);
+    recv_string_expect_success (sub2, "market.eu.fr", 0);
+    recv_string_expect_success (sub2, "market.us", 0);
+
+    //  Only the last unsubscription from a topic is passed on. The new
+    //  subscription makes sure the one before it has been processed.
+    unsubscribe (sub1, "market.eu");
+    subscribe (sub1, "news");
+    recv_notification (pub, true, "news");
+    unsubscribe (sub2, "market");
+    recv_notification (pub, false, "market");
+    TEST_ASSERT_EQUAL_INT (2, get_int_option (pub, ZMQ_TOPICS_COUNT));
+
+    send_string_expect_success (pub, "market.us", 0);
+    send_string_expect_success (pub, "market.eu.de", 0);
+    send_string_expect_success (pub, "news", 0);
+    recv_string_expect_success (sub1, "news", 0);
+    recv_string_expect_success (sub2, "market.eu.de", 0);
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN, zmq_recv (sub1, NULL, 0, ZMQ_DONTWAIT));
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN, zmq_recv (sub2, NULL, 0, ZMQ_DONTWAIT));
+
+    //  A closed subscriber is unsubscribed from what remains.
+    test_context_socket_close (sub1);
+    recv_notification (pub, false, "news");
+    test_context_socket_close (sub2);
+    recv_notification (pub, false, "market.eu");
+    TEST_ASSERT_EQUAL_INT (0, get_int_option (pub, ZMQ_TOPICS_COUNT));
+
+    test_context_socket_close (pub);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_match);
+    return UNITY_END ();
+}
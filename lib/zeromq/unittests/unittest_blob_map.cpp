@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include <blob_map.hpp>
+
+#include <unity.h>
+
+#include <map>
+#include <stdlib.h>
+#include <string>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static const unsigned char *bytes (const std::string &s_)
+{
+    return reinterpret_cast<const unsigned char *> (s_.data ());
+}
+
+void test_empty ()
+{
+    zmq::blob_map_t<int> map;
+    TEST_ASSERT_TRUE (map.empty ());
+    TEST_ASSERT_NULL (map.find (bytes ("a"), 1));
+    TEST_ASSERT_FALSE (map.erase (bytes ("a"), 1));
+}
+
+void test_insert_find_erase ()
+{
+    zmq::blob_map_t<int> map;
+
+    //  Short keys are stored inline, the long one on the heap.
+    const std::string short_key ("peer");
+    const std::string long_key (100, 'x');
+    TEST_ASSERT_TRUE (map.insert (bytes (short_key), short_key.size (), 1));
+    TEST_ASSERT_TRUE (map.insert (bytes (long_key), long_key.size (), 2));
+    TEST_ASSERT_TRUE (map.insert (NULL, 0, 3));
+    TEST_ASSERT_EQUAL_UINT (3, map.size ());
+
+    //  Keys are compared by content, including their size.
+    TEST_ASSERT_FALSE (map.insert (bytes (short_key), short_key.size (), 4));
+    TEST_ASSERT_NULL (map.find (bytes (short_key), short_key.size () - 1));
+    TEST_ASSERT_NULL (map.find (bytes (long_key), long_key.size () - 1));
+
+    const zmq::blob_t blob (bytes (long_key), long_key.size ());
+    TEST_ASSERT_NOT_NULL (map.find (blob));
+    TEST_ASSERT_EQUAL_INT (2, *map.find (blob));
+    TEST_ASSERT_EQUAL_INT (1, *map.find (bytes (short_key), short_key.size ()));
+    TEST_ASSERT_EQUAL_INT (3, *map.find (NULL, 0));
+
+    int value = 0;
+    TEST_ASSERT_TRUE (map.erase (blob, &value));
+    TEST_ASSERT_EQUAL_INT (2, value);
+    TEST_ASSERT_NULL (map.find (blob));
+    TEST_ASSERT_FALSE (map.erase (blob));
+    TEST_ASSERT_EQUAL_UINT (2, map.size ());
+}
+
+static bool is_negative (int value_)
+{
+    return value_ < 0;
+}
+
+void test_any_of ()
+{
+    zmq::blob_map_t<int> map;
+    TEST_ASSERT_FALSE (map.any_of (is_negative));
+    map.insert (bytes ("a"), 1, 1);
+    map.insert (bytes ("b"), 1, 2);
+    TEST_ASSERT_FALSE (map.any_of (is_negative));
+    map.insert (bytes ("c"), 1, -3);
+    TEST_ASSERT_TRUE (map.any_of (is_negative));
+}
+
+//  Routing ids as ROUTER generates them, a zero byte and a counter.
+static std::string routing_id (unsigned int index_)
+{
+    std::string res (1, '\0');
+    for (int i = 3; i >= 0; i--)
+        res += static_cast<char> ((index_ >> (i * 8)) & 0xff);
+    //  Every third id is too long to be stored inline.
+    if (index_ % 3 == 0)
+        res += std::string (20, 'y');
+    return res;
+}
+
+void test_against_std_map ()
+{
+    //  Interleaved inserts and erases grow the table and move entries
+    //  back along their probe sequences.
+    zmq::blob_map_t<unsigned int> map;
+    std::map<std::string, unsigned int> reference;
+    srand (12345);
+    for (int i = 0; i != 100000; i++) {
+        const unsigned int index = static_cast<unsigned int> (rand () % 5000);
+        const std::string key = routing_id (index);
+        if (rand () % 3) {
+            const bool inserted =
+              reference.insert (std::make_pair (key, index)).second;
+            TEST_ASSERT_EQUAL (inserted,
+                               map.insert (bytes (key), key.size (), index));
+        } else {
+            unsigned int value = 0;
+            const bool erased = map.erase (bytes (key), key.size (), &value);
+            TEST_ASSERT_EQUAL (reference.erase (key) == 1, erased);
+            if (erased)
+                TEST_ASSERT_EQUAL_UINT (index, value);
+        }
+        TEST_ASSERT_EQUAL_UINT (reference.size (), map.size ());
+    }
+
+    for (unsigned int index = 0; index != 5000; index++) {
+        const std::string key = routing_id (index);
+        const unsigned int *value = map.find (bytes (key), key.size ());
+        if (reference.count (key)) {
+            TEST_ASSERT_NOT_NULL (value);
+            TEST_ASSERT_EQUAL_UINT (index, *value);
+        } else
+            TEST_ASSERT_NULL (value);
+    }
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_insert_find_erase);
+    RUN_TEST (test_any_of);
+    RUN_TEST (test_against_std_map);
+
+    return UNITY_END ();
+}
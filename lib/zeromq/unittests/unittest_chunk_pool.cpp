@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include <chunk_pool.hpp>
+#include <yqueue.hpp>
+
+#include <unity.h>
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+
+#include <thread>
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_chunks_are_reused ()
+{
+    zmq::chunk_pool_t pool (1000, 64, 4);
+    void *chunk = pool.allocate ();
+    TEST_ASSERT_NOT_NULL (chunk);
+    TEST_ASSERT_EQUAL_UINT64 (0, reinterpret_cast<uintptr_t> (chunk) % 64);
+    pool.deallocate (chunk);
+    TEST_ASSERT_EQUAL_PTR (chunk, pool.allocate ());
+    pool.deallocate (chunk);
+}
+
+void test_retention_is_bounded ()
+{
+    zmq::chunk_pool_t pool (1000, 64, 2);
+    void *chunks[3];
+    for (int i = 0; i != 3; i++)
+        chunks[i] = pool.allocate ();
+
+    //  Only two of the three chunks are kept, the third one is freed.
+    for (int i = 0; i != 3; i++)
+        pool.deallocate (chunks[i]);
+    TEST_ASSERT_EQUAL_PTR (chunks[0], pool.allocate ());
+    TEST_ASSERT_EQUAL_PTR (chunks[1], pool.allocate ());
+    void *chunk = pool.allocate ();
+    TEST_ASSERT_NOT_NULL (chunk);
+
+    pool.deallocate (chunks[0]);
+    pool.deallocate (chunks[1]);
+    pool.deallocate (chunk);
+}
+
+void test_yqueue_with_pool ()
+{
+    typedef zmq::yqueue_t<int, 4> queue_t;
+    zmq::chunk_pool_t pool (queue_t::chunk_size (), 64, 8);
+
+    //  Several bursts, each spanning a few chunks.
+    queue_t queue (&pool);
+    for (int burst = 0; burst != 4; burst++) {
+        for (int i = 0; i != 10; i++) {
+            queue.push ();
+            queue.back () = i;
+        }
+        for (int i = 0; i != 10; i++) {
+            TEST_ASSERT_EQUAL_INT (i, queue.front ());
+            queue.pop ();
+        }
+    }
+}
+
+void test_concurrent_use ()
+{
+    zmq::chunk_pool_t pool (256, 64, 16);
+    const int thread_count = 4;
+    const int rounds = 10000;
+
+    //  Each thread writes its chunks and checks nobody else has them.
+    std::vector<std::thread> threads;
+    for (int t = 0; t != thread_count; t++)
+        threads.push_back (std::thread ([&pool, t] {
+            for (int i = 0; i != rounds; i++) {
+                int *chunks[3];
+                for (int j = 0; j != 3; j++) {
+                    chunks[j] = static_cast<int *> (pool.allocate ());
+                    *chunks[j] = t * rounds + i;
+                }
+                for (int j = 0; j != 3; j++) {
+                    TEST_ASSERT_EQUAL_INT (t * rounds + i, *chunks[j]);
+                    pool.deallocate (chunks[j]);
+                }
+            }
+        }));
+    for (size_t t = 0; t != threads.size (); t++)
+        threads[t].join ();
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_chunks_are_reused);
+    RUN_TEST (test_retention_is_bounded);
+    RUN_TEST (test_yqueue_with_pool);
+    RUN_TEST (test_concurrent_use);
+
+    return UNITY_END ();
+}
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+#include "../tests/testutil_unity.hpp"
+
+#include <ctx.hpp>
+#include <io_thread.hpp>
+
+#include <unity.h>
+
+#include <string.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static void *create_socket (void *ctx_, int type_, uint64_t affinity_)
+{
+    void *socket = zmq_socket (ctx_, type_);
+    TEST_ASSERT_NOT_NULL (socket);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket, ZMQ_AFFINITY, &affinity_, sizeof affinity_));
+    return socket;
+}
+
+static void close_socket (void *socket_)
+{
+    const int linger = 0;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_LINGER, &linger, sizeof linger));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (socket_));
+}
+
+static void connect_pair (void *ctx_,
+                          int bind_type_,
+                          int connect_type_,
+                          uint64_t affinity_,
+                          void **bound_,
+                          void **connected_)
+{
+    char endpoint[MAX_SOCKET_STRING];
+    *bound_ = create_socket (ctx_, bind_type_, affinity_);
+    bind_loopback_ipv4 (*bound_, endpoint, sizeof endpoint);
+    *connected_ = create_socket (ctx_, connect_type_, affinity_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (*connected_, endpoint));
+}
+
+//  A thread with a busy connection is avoided, even though the other one
+//  has more, but idle, connections.
+void test_busy_thread_avoided ()
+{
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (ctx, ZMQ_IO_THREADS, 2));
+
+    const int idle_count = 3;
+    void *idle[idle_count * 2];
+    for (int i = 0; i != idle_count; i++)
+        connect_pair (ctx, ZMQ_PAIR, ZMQ_PAIR, 2, &idle[i * 2],
+                      &idle[i * 2 + 1]);
+
+    void *pull;
+    void *push;
+    connect_pair (ctx, ZMQ_PULL, ZMQ_PUSH, 1, &pull, &push);
+
+    //  Keep the first thread busy for a few traffic samples.
+    char buffer[1024];
+    memset (buffer, 0, sizeof buffer);
+    void *watch = zmq_stopwatch_start ();
+    while (zmq_stopwatch_intermediate (watch) < 1500000) {
+        for (int i = 0; i != 64; i++)
+            TEST_ASSERT_EQUAL_INT (
+              sizeof buffer, zmq_send (push, buffer, sizeof buffer, 0));
+        for (int i = 0; i != 64; i++)
+            TEST_ASSERT_EQUAL_INT (sizeof buffer,
+                                   zmq_recv (pull, buffer, sizeof buffer, 0));
+    }
+    zmq_stopwatch_stop (watch);
+
+    zmq::ctx_t *const context = static_cast<zmq::ctx_t *> (ctx);
+    TEST_ASSERT_TRUE (context->choose_io_thread (0)
+                      == context->choose_io_thread (2));
+    TEST_ASSERT_TRUE (context->choose_io_thread (1)->get_traffic ()
+                      > context->choose_io_thread (2)->get_traffic ());
+
+    close_socket (push);
+    close_socket (pull);
+    for (int i = 0; i != idle_count * 2; i++)
+        close_socket (idle[i]);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_busy_thread_avoided);
+    return UNITY_END ();
+}
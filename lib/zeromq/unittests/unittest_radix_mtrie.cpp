@@ -0,0 +1,250 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#if defined(min)
+#undef min
+#endif
+
+#include <generic_mtrie_impl.hpp>
+#include <generic_radix_mtrie_impl.hpp>
+
+#include <unity.h>
+
+#include <set>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+typedef zmq::generic_radix_mtrie_t<int> radix_mtrie_t;
+typedef zmq::generic_mtrie_t<int> mtrie_t;
+
+static radix_mtrie_t::prefix_t bytes (const char *s_)
+{
+    return reinterpret_cast<radix_mtrie_t::prefix_t> (s_);
+}
+
+static radix_mtrie_t::prefix_t bytes (const std::string &s_)
+{
+    return reinterpret_cast<radix_mtrie_t::prefix_t> (s_.data ());
+}
+
+void mtrie_count (int *pipe_, int *count_)
+{
+    LIBZMQ_UNUSED (pipe_);
+    ++*count_;
+}
+
+void mtrie_collect (int *pipe_, std::multiset<int *> *pipes_)
+{
+    pipes_->insert (pipe_);
+}
+
+void mtrie_collect_prefix (const unsigned char *data_,
+                           size_t size_,
+                           std::multiset<std::string> *prefixes_)
+{
+    prefixes_->insert (
+      std::string (reinterpret_cast<const char *> (data_), size_));
+}
+
+void test_empty ()
+{
+    radix_mtrie_t mtrie;
+
+    int count = 0;
+    mtrie.match (bytes ("foo"), 3, mtrie_count, &count);
+    mtrie.match (NULL, 0, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+    TEST_ASSERT_EQUAL_INT (0, mtrie.num_prefixes ());
+
+    int pipe;
+    TEST_ASSERT_EQUAL (radix_mtrie_t::not_found,
+                       mtrie.rm (bytes ("foo"), 3, &pipe));
+}
+
+void test_add_match_prefixes ()
+{
+    int pipe1, pipe2, pipe3;
+    radix_mtrie_t mtrie;
+
+    //  Adding to an existing prefix does not add a new one.
+    TEST_ASSERT_TRUE (mtrie.add (bytes ("foobar"), 6, &pipe1));
+    TEST_ASSERT_FALSE (mtrie.add (bytes ("foobar"), 6, &pipe2));
+    TEST_ASSERT_FALSE (mtrie.add (bytes ("foobar"), 6, &pipe2));
+
+    //  Splits the edge of foobar, and then adds a branch to it.
+    TEST_ASSERT_TRUE (mtrie.add (bytes ("foo"), 3, &pipe3));
+    TEST_ASSERT_TRUE (mtrie.add (bytes ("fox"), 3, &pipe3));
+    TEST_ASSERT_TRUE (mtrie.add (NULL, 0, &pipe1));
+    TEST_ASSERT_EQUAL_INT (4, mtrie.num_prefixes ());
+
+    std::multiset<int *> pipes;
+    mtrie.match (bytes ("foobarbaz"), 9, mtrie_collect, &pipes);
+    TEST_ASSERT_EQUAL_UINT (4, pipes.size ());
+    TEST_ASSERT_EQUAL_UINT (2, pipes.count (&pipe1));
+    TEST_ASSERT_EQUAL_UINT (1, pipes.count (&pipe2));
+    TEST_ASSERT_EQUAL_UINT (1, pipes.count (&pipe3));
+
+    int count = 0;
+    mtrie.match (bytes ("fooba"), 5, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (2, count);
+    count = 0;
+    mtrie.match (bytes ("fo"), 2, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (1, count);
+    count = 0;
+    mtrie.match (bytes ("foxy"), 4, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (2, count);
+}
+
+void test_rm_prefix ()
+{
+    int pipe1, pipe2;
+    radix_mtrie_t mtrie;
+
+    mtrie.add (bytes ("foo"), 3, &pipe1);
+    mtrie.add (bytes ("foobar"), 6, &pipe1);
+    mtrie.add (bytes ("foobar"), 6, &pipe2);
+
+    TEST_ASSERT_EQUAL (radix_mtrie_t::not_found,
+                       mtrie.rm (bytes ("fooba"), 5, &pipe1));
+    TEST_ASSERT_EQUAL (radix_mtrie_t::not_found,
+                       mtrie.rm (bytes ("foo"), 3, &pipe2));
+    TEST_ASSERT_EQUAL (radix_mtrie_t::values_remain,
+                       mtrie.rm (bytes ("foobar"), 6, &pipe1));
+    TEST_ASSERT_EQUAL (radix_mtrie_t::last_value_removed,
+                       mtrie.rm (bytes ("foo"), 3, &pipe1));
+    TEST_ASSERT_EQUAL_INT (1, mtrie.num_prefixes ());
+
+    //  The node of foo has been merged into the one of foobar.
+    int count = 0;
+    mtrie.match (bytes ("foobar"), 6, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (1, count);
+    count = 0;
+    mtrie.match (bytes ("foo"), 3, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+
+    TEST_ASSERT_EQUAL (radix_mtrie_t::last_value_removed,
+                       mtrie.rm (bytes ("foobar"), 6, &pipe2));
+    TEST_ASSERT_EQUAL_INT (0, mtrie.num_prefixes ());
+    TEST_ASSERT_TRUE (mtrie.add (bytes ("foobar"), 6, &pipe2));
+}
+
+void test_many_values ()
+{
+    //  More values than fit in a node, added and removed out of order.
+    std::vector<int> pipes (100);
+    radix_mtrie_t mtrie;
+
+    for (size_t i = 0; i != pipes.size (); i++)
+        mtrie.add (bytes ("topic"), 5, &pipes[(i * 37) % pipes.size ()]);
+
+    int count = 0;
+    mtrie.match (bytes ("topic"), 5, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (100, count);
+
+    for (size_t i = 0; i != pipes.size () - 1; i++)
+        TEST_ASSERT_EQUAL (
+          radix_mtrie_t::values_remain,
+          mtrie.rm (bytes ("topic"), 5, &pipes[(i * 53) % pipes.size ()]));
+    TEST_ASSERT_EQUAL (
+      radix_mtrie_t::last_value_removed,
+      mtrie.rm (bytes ("topic"), 5,
+                &pipes[((pipes.size () - 1) * 53) % pipes.size ()]));
+}
+
+void test_rm_value ()
+{
+    int pipe1, pipe2;
+    radix_mtrie_t mtrie;
+
+    mtrie.add (bytes ("a"), 1, &pipe1);
+    mtrie.add (bytes ("ab"), 2, &pipe1);
+    mtrie.add (bytes ("ab"), 2, &pipe2);
+    mtrie.add (bytes ("abc"), 3, &pipe1);
+    mtrie.add (bytes ("b"), 1, &pipe2);
+    mtrie.add (NULL, 0, &pipe1);
+
+    //  Only the prefixes left without values are reported.
+    std::multiset<std::string> prefixes;
+    mtrie.rm (&pipe1, mtrie_collect_prefix, &prefixes, true);
+    TEST_ASSERT_EQUAL_UINT (3, prefixes.size ());
+    TEST_ASSERT_EQUAL_UINT (1, prefixes.count (""));
+    TEST_ASSERT_EQUAL_UINT (1, prefixes.count ("a"));
+    TEST_ASSERT_EQUAL_UINT (1, prefixes.count ("abc"));
+    TEST_ASSERT_EQUAL_INT (2, mtrie.num_prefixes ());
+
+    //  Every removal is reported.
+    prefixes.clear ();
+    mtrie.rm (&pipe2, mtrie_collect_prefix, &prefixes, false);
+    TEST_ASSERT_EQUAL_UINT (2, prefixes.size ());
+    TEST_ASSERT_EQUAL_UINT (1, prefixes.count ("ab"));
+    TEST_ASSERT_EQUAL_UINT (1, prefixes.count ("b"));
+    TEST_ASSERT_EQUAL_INT (0, mtrie.num_prefixes ());
+
+    int count = 0;
+    mtrie.match (bytes ("abc"), 3, mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+}
+
+//  Applies the same random operations to both tries and compares what they
+//  report.
+void test_compare_with_mtrie ()
+{
+    const char alphabet[] = "abc";
+    std::vector<int> pipes (8);
+    radix_mtrie_t radix;
+    mtrie_t mtrie;
+
+    srand (1);
+    for (int i = 0; i != 20000; i++) {
+        std::string topic (rand () % 6, 'a');
+        for (size_t j = 0; j != topic.size (); j++)
+            topic[j] = alphabet[rand () % 3];
+        int *const pipe = &pipes[rand () % pipes.size ()];
+
+        const int operation = rand () % 16;
+        if (operation < 8) {
+            TEST_ASSERT_EQUAL (mtrie.add (bytes (topic), topic.size (), pipe),
+                               radix.add (bytes (topic), topic.size (), pipe));
+        } else if (operation < 14) {
+            TEST_ASSERT_EQUAL_INT (
+              mtrie.rm (bytes (topic), topic.size (), pipe),
+              radix.rm (bytes (topic), topic.size (), pipe));
+        } else if (operation < 15) {
+            const bool call_on_uniq = rand () % 2 != 0;
+            std::multiset<std::string> expected, actual;
+            mtrie.rm (pipe, mtrie_collect_prefix, &expected, call_on_uniq);
+            radix.rm (pipe, mtrie_collect_prefix, &actual, call_on_uniq);
+            TEST_ASSERT_TRUE (expected == actual);
+        } else {
+            std::multiset<int *> expected, actual;
+            mtrie.match (bytes (topic), topic.size (), mtrie_collect,
+                         &expected);
+            radix.match (bytes (topic), topic.size (), mtrie_collect, &actual);
+            TEST_ASSERT_TRUE (expected == actual);
+        }
+        TEST_ASSERT_EQUAL_UINT (mtrie.num_prefixes (), radix.num_prefixes ());
+    }
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_add_match_prefixes);
+    RUN_TEST (test_rm_prefix);
+    RUN_TEST (test_many_values);
+    RUN_TEST (test_rm_value);
+    RUN_TEST (test_compare_with_mtrie);
+    return UNITY_END ();
+}
@@ -177,6 +177,34 @@ void test_check_null_entry_added ()
     TEST_ASSERT_TRUE (tree_check (tree, "all queries return true"));
 }
 
+void test_check_long_entries ()
+{
+    zmq::radix_tree_t tree;
+
+    //  Long enough to be compared 32 and 16 bytes at a time, with a
+    //  mismatch at each position.
+    const std::string key (100, 'x');
+    tree_add (tree, key);
+    TEST_ASSERT_TRUE (tree_check (tree, key));
+    TEST_ASSERT_TRUE (tree_check (tree, key + "tail"));
+    TEST_ASSERT_FALSE (tree_check (tree, key.substr (0, 99)));
+    for (size_t i = 0; i < key.size (); ++i) {
+        std::string query = key + "tail";
+        query[i] = 'y';
+        TEST_ASSERT_FALSE (tree_check (tree, query));
+    }
+
+    //  The same with more than one entry in the tree.
+    tree_add (tree, std::string (40, 'x') + "z");
+    TEST_ASSERT_TRUE (tree_check (tree, std::string (40, 'x') + "z"));
+    TEST_ASSERT_TRUE (tree_check (tree, key));
+    for (size_t i = 0; i < key.size (); ++i) {
+        std::string query = key;
+        query[i] = 'y';
+        TEST_ASSERT_FALSE (tree_check (tree, query));
+    }
+}
+
 void test_size ()
 {
     zmq::radix_tree_t tree;
@@ -264,6 +292,7 @@ int main (void)
     RUN_TEST (test_check_nonexistent_entry);
     RUN_TEST (test_check_query_longer_than_entry);
     RUN_TEST (test_check_null_entry_added);
+    RUN_TEST (test_check_long_entries);
 
     RUN_TEST (test_size);
 
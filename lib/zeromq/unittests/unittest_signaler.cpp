@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include <signaler.hpp>
+
+#include <unity.h>
+
+#if defined ZMQ_HAVE_STD_ATOMIC
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_wait_without_signal ()
+{
+    zmq::signaler_t signaler;
+    TEST_ASSERT_EQUAL_INT (-1, signaler.wait (0));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+
+#if defined ZMQ_SIGNALER_STATS
+    //  Finding out that nothing is pending takes no system call.
+    zmq::signaler_t::stats_t stats;
+    signaler.get_stats (&stats);
+    TEST_ASSERT_EQUAL_UINT64 (0, stats.polls);
+#endif
+}
+
+void test_signals_are_coalesced ()
+{
+    zmq::signaler_t signaler;
+    for (int i = 0; i != 3; i++)
+        signaler.send ();
+
+    TEST_ASSERT_EQUAL_INT (0, signaler.wait (0));
+    TEST_ASSERT_EQUAL_INT (0, signaler.recv_failable ());
+
+    //  Nothing is left once the single signal is read.
+    TEST_ASSERT_EQUAL_INT (-1, signaler.wait (0));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+
+#if defined ZMQ_SIGNALER_STATS
+    zmq::signaler_t::stats_t stats;
+    signaler.get_stats (&stats);
+    TEST_ASSERT_EQUAL_UINT64 (3, stats.signals);
+    TEST_ASSERT_EQUAL_UINT64 (1, stats.writes);
+    TEST_ASSERT_EQUAL_UINT64 (1, stats.polls);
+    TEST_ASSERT_EQUAL_UINT64 (1, stats.reads);
+#endif
+}
+
+void test_signal_after_recv ()
+{
+    zmq::signaler_t signaler;
+    signaler.send ();
+    TEST_ASSERT_EQUAL_INT (0, signaler.wait (-1));
+    signaler.recv ();
+
+    //  A signal sent after the previous one was read is not lost.
+    signaler.send ();
+    TEST_ASSERT_EQUAL_INT (0, signaler.wait (0));
+    signaler.recv ();
+
+#if defined ZMQ_SIGNALER_STATS
+    zmq::signaler_t::stats_t stats;
+    signaler.get_stats (&stats);
+    TEST_ASSERT_EQUAL_UINT64 (2, stats.writes);
+    TEST_ASSERT_EQUAL_UINT64 (2, stats.reads);
+#endif
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_wait_without_signal);
+    RUN_TEST (test_signals_are_coalesced);
+    RUN_TEST (test_signal_after_recv);
+
+    return UNITY_END ();
+}
+
+#else
+
+int main ()
+{
+    return 0;
+}
+
+#endif
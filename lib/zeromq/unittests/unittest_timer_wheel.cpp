@@ -0,0 +1,324 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include <timer_wheel.hpp>
+
+#include <unity.h>
+
+#include <map>
+#include <stdlib.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static int owner_a;
+static int owner_b;
+
+static void expect_expired (zmq::timer_wheel_t &wheel_,
+                            uint64_t now_,
+                            void *owner_,
+                            int id_)
+{
+    void *owner = NULL;
+    int id = -1;
+    void *arg = NULL;
+    TEST_ASSERT_TRUE (wheel_.expire (now_, &owner, &id, &arg));
+    TEST_ASSERT_EQUAL_PTR (owner_, owner);
+    TEST_ASSERT_EQUAL_INT (id_, id);
+}
+
+static void expect_none_expired (zmq::timer_wheel_t &wheel_, uint64_t now_)
+{
+    void *owner;
+    int id;
+    void *arg;
+    TEST_ASSERT_FALSE (wheel_.expire (now_, &owner, &id, &arg));
+}
+
+void test_empty ()
+{
+    zmq::timer_wheel_t wheel;
+    TEST_ASSERT_TRUE (wheel.empty ());
+    TEST_ASSERT_FALSE (wheel.cancel (&owner_a, 1));
+    expect_none_expired (wheel, 1000);
+
+    void *owner;
+    int id;
+    void *arg;
+    TEST_ASSERT_FALSE (wheel.pop (&owner, &id, &arg));
+}
+
+void test_order ()
+{
+    zmq::timer_wheel_t wheel;
+    const uint64_t now = 1000;
+    wheel.add (now, now + 30, &owner_a, 3);
+    wheel.add (now, now + 10, &owner_a, 1);
+    wheel.add (now, now + 20, &owner_b, 2);
+    wheel.add (now, now + 10, &owner_b, 4);
+    TEST_ASSERT_EQUAL_UINT (4, wheel.size ());
+    TEST_ASSERT_EQUAL_UINT64 (now + 10, wheel.next_expiration ());
+
+    expect_none_expired (wheel, now + 9);
+
+    //  Timers expiring at the same time keep the order they were added in.
+    expect_expired (wheel, now + 25, &owner_a, 1);
+    expect_expired (wheel, now + 25, &owner_b, 4);
+    expect_expired (wheel, now + 25, &owner_b, 2);
+    expect_none_expired (wheel, now + 25);
+    TEST_ASSERT_EQUAL_UINT64 (now + 30, wheel.next_expiration ());
+
+    expect_expired (wheel, now + 30, &owner_a, 3);
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_overdue ()
+{
+    zmq::timer_wheel_t wheel;
+    wheel.add (1000, 900, &owner_a, 1);
+    TEST_ASSERT_EQUAL_UINT64 (900, wheel.next_expiration ());
+    expect_expired (wheel, 1000, &owner_a, 1);
+}
+
+void test_zero_delay ()
+{
+    //  Once the timers due at a time have expired, a timer added for
+    //  that time is due at once, not a tick later.
+    zmq::timer_wheel_t wheel;
+    wheel.add (1000, 1010, &owner_a, 1);
+    wheel.add (1000, 1011, &owner_a, 2);
+    expect_expired (wheel, 1010, &owner_a, 1);
+    expect_none_expired (wheel, 1010);
+
+    wheel.add (1010, 1010, &owner_b, 3);
+    TEST_ASSERT_EQUAL_UINT64 (1010, wheel.next_expiration ());
+    expect_expired (wheel, 1010, &owner_b, 3);
+    expect_none_expired (wheel, 1010);
+
+    //  Overdue timers come before later ones, in the order of their
+    //  expiration.
+    wheel.add (1010, 1005, &owner_b, 4);
+    wheel.add (1010, 1002, &owner_b, 5);
+    wheel.add (1010, 1005, &owner_b, 6);
+    TEST_ASSERT_EQUAL_UINT64 (1002, wheel.next_expiration ());
+    expect_expired (wheel, 1011, &owner_b, 5);
+    expect_expired (wheel, 1011, &owner_b, 4);
+    expect_expired (wheel, 1011, &owner_b, 6);
+    expect_expired (wheel, 1011, &owner_a, 2);
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_rearm_while_expiring ()
+{
+    //  A handler re-arming its timer with no delay while the due timers
+    //  are handed out gets it back in the same round, after the timers
+    //  due before, also if it was the last one due.
+    zmq::timer_wheel_t wheel;
+    wheel.add (0, 10, &owner_a, 1);
+    wheel.add (0, 12, &owner_a, 2);
+    wheel.add (0, 15, &owner_a, 3);
+    wheel.add (0, 20, &owner_a, 4);
+
+    expect_expired (wheel, 15, &owner_a, 1);
+    wheel.add (15, 15, &owner_a, 1);
+    expect_expired (wheel, 15, &owner_a, 2);
+    expect_expired (wheel, 15, &owner_a, 3);
+    expect_expired (wheel, 15, &owner_a, 1);
+    wheel.add (15, 15, &owner_a, 1);
+    expect_expired (wheel, 15, &owner_a, 1);
+    expect_none_expired (wheel, 15);
+    TEST_ASSERT_EQUAL_UINT64 (20, wheel.next_expiration ());
+
+    wheel.add (15, 16, &owner_a, 1);
+    TEST_ASSERT_EQUAL_UINT64 (16, wheel.next_expiration ());
+    expect_expired (wheel, 16, &owner_a, 1);
+    expect_expired (wheel, 20, &owner_a, 4);
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_cancel_find ()
+{
+    zmq::timer_wheel_t wheel;
+    int arg_value = 42;
+    wheel.add (0, 100, &owner_a, 1, &arg_value);
+    wheel.add (0, 100000, &owner_a, 2);
+
+    uint64_t expiration = 0;
+    void *arg = NULL;
+    TEST_ASSERT_TRUE (wheel.find (&owner_a, 1, &expiration, &arg));
+    TEST_ASSERT_EQUAL_UINT64 (100, expiration);
+    TEST_ASSERT_EQUAL_PTR (&arg_value, arg);
+    TEST_ASSERT_FALSE (wheel.find (&owner_b, 1, &expiration, &arg));
+
+    arg = NULL;
+    TEST_ASSERT_TRUE (wheel.cancel (&owner_a, 1, &arg));
+    TEST_ASSERT_EQUAL_PTR (&arg_value, arg);
+    TEST_ASSERT_FALSE (wheel.cancel (&owner_a, 1));
+    TEST_ASSERT_FALSE (wheel.find (&owner_a, 1, &expiration, &arg));
+
+    expect_none_expired (wheel, 1000);
+    TEST_ASSERT_TRUE (wheel.cancel (&owner_a, 2));
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_cancel_while_expiring ()
+{
+    zmq::timer_wheel_t wheel;
+    wheel.add (0, 10, &owner_a, 1);
+    wheel.add (0, 10, &owner_a, 2);
+    wheel.add (0, 10, &owner_a, 3);
+
+    //  A timer that is due may still be cancelled before it is returned.
+    expect_expired (wheel, 10, &owner_a, 1);
+    TEST_ASSERT_TRUE (wheel.cancel (&owner_a, 2));
+    expect_expired (wheel, 10, &owner_a, 3);
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_cascade ()
+{
+    //  Timers on each of the levels, added at a time that is not aligned
+    //  to any slot.
+    zmq::timer_wheel_t wheel;
+    const uint64_t now = 0x12345678;
+    const uint64_t delays[] = {300, 70000, 20000000, 3000000000ULL};
+    for (int i = 0; i != 4; i++)
+        wheel.add (now, now + delays[i], &owner_a, i);
+
+    for (int i = 0; i != 4; i++) {
+        const uint64_t expiration = now + delays[i];
+        const uint64_t next = wheel.next_expiration ();
+        TEST_ASSERT_TRUE (next <= expiration);
+        expect_none_expired (wheel, expiration - 1);
+        expect_expired (wheel, expiration, &owner_a, i);
+    }
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_far ()
+{
+    //  Timers beyond the reach of the wheel, including one that never
+    //  expires in practice.
+    zmq::timer_wheel_t wheel;
+    const uint64_t far = uint64_t (1) << 33;
+    wheel.add (0, far, &owner_a, 1);
+    wheel.add (0, ~uint64_t (0), &owner_a, 2);
+    wheel.add (0, 5, &owner_a, 3);
+
+    expect_expired (wheel, 10, &owner_a, 3);
+    TEST_ASSERT_TRUE (wheel.next_expiration () <= far);
+    expect_none_expired (wheel, uint64_t (1) << 32);
+    expect_none_expired (wheel, far - 1);
+    expect_expired (wheel, far, &owner_a, 1);
+    expect_none_expired (wheel, far + 1000);
+    TEST_ASSERT_EQUAL_UINT (1, wheel.size ());
+}
+
+void test_pop ()
+{
+    zmq::timer_wheel_t wheel;
+    wheel.add (0, 10, &owner_a, 1);
+    wheel.add (0, 100000, &owner_b, 2);
+    expect_expired (wheel, 10, &owner_a, 1);
+
+    void *owner;
+    int id;
+    void *arg;
+    TEST_ASSERT_TRUE (wheel.pop (&owner, &id, &arg));
+    TEST_ASSERT_EQUAL_PTR (&owner_b, owner);
+    TEST_ASSERT_EQUAL_INT (2, id);
+    TEST_ASSERT_FALSE (wheel.pop (&owner, &id, &arg));
+}
+
+void test_against_multimap ()
+{
+    //  Random adds, cancels and expiries with a clock moving on at random
+    //  paces must return the same timers as a sorted map.
+    zmq::timer_wheel_t wheel;
+    typedef std::multimap<uint64_t, int> reference_t;
+    reference_t reference;
+    std::map<int, uint64_t> active;
+    srand (12345);
+
+    uint64_t now = 1000;
+    int next_id = 0;
+    for (int i = 0; i != 20000; i++) {
+        const int op = rand () % 8;
+        if (op < 4) {
+            //  Mostly short delays, some long ones.
+            uint64_t delay = static_cast<uint64_t> (rand () % 1000) + 1;
+            if (op == 0)
+                delay = 0;
+            else if (op == 3)
+                delay = static_cast<uint64_t> (rand ()) * (rand () % 64) + 1;
+            const int id = next_id++;
+            wheel.add (now, now + delay, &owner_a, id);
+            reference.insert (reference_t::value_type (now + delay, id));
+            active[id] = now + delay;
+        } else if (op == 4 && !active.empty ()) {
+            std::map<int, uint64_t>::iterator it =
+              active.lower_bound (rand () % next_id);
+            if (it == active.end ())
+                it = active.begin ();
+            TEST_ASSERT_TRUE (wheel.cancel (&owner_a, it->first));
+            std::pair<reference_t::iterator, reference_t::iterator> range =
+              reference.equal_range (it->second);
+            while (range.first->second != it->first)
+                ++range.first;
+            reference.erase (range.first);
+            active.erase (it);
+        } else {
+            now += static_cast<uint64_t> (rand () % (op == 7 ? 100000 : 300));
+            if (!wheel.empty ()) {
+                const uint64_t next = wheel.next_expiration ();
+                TEST_ASSERT_TRUE (next <= reference.begin ()->first);
+            }
+
+            void *owner;
+            int id;
+            void *arg;
+            uint64_t last = 0;
+            while (wheel.expire (now, &owner, &id, &arg)) {
+                TEST_ASSERT_EQUAL_UINT (1, active.count (id));
+                const uint64_t expiration = active[id];
+                TEST_ASSERT_TRUE (expiration <= now);
+                TEST_ASSERT_TRUE (expiration >= last);
+                last = expiration;
+                std::pair<reference_t::iterator, reference_t::iterator>
+                  range = reference.equal_range (expiration);
+                while (range.first->second != id)
+                    ++range.first;
+                reference.erase (range.first);
+                active.erase (id);
+            }
+            TEST_ASSERT_TRUE (reference.empty ()
+                              || reference.begin ()->first > now);
+        }
+        TEST_ASSERT_EQUAL_UINT (reference.size (), wheel.size ());
+    }
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_order);
+    RUN_TEST (test_overdue);
+    RUN_TEST (test_zero_delay);
+    RUN_TEST (test_rearm_while_expiring);
+    RUN_TEST (test_cancel_find);
+    RUN_TEST (test_cancel_while_expiring);
+    RUN_TEST (test_cascade);
+    RUN_TEST (test_far);
+    RUN_TEST (test_pop);
+    RUN_TEST (test_against_multimap);
+
+    return UNITY_END ();
+}
@@ -5,6 +5,12 @@
 #include <iostream>
 #include <cstring>
 #include <atomic>
+#include <algorithm>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -16,6 +22,11 @@
     #include <errno.h>
 #endif
 
+// Draft XPUB option, accepted by the vendored libzmq in every build
+#ifndef ZMQ_XPUB_MANUAL_LAST_VALUE
+#define ZMQ_XPUB_MANUAL_LAST_VALUE 98
+#endif
+
 namespace prj1 {
 
 // Maximum message size (10 MB)
@@ -28,6 +39,438 @@ constexpr size_t MAX_PATH_LENGTH = 256;
 constexpr size_t MAX_PATH_LENGTH = 108;  // Unix domain socket path limit
 #endif
 
+// Interval at which the publisher service thread handles subscription notifications
+constexpr int SERVICE_INTERVAL_MS = 10;
+
+// Arena block size of the last-value cache
+constexpr size_t LVC_BLOCK_SIZE = 1024 * 1024;
+
+// Bounds of the replay to a new prefix subscription: the cached values it
+// sends, and the cache slots it examines while publishers wait on the mutex
+constexpr size_t LVC_MAX_REPLAY_VALUES = 1024;
+constexpr size_t LVC_MAX_REPLAY_SCAN = 256 * 1024;
+
+// Credit frames of the PUSH/PULL credit mode: a kind byte and a 32-bit big-endian count
+constexpr size_t CREDIT_FRAME_SIZE = 5;
+constexpr char CREDIT_HELLO = 'H';      // Worker's full window, sent on every (re)connection
+constexpr char CREDIT_GRANT = 'G';      // Messages the worker consumed since its last grant
+constexpr char CREDIT_GONE = 'D';       // Generated by the pusher's socket when a worker disconnects
+
+// Credit-mode workers run on ROUTER: the pusher's routing id, and the inproc
+// endpoint on which the worker watches its connection for (re)connects
+constexpr char PUSHER_ROUTING_ID[] = "pusher";
+constexpr char CREDIT_MONITOR_ENDPOINT[] = "inproc://prj1-credit-monitor";
+
+/**
+ * @class TopicIndex
+ * @brief Radix tree of topic prefixes holding subscriptions and handlers
+ * 
+ * Edges carry whole labels, so memory grows with the number of distinct
+ * topics rather than their total length. Every lookup visits at most one
+ * node per label, which keeps dispatch at O(topic length).
+ */
+class TopicIndex {
+public:
+    TopicIndex() : root(new Node()), subscription_count(0) {}
+    
+    // Adds a reference to the topic's subscription; returns true for the first one
+    bool AddSubscription(const std::string& topic) {
+        Node* node = Insert(topic);
+        if (node->subscriptions++ > 0) {
+            return false;
+        }
+        subscription_count++;
+        return true;
+    }
+    
+    // Drops a reference to the topic's subscription and reports in last whether
+    // it was the final one; returns false if the topic was not subscribed
+    bool RemoveSubscription(const std::string& topic, bool& last) {
+        Node* node = Find(topic);
+        if (!node || node->subscriptions == 0) {
+            return false;
+        }
+        last = --node->subscriptions == 0;
+        if (last) {
+            subscription_count--;
+            Prune(root.get(), topic, 0);
+        }
+        return true;
+    }
+    
+    void SetHandler(const std::string& topic, TopicHandler handler) {
+        if (handler) {
+            Insert(topic)->handler = std::move(handler);
+            return;
+        }
+        Node* node = Find(topic);
+        if (node) {
+            node->handler = nullptr;
+            Prune(root.get(), topic, 0);
+        }
+    }
+    
+    // Returns the handler registered for the longest prefix of message, if any
+    const TopicHandler* FindHandler(const std::string& message, size_t& topic_length) const {
+        const TopicHandler* best = root->handler ? &root->handler : nullptr;
+        topic_length = 0;
+        
+        const Node* node = root.get();
+        size_t pos = 0;
+        while (pos < message.size()) {
+            const Node* child = FindChild(node, static_cast<unsigned char>(message[pos]));
+            if (!child || message.compare(pos, child->label.size(), child->label) != 0) {
+                break;
+            }
+            pos += child->label.size();
+            node = child;
+            if (node->handler) {
+                best = &node->handler;
+                topic_length = pos;
+            }
+        }
+        return best;
+    }
+    
+    size_t SubscriptionCount() const {
+        return subscription_count;
+    }
+    
+    void Clear() {
+        root.reset(new Node());
+        subscription_count = 0;
+    }
+
+private:
+    struct Node {
+        std::string label;                              // Edge label from the parent
+        std::vector<std::unique_ptr<Node>> children;    // Sorted by first label byte
+        size_t subscriptions;                           // Subscribe() calls not yet undone
+        TopicHandler handler;
+        
+        Node() : subscriptions(0) {}
+        
+        bool Unused() const {
+            return subscriptions == 0 && !handler;
+        }
+    };
+    
+    std::unique_ptr<Node> root;
+    size_t subscription_count;
+    
+    static std::vector<std::unique_ptr<Node>>::const_iterator
+    LowerBound(const Node* node, unsigned char first) {
+        return std::lower_bound(node->children.begin(), node->children.end(), first,
+            [](const std::unique_ptr<Node>& child, unsigned char c) {
+                return static_cast<unsigned char>(child->label[0]) < c;
+            });
+    }
+    
+    static Node* FindChild(const Node* node, unsigned char first) {
+        auto it = LowerBound(node, first);
+        if (it == node->children.end() || static_cast<unsigned char>((*it)->label[0]) != first) {
+            return nullptr;
+        }
+        return it->get();
+    }
+    
+    Node* Find(const std::string& topic) const {
+        Node* node = root.get();
+        size_t pos = 0;
+        while (pos < topic.size()) {
+            Node* child = FindChild(node, static_cast<unsigned char>(topic[pos]));
+            if (!child || topic.compare(pos, child->label.size(), child->label) != 0) {
+                return nullptr;
+            }
+            pos += child->label.size();
+            node = child;
+        }
+        return node;
+    }
+    
+    Node* Insert(const std::string& topic) {
+        Node* node = root.get();
+        size_t pos = 0;
+        while (pos < topic.size()) {
+            unsigned char first = static_cast<unsigned char>(topic[pos]);
+            auto it = node->children.begin() + (LowerBound(node, first) - node->children.begin());
+            
+            if (it == node->children.end() || static_cast<unsigned char>((*it)->label[0]) != first) {
+                std::unique_ptr<Node> leaf(new Node());
+                leaf->label = topic.substr(pos);
+                Node* result = leaf.get();
+                node->children.insert(it, std::move(leaf));
+                return result;
+            }
+            
+            Node* child = it->get();
+            size_t common = 0;
+            size_t limit = std::min(child->label.size(), topic.size() - pos);
+            while (common < limit && child->label[common] == topic[pos + common]) {
+                common++;
+            }
+            
+            if (common < child->label.size()) {
+                // Split the edge so the topic ends on (or branches from) a node
+                std::unique_ptr<Node> middle(new Node());
+                middle->label = child->label.substr(0, common);
+                child->label.erase(0, common);
+                middle->children.push_back(std::move(*it));
+                *it = std::move(middle);
+                child = it->get();
+            }
+            
+            pos += common;
+            node = child;
+        }
+        return node;
+    }
+    
+    // Removes unused nodes along the topic path and merges pass-through nodes
+    void Prune(Node* node, const std::string& topic, size_t pos) {
+        if (pos >= topic.size()) {
+            return;
+        }
+        
+        unsigned char first = static_cast<unsigned char>(topic[pos]);
+        auto it = node->children.begin() + (LowerBound(node, first) - node->children.begin());
+        if (it == node->children.end() || static_cast<unsigned char>((*it)->label[0]) != first) {
+            return;
+        }
+        
+        Node* child = it->get();
+        Prune(child, topic, pos + child->label.size());
+        
+        if (!child->Unused()) {
+            return;
+        }
+        if (child->children.empty()) {
+            node->children.erase(it);
+        } else if (child->children.size() == 1) {
+            std::unique_ptr<Node> grandchild = std::move(child->children.front());
+            grandchild->label = child->label + grandchild->label;
+            *it = std::move(grandchild);
+        }
+    }
+};
+
+/**
+ * @class LastValueCache
+ * @brief Latest published message per topic, stored in an arena-backed hash map
+ * 
+ * Messages live in large arena blocks as [header][message] records and the
+ * open-addressing table only holds a 64-bit hash and a record reference per
+ * topic, so millions of topics cost little more than their message bytes.
+ * Records are overwritten in place when the new message fits; outgrown
+ * records are abandoned and reclaimed by compacting the arena once the
+ * wasted space exceeds the live data.
+ */
+class LastValueCache {
+public:
+    LastValueCache() : count(0), live_bytes(0), wasted_bytes(0), block_used(0) {}
+    
+    // Stores message as the latest value of the topic formed by its first topic_length bytes
+    void Store(const std::string& message, size_t topic_length) {
+        if (slots.empty() || (count + 1) * 10 > slots.size() * 7) {
+            Rehash(slots.empty() ? 1024 : slots.size() * 2);
+        }
+        
+        uint64_t hash = Hash(message.data(), topic_length);
+        size_t mask = slots.size() - 1;
+        size_t index = static_cast<size_t>(hash) & mask;
+        
+        while (slots[index].ref != 0) {
+            Slot& slot = slots[index];
+            Record* record = Resolve(slot.ref);
+            if (slot.hash == hash && record->topic_length == topic_length &&
+                std::memcmp(record->Data(), message.data(), topic_length) == 0) {
+                if (message.size() <= record->capacity) {
+                    live_bytes += message.size();
+                    live_bytes -= record->size;
+                    record->size = static_cast<uint32_t>(message.size());
+                    std::memcpy(record->Data(), message.data(), message.size());
+                } else {
+                    wasted_bytes += sizeof(Record) + record->capacity;
+                    live_bytes -= record->size;
+                    slot.ref = Allocate(message.data(), message.size(), topic_length);
+                    live_bytes += message.size();
+                    MaybeCompact();
+                }
+                return;
+            }
+            index = (index + 1) & mask;
+        }
+        
+        slots[index].hash = hash;
+        slots[index].ref = Allocate(message.data(), message.size(), topic_length);
+        live_bytes += message.size();
+        count++;
+    }
+    
+    // Calls f(data, size) for the latest message of every topic starting with
+    // prefix until f returns false, examining at most max_slots table slots;
+    // returns false if the scan stopped before covering the whole cache
+    template <typename F>
+    bool ForEachMatching(const std::string& prefix, char delimiter, size_t max_slots, F f) const {
+        if (slots.empty()) {
+            return true;
+        }
+        
+        // A prefix that contains the delimiter names exactly one topic
+        size_t delimiter_pos = prefix.find(delimiter);
+        if (delimiter_pos != std::string::npos) {
+            const Record* record = Lookup(prefix.data(), delimiter_pos);
+            if (record && record->size >= prefix.size() &&
+                std::memcmp(record->Data(), prefix.data(), prefix.size()) == 0) {
+                f(record->Data(), record->size);
+            }
+            return true;
+        }
+        
+        size_t end = std::min(slots.size(), max_slots);
+        for (size_t i = 0; i < end; i++) {
+            if (slots[i].ref == 0) {
+                continue;
+            }
+            const Record* record = Resolve(slots[i].ref);
+            if (record->size >= prefix.size() &&
+                std::memcmp(record->Data(), prefix.data(), prefix.size()) == 0 &&
+                !f(record->Data(), record->size)) {
+                return false;
+            }
+        }
+        return end == slots.size();
+    }
+    
+    size_t Size() const {
+        return count;
+    }
+    
+    void Clear() {
+        slots.clear();
+        blocks.clear();
+        count = 0;
+        live_bytes = 0;
+        wasted_bytes = 0;
+        block_used = 0;
+    }
+
+private:
+    // Arena record header, followed by capacity bytes of message data
+    struct Record {
+        uint32_t topic_length;
+        uint32_t size;
+        uint32_t capacity;
+        
+        char* Data() { return reinterpret_cast<char*>(this + 1); }
+        const char* Data() const { return reinterpret_cast<const char*>(this + 1); }
+    };
+    
+    // Record reference: (block index + 1) << 32 | offset; zero marks an empty slot
+    struct Slot {
+        uint64_t hash;
+        uint64_t ref;
+        
+        Slot() : hash(0), ref(0) {}
+    };
+    
+    std::vector<Slot> slots;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t count;
+    size_t live_bytes;
+    size_t wasted_bytes;
+    size_t block_used;      // Bytes used in the last block
+    
+    static uint64_t Hash(const char* data, size_t size) {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+    
+    Record* Resolve(uint64_t ref) const {
+        char* block = blocks[static_cast<size_t>(ref >> 32) - 1].get();
+        return reinterpret_cast<Record*>(block + static_cast<uint32_t>(ref));
+    }
+    
+    const Record* Lookup(const char* topic, size_t topic_length) const {
+        uint64_t hash = Hash(topic, topic_length);
+        size_t mask = slots.size() - 1;
+        for (size_t index = static_cast<size_t>(hash) & mask; slots[index].ref != 0;
+             index = (index + 1) & mask) {
+            const Record* record = Resolve(slots[index].ref);
+            if (slots[index].hash == hash && record->topic_length == topic_length &&
+                std::memcmp(record->Data(), topic, topic_length) == 0) {
+                return record;
+            }
+        }
+        return nullptr;
+    }
+    
+    uint64_t Allocate(const char* data, size_t size, size_t topic_length) {
+        // Leave headroom so values that grow slightly are updated in place
+        const size_t align = alignof(Record);
+        size_t capacity = (size + size / 4 + align - 1) & ~(align - 1);
+        size_t needed = sizeof(Record) + capacity;
+        
+        if (blocks.empty() || block_used + needed > LVC_BLOCK_SIZE) {
+            // Oversized records get a dedicated block
+            blocks.emplace_back(new char[std::max(needed, LVC_BLOCK_SIZE)]);
+            block_used = 0;
+        }
+        
+        uint64_t ref = (static_cast<uint64_t>(blocks.size()) << 32) | block_used;
+        Record* record = Resolve(ref);
+        record->topic_length = static_cast<uint32_t>(topic_length);
+        record->size = static_cast<uint32_t>(size);
+        record->capacity = static_cast<uint32_t>(capacity);
+        std::memcpy(record->Data(), data, size);
+        
+        // A dedicated block is full; the next record starts a new one
+        block_used = (needed > LVC_BLOCK_SIZE) ? LVC_BLOCK_SIZE : block_used + needed;
+        return ref;
+    }
+    
+    void Rehash(size_t capacity) {
+        std::vector<Slot> old_slots(capacity);
+        old_slots.swap(slots);
+        size_t mask = capacity - 1;
+        for (const Slot& slot : old_slots) {
+            if (slot.ref == 0) {
+                continue;
+            }
+            size_t index = static_cast<size_t>(slot.hash) & mask;
+            while (slots[index].ref != 0) {
+                index = (index + 1) & mask;
+            }
+            slots[index] = slot;
+        }
+    }
+    
+    void MaybeCompact() {
+        if (wasted_bytes < LVC_BLOCK_SIZE || wasted_bytes < live_bytes) {
+            return;
+        }
+        
+        std::vector<std::unique_ptr<char[]>> old_blocks;
+        old_blocks.swap(blocks);
+        block_used = 0;
+        wasted_bytes = 0;
+        
+        for (Slot& slot : slots) {
+            if (slot.ref == 0) {
+                continue;
+            }
+            const char* old_block = old_blocks[static_cast<size_t>(slot.ref >> 32) - 1].get();
+            const Record* record = reinterpret_cast<const Record*>(old_block + static_cast<uint32_t>(slot.ref));
+            slot.ref = Allocate(record->Data(), record->size, record->topic_length);
+        }
+    }
+};
+
 /**
  * @class ZMQWrapperImpl
  * @brief Implementation class for ZMQWrapper (PIMPL pattern)
@@ -40,9 +483,14 @@ public:
         , initialized(false)
         , config()
         , endpoint_path("")
+        , pending_sequence(0)
+        , conflated_count(0)
+        , monitor(nullptr)
+        , service_stop(false)
     {}
     
     ~ZMQWrapperImpl() {
+        StopServiceThread();
         Cleanup();
     }
     
@@ -54,7 +502,7 @@ public:
         }
         
         // Validate configuration
-        if (cfg.timeout_ms < 0) {
+        if (cfg.timeout_ms < 0 || cfg.send_hwm < 0) {
             return ErrorCode::ERROR_INVALID_CONFIG;
         }
         
@@ -95,6 +543,34 @@ public:
             zmq_setsockopt(socket, ZMQ_RCVTIMEO, &config.timeout_ms, sizeof(config.timeout_ms));
         }
         
+        if (config.send_hwm > 0) {
+            zmq_setsockopt(socket, ZMQ_SNDHWM, &config.send_hwm, sizeof(config.send_hwm));
+        }
+        
+        if (UsesXPub()) {
+            // Pass every subscription up, including repeats from other subscribers
+            int verbose = 1;
+            zmq_setsockopt(socket, ZMQ_XPUB_VERBOSE, &verbose, sizeof(verbose));
+        }
+        
+        if (UsesXPub() && config.last_value_cache) {
+            // Subscriptions are applied by the service thread, so the replay
+            // can be addressed to the subscriber that just subscribed
+            int manual = 1;
+            zmq_setsockopt(socket, ZMQ_XPUB_MANUAL, &manual, sizeof(manual));
+        }
+        
+        if (UsesXPub() && config.conflate_topics) {
+            // Report full subscriber pipes as EAGAIN instead of dropping
+            int nodrop = 1;
+            zmq_setsockopt(socket, ZMQ_XPUB_NODROP, &nodrop, sizeof(nodrop));
+        }
+        
+        if (UsesCredit() && !ConfigureCreditSocket()) {
+            CleanupSocket();
+            return ErrorCode::ERROR_SOCKET_CREATE_FAILED;
+        }
+        
         // Build endpoint
         endpoint_path = BuildEndpoint(config.endpoint);
         if (endpoint_path.empty()) {
@@ -167,6 +643,11 @@ public:
         }
         
         initialized = true;
+        
+        if (UsesXPub()) {
+            service_stop = false;
+            service_thread = std::thread(&ZMQWrapperImpl::ServiceLoop, this);
+        }
         return ErrorCode::SUCCESS;
     }
     
@@ -186,12 +667,29 @@ public:
         const char* data = message.empty() ? "" : message.c_str();
         size_t size = message.size();
         
-        if (zmq_send(socket, data, size, 0) < 0) {
+        if (UsesCredit()) {
+            if (config.mode == Mode::CLIENT) {
+                Log("Workers cannot send in credit mode");
+                return ErrorCode::ERROR_SEND_FAILED;
+            }
+            ErrorCode result = SendWithCredit(data, size);
+            if (result != ErrorCode::SUCCESS) {
+                return result;
+            }
+        } else if (UsesXPub() && config.conflate_topics) {
+            if (!Publish(data, size)) {
+                return ErrorCode::ERROR_SEND_FAILED;
+            }
+        } else if (zmq_send(socket, data, size, 0) < 0) {
             int err = zmq_errno();
             Log("Send failed: " + std::string(zmq_strerror(err)));
             return ErrorCode::ERROR_SEND_FAILED;
         }
         
+        if (config.last_value_cache) {
+            last_values.Store(message, TopicLength(message));
+        }
+        
         Log("Sent message: " + std::to_string(size) + " bytes");
         return ErrorCode::SUCCESS;
     }
@@ -203,68 +701,145 @@ public:
             return ErrorCode::ERROR_NOT_INITIALIZED;
         }
         
-        // Create a message object
-        zmq_msg_t zmq_msg;
-        if (zmq_msg_init(&zmq_msg) != 0) {
-            Log("Failed to initialize message");
+        if (UsesCredit() && config.mode == Mode::SERVER) {
+            Log("Pusher cannot receive in credit mode");
             return ErrorCode::ERROR_RECEIVE_FAILED;
         }
         
-        // Receive message
-        int nbytes = zmq_msg_recv(&zmq_msg, socket, 0);
-        if (nbytes < 0) {
-            int err = zmq_errno();
-            zmq_msg_close(&zmq_msg);
-            
-            if (err == EAGAIN || err == ETIMEDOUT) {
-                Log("Receive timeout");
-                return ErrorCode::ERROR_TIMEOUT;
+        if (UsesCredit()) {
+            return ReceiveTask(message);
+        }
+        return ReceiveLocked(message);
+    }
+    
+    ErrorCode Subscribe(const std::string& topic) {
+        return SubscribeBatch(std::vector<std::string>(1, topic));
+    }
+    
+    ErrorCode SubscribeBatch(const std::vector<std::string>& topics) {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        ErrorCode result = CheckSubscriber();
+        if (result != ErrorCode::SUCCESS) {
+            return result;
+        }
+        
+        // Like libzmq, a topic subscribed n times needs n unsubscribes; only the
+        // first reference is sent upstream
+        std::vector<SubscriptionChange> changes;
+        changes.reserve(topics.size());
+        size_t applied = 0;
+        for (const std::string& topic : topics) {
+            SubscriptionChange change = {&topic, topic_index.AddSubscription(topic)};
+            if (change.sent &&
+                zmq_setsockopt(socket, ZMQ_SUBSCRIBE, topic.c_str(), topic.length()) != 0) {
+                int err = zmq_errno();
+                change.sent = false;
+                changes.push_back(change);
+                RollbackSubscribe(changes);
+                Log("Subscribe failed: " + std::string(zmq_strerror(err)));
+                return ErrorCode::ERROR_SOCKET_CREATE_FAILED;
             }
-            
-            Log("Receive failed: " + std::string(zmq_strerror(err)));
-            return ErrorCode::ERROR_RECEIVE_FAILED;
+            changes.push_back(change);
+            applied += change.sent ? 1 : 0;
         }
         
-        // Extract data
-        size_t size = zmq_msg_size(&zmq_msg);
-        if (size > MAX_MESSAGE_SIZE) {
-            zmq_msg_close(&zmq_msg);
-            Log("Received message too large: " + std::to_string(size) + " bytes");
-            return ErrorCode::ERROR_MESSAGE_TOO_LARGE;
+        if (topics.size() == 1) {
+            Log("Subscribed to topic: " + (topics[0].empty() ? "<all>" : topics[0]));
+        } else {
+            Log("Subscribed to " + std::to_string(applied) + " of " +
+                std::to_string(topics.size()) + " topics");
         }
+        return ErrorCode::SUCCESS;
+    }
+    
+    ErrorCode Unsubscribe(const std::string& topic) {
+        return UnsubscribeBatch(std::vector<std::string>(1, topic));
+    }
+    
+    ErrorCode UnsubscribeBatch(const std::vector<std::string>& topics) {
+        std::lock_guard<std::mutex> lock(mutex);
         
-        const char* data = static_cast<const char*>(zmq_msg_data(&zmq_msg));
-        message.assign(data, size);
+        ErrorCode result = CheckSubscriber();
+        if (result != ErrorCode::SUCCESS) {
+            return result;
+        }
         
-        zmq_msg_close(&zmq_msg);
+        std::vector<SubscriptionChange> changes;
+        changes.reserve(topics.size());
+        size_t applied = 0;
+        for (const std::string& topic : topics) {
+            // Not subscribed (or no references left within the batch): nothing to undo
+            bool last = false;
+            if (!topic_index.RemoveSubscription(topic, last)) {
+                continue;
+            }
+            
+            SubscriptionChange change = {&topic, last};
+            if (change.sent &&
+                zmq_setsockopt(socket, ZMQ_UNSUBSCRIBE, topic.c_str(), topic.length()) != 0) {
+                int err = zmq_errno();
+                change.sent = false;
+                changes.push_back(change);
+                RollbackUnsubscribe(changes);
+                Log("Unsubscribe failed: " + std::string(zmq_strerror(err)));
+                return ErrorCode::ERROR_SOCKET_CREATE_FAILED;
+            }
+            changes.push_back(change);
+            applied += change.sent ? 1 : 0;
+        }
         
-        Log("Received message: " + std::to_string(size) + " bytes");
+        Log("Unsubscribed from " + std::to_string(applied) + " of " +
+            std::to_string(topics.size()) + " topics");
         return ErrorCode::SUCCESS;
     }
     
-    ErrorCode Subscribe(const std::string& topic) {
+    ErrorCode SetTopicHandler(const std::string& topic, TopicHandler handler) {
         std::lock_guard<std::mutex> lock(mutex);
         
-        if (!initialized || !socket) {
-            return ErrorCode::ERROR_NOT_INITIALIZED;
+        ErrorCode result = CheckSubscriber();
+        if (result != ErrorCode::SUCCESS) {
+            return result;
         }
         
-        if (config.pattern != Pattern::PUB_SUB || config.mode != Mode::CLIENT) {
-            Log("Subscribe only valid for PUB/SUB client");
-            return ErrorCode::ERROR_INVALID_PATTERN;
-        }
+        topic_index.SetHandler(topic, std::move(handler));
+        return ErrorCode::SUCCESS;
+    }
+    
+    ErrorCode DispatchMessage() {
+        std::string message;
+        TopicHandler handler;
+        size_t topic_length = 0;
         
-        if (zmq_setsockopt(socket, ZMQ_SUBSCRIBE, topic.c_str(), topic.length()) != 0) {
-            int err = zmq_errno();
-            Log("Subscribe failed: " + std::string(zmq_strerror(err)));
-            return ErrorCode::ERROR_SOCKET_CREATE_FAILED;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            
+            ErrorCode result = CheckSubscriber();
+            if (result != ErrorCode::SUCCESS) {
+                return result;
+            }
+            
+            result = ReceiveLocked(message);
+            if (result != ErrorCode::SUCCESS) {
+                return result;
+            }
+            
+            const TopicHandler* match = topic_index.FindHandler(message, topic_length);
+            if (!match) {
+                Log("No handler for message, dropped");
+                return ErrorCode::SUCCESS;
+            }
+            handler = *match;
         }
         
-        Log("Subscribed to topic: " + (topic.empty() ? "<all>" : topic));
+        // Invoke outside the lock so handlers may call back into the wrapper
+        handler(message.substr(0, topic_length), message);
         return ErrorCode::SUCCESS;
     }
     
     ErrorCode Close() {
+        StopServiceThread();
+        
         std::lock_guard<std::mutex> lock(mutex);
         return Cleanup();
     }
@@ -278,20 +853,571 @@ public:
     }
 
 private:
+    struct WorkerCredit {
+        uint32_t credits;
+        bool ready;         // Listed in ready_workers
+    };
+    
+    // One topic of a subscription batch, kept to undo the batch if a later topic fails
+    struct SubscriptionChange {
+        const std::string* topic;
+        bool sent;          // The change reached the socket
+    };
+    
+    // Newest unsent message of a topic, and the sequence number of the topic's
+    // entry in pending_order; entries with another number are stale
+    struct PendingMessage {
+        std::string message;
+        uint64_t sequence;
+    };
+    typedef std::pair<std::string, uint64_t> PendingEntry;
+    
     void* context;
     void* socket;
     std::atomic<bool> initialized;
     Config config;
     std::string endpoint_path;
+    TopicIndex topic_index;
+    LastValueCache last_values;
+    std::unordered_map<std::string, PendingMessage> pending;    // Newest unsent message per topic
+    std::deque<PendingEntry> pending_order;                     // Topics in first-blocked order
+    uint64_t pending_sequence;
+    size_t conflated_count;
+    std::unordered_map<std::string, WorkerCredit> worker_credits;   // Pusher: credit per worker id
+    std::deque<std::string> ready_workers;                          // Pusher: workers with credit, round-robin
+    std::unordered_map<std::string, uint32_t> consumed_counts;      // Worker: per pusher, messages not yet credited back
+    void* monitor;                                                  // Worker: connection events of the socket
     mutable std::mutex mutex;
+    std::thread service_thread;
+    std::condition_variable service_cv;
+    bool service_stop;
+    
+    // Credit mode runs the pipeline on ROUTER at both ends so credit can be addressed
+    bool UsesCredit() const {
+        return config.pattern == Pattern::PUSH_PULL && config.pipeline_credit > 0;
+    }
+    
+    bool ConfigureCreditSocket() {
+        if (config.mode == Mode::SERVER) {
+            // Fail sends to vanished workers instead of dropping them silently
+            int mandatory = 1;
+            zmq_setsockopt(socket, ZMQ_ROUTER_MANDATORY, &mandatory, sizeof(mandatory));
+#ifdef ZMQ_DISCONNECT_MSG
+            char gone[CREDIT_FRAME_SIZE];
+            EncodeCredit(gone, CREDIT_GONE, 0);
+            zmq_setsockopt(socket, ZMQ_DISCONNECT_MSG, gone, sizeof(gone));
+#endif
+            return true;
+        }
+        
+        // Name the pusher so credit can be addressed to it; the connection
+        // keeps its pipe, and so this name, across reconnects
+        if (zmq_setsockopt(socket, ZMQ_CONNECT_ROUTING_ID, PUSHER_ROUTING_ID,
+                           sizeof(PUSHER_ROUTING_ID) - 1) != 0) {
+            Log("Failed to name pusher: " + std::string(zmq_strerror(zmq_errno())));
+            return false;
+        }
+        
+        // Every (re)connection may reach a new pusher, which needs the full
+        // window; watch for them before connecting so none is missed
+        if (zmq_socket_monitor(socket, CREDIT_MONITOR_ENDPOINT, ZMQ_EVENT_CONNECTED) != 0) {
+            Log("Failed to monitor socket: " + std::string(zmq_strerror(zmq_errno())));
+            return false;
+        }
+        monitor = zmq_socket(context, ZMQ_PAIR);
+        if (!monitor || zmq_connect(monitor, CREDIT_MONITOR_ENDPOINT) != 0) {
+            Log("Failed to connect socket monitor: " + std::string(zmq_strerror(zmq_errno())));
+            return false;
+        }
+        return true;
+    }
+    
+    static void EncodeCredit(char* frame, char kind, uint32_t count) {
+        frame[0] = kind;
+        frame[1] = static_cast<char>((count >> 24) & 0xff);
+        frame[2] = static_cast<char>((count >> 16) & 0xff);
+        frame[3] = static_cast<char>((count >> 8) & 0xff);
+        frame[4] = static_cast<char>(count & 0xff);
+    }
+    
+    void SendCredit(const std::string& pusher, char kind, uint32_t count) {
+        char frame[CREDIT_FRAME_SIZE];
+        EncodeCredit(frame, kind, count);
+        if (zmq_send(socket, pusher.data(), pusher.size(), ZMQ_SNDMORE | ZMQ_DONTWAIT) < 0 ||
+            zmq_send(socket, frame, sizeof(frame), ZMQ_DONTWAIT) < 0) {
+            Log("Credit grant failed: " + std::string(zmq_strerror(zmq_errno())));
+        }
+    }
+    
+    // Grants the full window again on every (re)connection; the caller must hold the mutex
+    void ReadConnectionEvents() {
+        zmq_msg_t event;
+        zmq_msg_init(&event);
+        while (zmq_msg_recv(&event, monitor, ZMQ_DONTWAIT) >= 0) {
+            // An event is a 6-byte frame (16-bit event, 32-bit value) followed by the endpoint
+            bool connected = false;
+            if (zmq_msg_size(&event) == 6) {
+                uint16_t id;
+                std::memcpy(&id, zmq_msg_data(&event), sizeof(id));
+                connected = (id == ZMQ_EVENT_CONNECTED);
+            }
+            while (zmq_msg_more(&event) && zmq_msg_recv(&event, monitor, ZMQ_DONTWAIT) >= 0) {
+            }
+            
+            if (connected) {
+                // The new pusher starts from the hello, so earlier consumption is not owed to it
+                consumed_counts.clear();
+                SendCredit(PUSHER_ROUTING_ID, CREDIT_HELLO, static_cast<uint32_t>(config.pipeline_credit));
+            }
+        }
+        zmq_msg_close(&event);
+    }
+    
+    // Worker: receives the next task while answering connection events, waiting up
+    // to timeout_ms (forever if 0); the caller must hold the mutex
+    ErrorCode ReceiveTask(std::string& message) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.timeout_ms);
+        
+        while (true) {
+            long wait_ms = -1;
+            if (config.timeout_ms > 0) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+                if (remaining <= 0) {
+                    Log("Receive timeout");
+                    return ErrorCode::ERROR_TIMEOUT;
+                }
+                wait_ms = static_cast<long>(remaining);
+            }
+            
+            zmq_pollitem_t items[] = {{socket, 0, ZMQ_POLLIN, 0}, {monitor, 0, ZMQ_POLLIN, 0}};
+            if (zmq_poll(items, 2, wait_ms) < 0) {
+                Log("Receive failed: " + std::string(zmq_strerror(zmq_errno())));
+                return ErrorCode::ERROR_RECEIVE_FAILED;
+            }
+            if (items[1].revents & ZMQ_POLLIN) {
+                ReadConnectionEvents();
+            }
+            if (!(items[0].revents & ZMQ_POLLIN)) {
+                continue;
+            }
+            
+            // Tasks arrive as [pusher][task]
+            zmq_msg_t pusher;
+            zmq_msg_init(&pusher);
+            if (zmq_msg_recv(&pusher, socket, ZMQ_DONTWAIT) < 0 || !zmq_msg_more(&pusher)) {
+                zmq_msg_close(&pusher);
+                continue;
+            }
+            std::string pusher_id(static_cast<const char*>(zmq_msg_data(&pusher)), zmq_msg_size(&pusher));
+            zmq_msg_close(&pusher);
+            
+            ErrorCode result = ReceiveLocked(message);
+            if (result != ErrorCode::SUCCESS) {
+                return result;
+            }
+            
+            // Return credit to the task's pusher in batches of half the window
+            // to limit upstream traffic
+            uint32_t& consumed = consumed_counts[pusher_id];
+            if (++consumed >= static_cast<uint32_t>(std::max(1, config.pipeline_credit / 2))) {
+                SendCredit(pusher_id, CREDIT_GRANT, consumed);
+                consumed = 0;
+            }
+            return ErrorCode::SUCCESS;
+        }
+    }
+    
+    // Applies one credit frame received from a worker
+    void ApplyCredit(const std::string& worker, const unsigned char* frame, size_t size) {
+        if (size != CREDIT_FRAME_SIZE) {
+            Log("Ignoring malformed credit frame");
+            return;
+        }
+        
+        if (frame[0] == CREDIT_GONE) {
+            worker_credits.erase(worker);
+            return;
+        }
+        
+        uint32_t count = (static_cast<uint32_t>(frame[1]) << 24) | (static_cast<uint32_t>(frame[2]) << 16) |
+                         (static_cast<uint32_t>(frame[3]) << 8) | static_cast<uint32_t>(frame[4]);
+        WorkerCredit& state = worker_credits.emplace(worker, WorkerCredit{0, false}).first->second;
+        state.credits = (frame[0] == CREDIT_HELLO) ? count : state.credits + count;
+        
+        if (state.credits > 0 && !state.ready) {
+            state.ready = true;
+            ready_workers.push_back(worker);
+        }
+    }
+    
+    // Reads pending credit frames, waiting up to timeout_ms (-1 forever) for the first
+    void ReadCredits(long timeout_ms) {
+        zmq_pollitem_t item = {socket, 0, ZMQ_POLLIN, 0};
+        if (zmq_poll(&item, 1, timeout_ms) <= 0) {
+            return;
+        }
+        
+        zmq_msg_t worker;
+        zmq_msg_t frame;
+        zmq_msg_init(&worker);
+        zmq_msg_init(&frame);
+        while (zmq_msg_recv(&worker, socket, ZMQ_DONTWAIT) >= 0) {
+            if (!zmq_msg_more(&worker) || zmq_msg_recv(&frame, socket, ZMQ_DONTWAIT) < 0) {
+                continue;
+            }
+            ApplyCredit(std::string(static_cast<const char*>(zmq_msg_data(&worker)), zmq_msg_size(&worker)),
+                        static_cast<const unsigned char*>(zmq_msg_data(&frame)), zmq_msg_size(&frame));
+        }
+        zmq_msg_close(&frame);
+        zmq_msg_close(&worker);
+    }
+    
+    // Sends to the next worker with credit, round-robin; the caller must hold the mutex
+    ErrorCode SendWithCredit(const char* data, size_t size) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.timeout_ms);
+        ReadCredits(0);
+        
+        while (true) {
+            while (ready_workers.empty()) {
+                long wait_ms = -1;
+                if (config.timeout_ms > 0) {
+                    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now()).count();
+                    if (remaining <= 0) {
+                        Log("No worker credit available");
+                        return ErrorCode::ERROR_TIMEOUT;
+                    }
+                    wait_ms = static_cast<long>(remaining);
+                }
+                ReadCredits(wait_ms);
+            }
+            
+            std::string worker = ready_workers.front();
+            ready_workers.pop_front();
+            
+            auto it = worker_credits.find(worker);
+            if (it == worker_credits.end()) {
+                continue;   // Disconnected while queued
+            }
+            it->second.ready = false;
+            
+            if (zmq_send(socket, worker.data(), worker.size(), ZMQ_SNDMORE | ZMQ_DONTWAIT) < 0 ||
+                zmq_send(socket, data, size, ZMQ_DONTWAIT) < 0) {
+                int err = zmq_errno();
+                if (err == EHOSTUNREACH) {
+                    worker_credits.erase(it);
+                    continue;
+                }
+                if (err == EAGAIN) {
+                    continue;   // Pipe full despite credit; back in line with its next grant
+                }
+                Log("Send failed: " + std::string(zmq_strerror(err)));
+                return ErrorCode::ERROR_SEND_FAILED;
+            }
+            
+            if (--it->second.credits > 0) {
+                it->second.ready = true;
+                ready_workers.push_back(worker);
+            }
+            return ErrorCode::SUCCESS;
+        }
+    }
+    
+    // Publishers that need subscription notifications run on XPUB
+    bool UsesXPub() const {
+        return config.pattern == Pattern::PUB_SUB && config.mode == Mode::SERVER &&
+               (config.last_value_cache || config.conflate_topics);
+    }
+    
+    size_t TopicLength(const std::string& message) const {
+        return TopicLength(message.data(), message.size());
+    }
+    
+    size_t TopicLength(const char* data, size_t size) const {
+        const void* pos = std::memchr(data, config.topic_delimiter, size);
+        return pos ? static_cast<size_t>(static_cast<const char*>(pos) - data) : size;
+    }
+    
+    // Sends without blocking, conflating per topic while a subscriber is full;
+    // the caller must hold the mutex
+    bool Publish(const char* data, size_t size) {
+        std::string topic(data, TopicLength(data, size));
+        
+        bool sent = zmq_send(socket, data, size, ZMQ_DONTWAIT) >= 0;
+        
+        // Only a full subscriber is worth waiting for; anything else is an error
+        if (!sent && zmq_errno() != EAGAIN) {
+            Log("Send failed: " + std::string(zmq_strerror(zmq_errno())));
+            return false;
+        }
+        
+        // An older message of the topic is still waiting: the new one replaces
+        // it, or supersedes it if sent, so the topic is never reordered; the
+        // topic's pending_order entry goes stale once it is sent
+        auto it = pending.find(topic);
+        if (it != pending.end()) {
+            conflated_count++;
+            if (sent) {
+                pending.erase(it);
+            } else {
+                it->second.message.assign(data, size);
+            }
+            return true;
+        }
+        if (sent) {
+            return true;
+        }
+        
+        auto inserted = pending.emplace(std::move(topic),
+            PendingMessage{std::string(data, size), ++pending_sequence});
+        if (inserted.second) {
+            pending_order.emplace_back(inserted.first->first, pending_sequence);
+            CompactPendingOrder();
+        }
+        return true;
+    }
+    
+    bool IsStale(const PendingEntry& entry) const {
+        auto it = pending.find(entry.first);
+        return it == pending.end() || it->second.sequence != entry.second;
+    }
+    
+    // Drops stale entries once they outnumber the pending topics, so
+    // send-then-block cycles between flushes cannot grow the queue
+    void CompactPendingOrder() {
+        if (pending_order.size() <= 2 * pending.size()) {
+            return;
+        }
+        pending_order.erase(std::remove_if(pending_order.begin(), pending_order.end(),
+                                           [this](const PendingEntry& entry) {
+                                               return IsStale(entry);
+                                           }),
+                            pending_order.end());
+    }
+    
+    // Tries every pending topic once, oldest first; returns true once none are left
+    bool FlushPending() {
+        for (size_t count = pending_order.size(); count > 0; count--) {
+            PendingEntry entry = std::move(pending_order.front());
+            pending_order.pop_front();
+            
+            // Sent by Publish() since, and maybe blocked and queued again
+            if (IsStale(entry)) {
+                continue;
+            }
+            auto it = pending.find(entry.first);
+            const std::string& message = it->second.message;
+            if (zmq_send(socket, message.data(), message.size(), ZMQ_DONTWAIT) < 0) {
+                pending_order.push_back(std::move(entry));
+                continue;
+            }
+            pending.erase(it);
+        }
+        
+        if (!pending.empty()) {
+            return false;
+        }
+        pending_order.clear();
+        if (conflated_count > 0) {
+            Log("Subscribers caught up, " + std::to_string(conflated_count) +
+                " stale messages were conflated");
+            conflated_count = 0;
+        }
+        return true;
+    }
+    
+    // Handles XPUB subscription notifications until StopServiceThread()
+    void ServiceLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!service_stop) {
+            DrainSubscriptions();
+            FlushPending();
+            service_cv.wait_for(lock, std::chrono::milliseconds(SERVICE_INTERVAL_MS),
+                                [this] { return service_stop; });
+        }
+    }
+    
+    void StopServiceThread() {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            service_stop = true;
+            thread.swap(service_thread);
+        }
+        service_cv.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    
+    // Reads pending subscription notifications; the caller must hold the mutex
+    void DrainSubscriptions() {
+        if (!socket) {
+            return;
+        }
+        
+        zmq_msg_t notification;
+        zmq_msg_init(&notification);
+        while (zmq_msg_recv(&notification, socket, ZMQ_DONTWAIT) >= 0) {
+            const char* data = static_cast<const char*>(zmq_msg_data(&notification));
+            size_t size = zmq_msg_size(&notification);
+            
+            // First byte is 1 for subscribe and 0 for unsubscribe
+            if (size == 0 || (data[0] != 0 && data[0] != 1) || !config.last_value_cache) {
+                continue;
+            }
+            
+            // In manual mode the subscription of the notification's sender
+            // only takes effect once it is set on the socket
+            int option = data[0] == 1 ? ZMQ_SUBSCRIBE : ZMQ_UNSUBSCRIBE;
+            zmq_setsockopt(socket, option, data + 1, size - 1);
+            if (data[0] == 1) {
+                ReplayLastValues(std::string(data + 1, size - 1));
+            }
+        }
+        zmq_msg_close(&notification);
+    }
+    
+    // Sends the cached value of every topic matching a new subscription to the
+    // subscriber that sent it, as one multipart message so the whole replay
+    // is addressed to that subscriber; the caller must hold the mutex and have
+    // just set the subscription on the socket
+    void ReplayLastValues(const std::string& prefix) {
+        std::vector<std::pair<const char*, size_t>> values;
+        bool complete = last_values.ForEachMatching(prefix, config.topic_delimiter,
+            LVC_MAX_REPLAY_SCAN, [&](const char* data, size_t size) {
+                // A pending topic reaches the subscriber when it is flushed
+                if (!pending.empty() &&
+                    pending.count(std::string(data, TopicLength(data, size))) > 0) {
+                    return true;
+                }
+                values.emplace_back(data, size);
+                return values.size() < LVC_MAX_REPLAY_VALUES;
+            });
+        if (values.empty()) {
+            return;
+        }
+        
+        // Address the next message to the subscriber, and fail it rather than
+        // drop it if the subscriber is full
+        SetSocketOption(ZMQ_XPUB_MANUAL_LAST_VALUE, 1);
+        if (!config.conflate_topics) {
+            SetSocketOption(ZMQ_XPUB_NODROP, 1);
+        }
+        
+        size_t replayed = 0;
+        for (size_t i = 0; i < values.size(); i++) {
+            int flags = ZMQ_DONTWAIT | (i + 1 < values.size() ? ZMQ_SNDMORE : 0);
+            if (zmq_send(socket, values[i].first, values[i].second, flags) < 0) {
+                Log("Replay failed: " + std::string(zmq_strerror(zmq_errno())));
+                break;
+            }
+            replayed++;
+        }
+        
+        // Back to sending every message to all matching subscribers
+        if (!config.conflate_topics) {
+            SetSocketOption(ZMQ_XPUB_NODROP, 0);
+        }
+        SetSocketOption(ZMQ_XPUB_MANUAL_LAST_VALUE, 0);
+        SetSocketOption(ZMQ_XPUB_MANUAL, 1);
+        
+        Log("Replayed " + std::to_string(replayed) + " cached values for topic: " +
+            (prefix.empty() ? "<all>" : prefix) + (complete ? "" : " (replay limit reached)"));
+    }
+    
+    void SetSocketOption(int option, int value) {
+        zmq_setsockopt(socket, option, &value, sizeof(value));
+    }
+    
+    ErrorCode CheckSubscriber() const {
+        if (!initialized || !socket) {
+            return ErrorCode::ERROR_NOT_INITIALIZED;
+        }
+        
+        if (config.pattern != Pattern::PUB_SUB || config.mode != Mode::CLIENT) {
+            Log("Subscriptions only valid for PUB/SUB client");
+            return ErrorCode::ERROR_INVALID_PATTERN;
+        }
+        return ErrorCode::SUCCESS;
+    }
+    
+    // Undoes the applied part of a failed SubscribeBatch(), newest first
+    void RollbackSubscribe(const std::vector<SubscriptionChange>& changes) {
+        for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+            bool last = false;
+            topic_index.RemoveSubscription(*it->topic, last);
+            if (it->sent) {
+                zmq_setsockopt(socket, ZMQ_UNSUBSCRIBE, it->topic->c_str(), it->topic->length());
+            }
+        }
+    }
+    
+    // Undoes the applied part of a failed UnsubscribeBatch(), newest first
+    void RollbackUnsubscribe(const std::vector<SubscriptionChange>& changes) {
+        for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+            topic_index.AddSubscription(*it->topic);
+            if (it->sent) {
+                zmq_setsockopt(socket, ZMQ_SUBSCRIBE, it->topic->c_str(), it->topic->length());
+            }
+        }
+    }
+    
+    // Receives one message; the caller must hold the mutex
+    ErrorCode ReceiveLocked(std::string& message) {
+        // Create a message object
+        zmq_msg_t zmq_msg;
+        if (zmq_msg_init(&zmq_msg) != 0) {
+            Log("Failed to initialize message");
+            return ErrorCode::ERROR_RECEIVE_FAILED;
+        }
+        
+        // Receive message
+        int nbytes = zmq_msg_recv(&zmq_msg, socket, 0);
+        if (nbytes < 0) {
+            int err = zmq_errno();
+            zmq_msg_close(&zmq_msg);
+            
+            if (err == EAGAIN || err == ETIMEDOUT) {
+                Log("Receive timeout");
+                return ErrorCode::ERROR_TIMEOUT;
+            }
+            
+            Log("Receive failed: " + std::string(zmq_strerror(err)));
+            return ErrorCode::ERROR_RECEIVE_FAILED;
+        }
+        
+        // Extract data
+        size_t size = zmq_msg_size(&zmq_msg);
+        if (size > MAX_MESSAGE_SIZE) {
+            zmq_msg_close(&zmq_msg);
+            Log("Received message too large: " + std::to_string(size) + " bytes");
+            return ErrorCode::ERROR_MESSAGE_TOO_LARGE;
+        }
+        
+        const char* data = static_cast<const char*>(zmq_msg_data(&zmq_msg));
+        message.assign(data, size);
+        
+        zmq_msg_close(&zmq_msg);
+        
+        Log("Received message: " + std::to_string(size) + " bytes");
+        return ErrorCode::SUCCESS;
+    }
     
     int GetSocketType(Pattern pattern, Mode mode) const {
         switch (pattern) {
             case Pattern::REQ_REP:
                 return (mode == Mode::SERVER) ? ZMQ_REP : ZMQ_REQ;
             case Pattern::PUB_SUB:
-                return (mode == Mode::SERVER) ? ZMQ_PUB : ZMQ_SUB;
+                if (mode == Mode::SERVER) {
+                    return UsesXPub() ? ZMQ_XPUB : ZMQ_PUB;
+                }
+                return ZMQ_SUB;
             case Pattern::PUSH_PULL:
+                if (UsesCredit()) {
+                    return ZMQ_ROUTER;
+                }
                 return (mode == Mode::SERVER) ? ZMQ_PUSH : ZMQ_PULL;
             default:
                 return -1;
@@ -314,6 +1440,13 @@ private:
     }
     
     void CleanupSocket() {
+        if (monitor) {
+            zmq_socket_monitor(socket, nullptr, 0);
+            int linger = 0;
+            zmq_setsockopt(monitor, ZMQ_LINGER, &linger, sizeof(linger));
+            zmq_close(monitor);
+            monitor = nullptr;
+        }
         if (socket) {
             zmq_close(socket);
             socket = nullptr;
@@ -342,6 +1475,14 @@ private:
 #endif
         
         CleanupSocket();
+        topic_index.Clear();
+        last_values.Clear();
+        pending.clear();
+        pending_order.clear();
+        conflated_count = 0;
+        worker_credits.clear();
+        ready_workers.clear();
+        consumed_counts.clear();
         initialized = false;
         
         Log("Cleanup complete");
@@ -389,6 +1530,26 @@ ErrorCode ZMQWrapper::Subscribe(const std::string& topic) {
     return pImpl->Subscribe(topic);
 }
 
+ErrorCode ZMQWrapper::SubscribeBatch(const std::vector<std::string>& topics) {
+    return pImpl->SubscribeBatch(topics);
+}
+
+ErrorCode ZMQWrapper::Unsubscribe(const std::string& topic) {
+    return pImpl->Unsubscribe(topic);
+}
+
+ErrorCode ZMQWrapper::UnsubscribeBatch(const std::vector<std::string>& topics) {
+    return pImpl->UnsubscribeBatch(topics);
+}
+
+ErrorCode ZMQWrapper::SetTopicHandler(const std::string& topic, TopicHandler handler) {
+    return pImpl->SetTopicHandler(topic, std::move(handler));
+}
+
+ErrorCode ZMQWrapper::DispatchMessage() {
+    return pImpl->DispatchMessage();
+}
+
 std::string ZMQWrapper::GetErrorMessage(ErrorCode code) {
     switch (code) {
         case ErrorCode::SUCCESS:
@@ -4,8 +4,10 @@
 #include <thread>
 #include <chrono>
 #include <vector>
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <memory>
 
 using namespace prj1;
 
@@ -515,6 +517,468 @@ TEST(test_custom_endpoint) {
     wrapper.Close();
 }
 
+// Test 13: Bulk subscribe/unsubscribe with per-topic dispatch
+TEST(test_bulk_subscribe_dispatch) {
+    std::atomic<bool> server_ready(false);
+    std::atomic<bool> server_stop(false);
+    
+    std::thread server_thread([&]() {
+        ZMQWrapper server;
+        Config config;
+        config.pattern = Pattern::PUB_SUB;
+        config.mode = Mode::SERVER;
+        config.timeout_ms = 1000;
+        config.enable_logging = false;
+        config.endpoint = "ipc:///tmp/test_topics.sock";
+        
+        if (server.Init(config) == ErrorCode::SUCCESS) {
+            server_ready = true;
+            for (int i = 0; !server_stop; i++) {
+                server.SendMessage("AAPL:" + std::to_string(i));
+                server.SendMessage("MSFT:" + std::to_string(i));
+                server.SendMessage("GOOG:" + std::to_string(i));
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        server.Close();
+    });
+    
+    while (!server_ready) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    ZMQWrapper client;
+    Config config;
+    config.pattern = Pattern::PUB_SUB;
+    config.mode = Mode::CLIENT;
+    config.timeout_ms = 2000;
+    config.enable_logging = false;
+    config.endpoint = "ipc:///tmp/test_topics.sock";
+    
+    ErrorCode result = client.Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Client init should succeed");
+    
+    result = client.SubscribeBatch({"AAPL", "MSFT", "AAPL"});
+    ASSERT(result == ErrorCode::SUCCESS, "Bulk subscribe should succeed");
+    
+    int aapl_count = 0;
+    int msft_count = 0;
+    int other_count = 0;
+    client.SetTopicHandler("AAPL", [&](const std::string& topic, const std::string& message) {
+        ASSERT(topic == "AAPL", "Handler should receive the matched topic");
+        ASSERT(message.compare(0, 5, "AAPL:") == 0, "Handler should receive the full message");
+        aapl_count++;
+    });
+    client.SetTopicHandler("MSFT", [&](const std::string&, const std::string&) {
+        msft_count++;
+    });
+    client.SetTopicHandler("", [&](const std::string&, const std::string&) {
+        other_count++;
+    });
+    
+    for (int i = 0; i < 20; i++) {
+        result = client.DispatchMessage();
+        ASSERT(result == ErrorCode::SUCCESS, "Dispatch should succeed");
+    }
+    ASSERT(aapl_count > 0 && msft_count > 0, "Both subscribed topics should be dispatched");
+    ASSERT(other_count == 0, "Unsubscribed topics should not be received");
+    
+    // AAPL was subscribed twice, so one unsubscribe keeps it flowing
+    result = client.Unsubscribe("AAPL");
+    ASSERT(result == ErrorCode::SUCCESS, "Unsubscribe should succeed");
+    
+    aapl_count = 0;
+    for (int i = 0; i < 20; i++) {
+        result = client.DispatchMessage();
+        ASSERT(result == ErrorCode::SUCCESS, "Dispatch should succeed");
+    }
+    ASSERT(aapl_count > 0, "Topic with a remaining subscription should still be dispatched");
+    
+    // Queued AAPL messages are filtered on receive once the last subscription is gone
+    result = client.UnsubscribeBatch({"AAPL", "GOOG"});
+    ASSERT(result == ErrorCode::SUCCESS, "Bulk unsubscribe should succeed");
+    
+    aapl_count = 0;
+    msft_count = 0;
+    for (int i = 0; i < 10; i++) {
+        result = client.DispatchMessage();
+        ASSERT(result == ErrorCode::SUCCESS, "Dispatch should succeed");
+    }
+    ASSERT(aapl_count == 0, "Unsubscribed topic should no longer be dispatched");
+    ASSERT(msft_count == 10, "Remaining subscription should still be dispatched");
+    
+    client.Close();
+    server_stop = true;
+    server_thread.join();
+}
+
+// Test 14: Subscription management is rejected outside PUB/SUB clients
+TEST(test_subscribe_invalid_pattern) {
+    ZMQWrapper wrapper;
+    
+    ErrorCode result = wrapper.SubscribeBatch({"topic"});
+    ASSERT(result == ErrorCode::ERROR_NOT_INITIALIZED, 
+           "Bulk subscribe without init should fail");
+    
+    Config config;
+    config.pattern = Pattern::PUSH_PULL;
+    config.mode = Mode::CLIENT;
+    config.timeout_ms = 100;
+    config.enable_logging = false;
+    config.endpoint = "ipc:///tmp/test_invalid_sub.sock";
+    
+    result = wrapper.Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Init should succeed");
+    
+    result = wrapper.Unsubscribe("topic");
+    ASSERT(result == ErrorCode::ERROR_INVALID_PATTERN, 
+           "Unsubscribe should fail for non-subscriber");
+    
+    result = wrapper.SetTopicHandler("topic", [](const std::string&, const std::string&) {});
+    ASSERT(result == ErrorCode::ERROR_INVALID_PATTERN, 
+           "Topic handlers should fail for non-subscriber");
+    
+    wrapper.Close();
+}
+
+// Test 15: Last-value cache replays state to late-joining subscribers
+TEST(test_last_value_cache) {
+    std::atomic<bool> server_ready(false);
+    std::atomic<bool> publish_update(false);
+    std::atomic<bool> server_stop(false);
+    
+    std::thread server_thread([&]() {
+        ZMQWrapper server;
+        Config config;
+        config.pattern = Pattern::PUB_SUB;
+        config.mode = Mode::SERVER;
+        config.timeout_ms = 1000;
+        config.enable_logging = false;
+        config.last_value_cache = true;
+        config.endpoint = "ipc:///tmp/test_lvc.sock";
+        
+        if (server.Init(config) == ErrorCode::SUCCESS) {
+            // Published before any subscriber exists
+            server.SendMessage("AAPL:1");
+            server.SendMessage("MSFT:2");
+            server.SendMessage("AAPL:3");
+            server.SendMessage("AAPL.OQ:4");
+            server_ready = true;
+            
+            while (!server_stop) {
+                if (publish_update.exchange(false)) {
+                    server.SendMessage("MSFT:5");
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        server.Close();
+    });
+    
+    while (!server_ready) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    ZMQWrapper client;
+    Config config;
+    config.pattern = Pattern::PUB_SUB;
+    config.mode = Mode::CLIENT;
+    config.timeout_ms = 2000;
+    config.enable_logging = false;
+    config.endpoint = "ipc:///tmp/test_lvc.sock";
+    
+    ErrorCode result = client.Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Client init should succeed");
+    
+    // Exact topic: only the latest AAPL value is replayed
+    result = client.Subscribe("AAPL:");
+    ASSERT(result == ErrorCode::SUCCESS, "Subscribe should succeed");
+    
+    std::string message;
+    result = client.ReceiveMessage(message);
+    ASSERT(result == ErrorCode::SUCCESS, "Late joiner should receive cached value");
+    ASSERT(message == "AAPL:3", "Cached value should be the latest for the topic");
+    
+    // Prefix: every topic starting with it is replayed
+    result = client.Subscribe("MSFT");
+    ASSERT(result == ErrorCode::SUCCESS, "Subscribe should succeed");
+    
+    result = client.ReceiveMessage(message);
+    ASSERT(result == ErrorCode::SUCCESS, "Prefix subscription should receive cached value");
+    ASSERT(message == "MSFT:2", "Cached value should match the prefix");
+    
+    // A second subscriber gets every cached topic under its prefix
+    ZMQWrapper late_client;
+    result = late_client.Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Second client init should succeed");
+    result = late_client.Subscribe("AAPL");
+    ASSERT(result == ErrorCode::SUCCESS, "Subscribe should succeed");
+    
+    std::vector<std::string> replayed(2);
+    for (std::string& value : replayed) {
+        result = late_client.ReceiveMessage(value);
+        ASSERT(result == ErrorCode::SUCCESS, "Second client should receive cached values");
+    }
+    std::sort(replayed.begin(), replayed.end());
+    ASSERT(replayed[0] == "AAPL.OQ:4" && replayed[1] == "AAPL:3",
+           "Every topic matching the prefix should be replayed");
+    
+    // The replay went to the new subscriber only: the first client's next
+    // message is the live update, not a repeat of the cached AAPL value
+    publish_update = true;
+    result = client.ReceiveMessage(message);
+    ASSERT(result == ErrorCode::SUCCESS, "Live update should arrive");
+    ASSERT(message == "MSFT:5", "Existing subscribers should not get replays");
+    
+    late_client.Close();
+    client.Close();
+    server_stop = true;
+    server_thread.join();
+}
+
+// Test 16: Conflation keeps slow subscribers on the newest value per topic
+TEST(test_conflate_topics) {
+    const int update_count = 5000;
+    std::atomic<bool> server_ready(false);
+    std::atomic<bool> client_subscribed(false);
+    std::atomic<bool> published(false);
+    std::atomic<bool> server_stop(false);
+    
+    std::thread server_thread([&]() {
+        ZMQWrapper server;
+        Config config;
+        config.pattern = Pattern::PUB_SUB;
+        config.mode = Mode::SERVER;
+        config.timeout_ms = 1000;
+        config.enable_logging = false;
+        config.conflate_topics = true;
+        config.send_hwm = 10;
+        config.endpoint = "ipc:///tmp/test_conflate.sock";
+        
+        if (server.Init(config) == ErrorCode::SUCCESS) {
+            server_ready = true;
+            
+            // Publish until the client has seen a message, so its subscription is active
+            while (!client_subscribed) {
+                server.SendMessage("SYNC");
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            
+            // The client does not read until everything is published, and
+            // 10 MB is more than its pipes and the socket buffers can hold
+            const std::string payload(1024, 'x');
+            for (int i = 0; i < update_count; i++) {
+                server.SendMessage("AAPL:" + std::to_string(i) + ":" + payload);
+                server.SendMessage("MSFT:" + std::to_string(i) + ":" + payload);
+            }
+            published = true;
+            
+            while (!server_stop) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        server.Close();
+    });
+    
+    while (!server_ready) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    ZMQWrapper client;
+    Config config;
+    config.pattern = Pattern::PUB_SUB;
+    config.mode = Mode::CLIENT;
+    config.timeout_ms = 2000;
+    config.enable_logging = false;
+    config.endpoint = "ipc:///tmp/test_conflate.sock";
+    
+    ErrorCode result = client.Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Client init should succeed");
+    
+    result = client.Subscribe("");
+    ASSERT(result == ErrorCode::SUCCESS, "Subscribe should succeed");
+    
+    std::string message;
+    do {
+        result = client.ReceiveMessage(message);
+        ASSERT(result == ErrorCode::SUCCESS, "Sync message should arrive");
+    } while (message != "SYNC");
+    client_subscribed = true;
+    
+    while (!published) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    const std::string final_index = std::to_string(update_count - 1);
+    int received_count = 0;
+    std::string last_aapl;
+    std::string last_msft;
+    while (last_aapl != "AAPL:" + final_index || last_msft != "MSFT:" + final_index) {
+        result = client.ReceiveMessage(message);
+        ASSERT(result == ErrorCode::SUCCESS, "Newest values should be delivered");
+        received_count++;
+        if (message.compare(0, 5, "AAPL:") == 0) {
+            last_aapl = message.substr(0, message.rfind(':'));
+        } else if (message.compare(0, 5, "MSFT:") == 0) {
+            last_msft = message.substr(0, message.rfind(':'));
+        }
+    }
+    ASSERT(received_count < 2 * update_count, "Stale updates should have been conflated");
+    
+    client.Close();
+    server_stop = true;
+    server_thread.join();
+}
+
+// Test 17: Credit-based PUSH/PULL favours workers with free capacity
+TEST(test_pipeline_credit) {
+    const int task_count = 40;
+    std::atomic<bool> server_ready(false);
+    std::atomic<int> sent_count(0);
+    std::atomic<int> total_received(0);
+    std::atomic<int> slow_received(0);
+    
+    std::thread server_thread([&]() {
+        ZMQWrapper server;
+        Config config;
+        config.pattern = Pattern::PUSH_PULL;
+        config.mode = Mode::SERVER;
+        config.timeout_ms = 2000;
+        config.enable_logging = false;
+        config.pipeline_credit = 1;
+        config.endpoint = "ipc:///tmp/test_credit.sock";
+        
+        if (server.Init(config) == ErrorCode::SUCCESS) {
+            server_ready = true;
+            for (int i = 0; i < task_count; i++) {
+                if (server.SendMessage("Task #" + std::to_string(i)) == ErrorCode::SUCCESS) {
+                    sent_count++;
+                }
+            }
+            while (total_received < sent_count) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        server.Close();
+    });
+    
+    while (!server_ready) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    // The slow worker takes one task and then stalls until every task is sent,
+    // so it can only hold that task and the one its credit grant allowed
+    auto run_worker = [&](int credit, std::atomic<int>* own_count) {
+        ZMQWrapper worker;
+        Config config;
+        config.pattern = Pattern::PUSH_PULL;
+        config.mode = Mode::CLIENT;
+        config.timeout_ms = 500;
+        config.enable_logging = false;
+        config.pipeline_credit = credit;
+        config.endpoint = "ipc:///tmp/test_credit.sock";
+        
+        if (worker.Init(config) == ErrorCode::SUCCESS) {
+            while (total_received < task_count) {
+                std::string task;
+                if (worker.ReceiveMessage(task) != ErrorCode::SUCCESS) {
+                    continue;
+                }
+                total_received++;
+                if (own_count && (*own_count)++ == 0) {
+                    while (sent_count < task_count) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                }
+            }
+        }
+        worker.Close();
+    };
+    
+    std::thread slow_worker(run_worker, 1, &slow_received);
+    std::thread fast_worker(run_worker, 4, nullptr);
+    
+    slow_worker.join();
+    fast_worker.join();
+    server_thread.join();
+    
+    ASSERT(sent_count == task_count, "All tasks should be sent within the credit timeout");
+    ASSERT(total_received == task_count, "All tasks should be received");
+    ASSERT(slow_received <= 2, "Stalled worker should only get tasks it has credit for");
+}
+
+// Test 18: Credit-based PUSH times out without worker credit
+TEST(test_pipeline_credit_timeout) {
+    ZMQWrapper server;
+    Config config;
+    config.pattern = Pattern::PUSH_PULL;
+    config.mode = Mode::SERVER;
+    config.timeout_ms = 200;
+    config.enable_logging = false;
+    config.pipeline_credit = 1;
+    config.endpoint = "ipc:///tmp/test_credit_timeout.sock";
+    
+    ErrorCode result = server.Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Init should succeed");
+    
+    result = server.SendMessage("Task");
+    ASSERT(result == ErrorCode::ERROR_TIMEOUT, "Send without credit should time out");
+    
+    server.Close();
+}
+
+// Test 19: A credit-mode worker grants its window again to a restarted pusher
+TEST(test_pipeline_credit_reconnect) {
+    std::atomic<int> received(0);
+    
+    Config config;
+    config.pattern = Pattern::PUSH_PULL;
+    config.mode = Mode::SERVER;
+    config.timeout_ms = 2000;
+    config.enable_logging = false;
+    config.pipeline_credit = 2;
+    config.endpoint = "ipc:///tmp/test_credit_reconnect.sock";
+    
+    std::unique_ptr<ZMQWrapper> pusher(new ZMQWrapper());
+    ErrorCode result = pusher->Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Pusher init should succeed");
+    
+    std::thread worker_thread([&]() {
+        ZMQWrapper worker;
+        Config worker_config = config;
+        worker_config.mode = Mode::CLIENT;
+        worker_config.timeout_ms = 500;
+        
+        if (worker.Init(worker_config) == ErrorCode::SUCCESS) {
+            for (int attempt = 0; attempt < 20 && received < 2; attempt++) {
+                std::string task;
+                if (worker.ReceiveMessage(task) == ErrorCode::SUCCESS) {
+                    received++;
+                }
+            }
+        }
+        worker.Close();
+    });
+    
+    result = pusher->SendMessage("First");
+    ASSERT(result == ErrorCode::SUCCESS, "First pusher should get credit");
+    for (int i = 0; i < 200 && received < 1; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT(received == 1, "Worker should receive the first task");
+    
+    // A new pusher on the same endpoint only gets credit from the re-sent hello
+    pusher.reset(new ZMQWrapper());
+    result = pusher->Init(config);
+    ASSERT(result == ErrorCode::SUCCESS, "Restarted pusher init should succeed");
+    result = pusher->SendMessage("Second");
+    ASSERT(result == ErrorCode::SUCCESS, "Restarted pusher should get credit");
+    
+    worker_thread.join();
+    pusher.reset();
+    ASSERT(received == 2, "Worker should receive tasks from the restarted pusher");
+}
+
 int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "  prj1 Comprehensive Test Suite" << std::endl;